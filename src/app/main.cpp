@@ -1,7 +1,11 @@
 #include <tclap/CmdLine.h>
 #include <iostream>
+#include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <memory>
+#include <string>
+#include <vector>
 
 // Include project headers
 #include "calculators/CalculatorFactory.hpp"
@@ -9,14 +13,25 @@
 #include "directory-tree-builders/DirectoryConstructor.hpp"
 #include "directory-tree-builders/LinkFollowBuilder.hpp"
 #include "directory-tree-builders/NonFollowLinkBuilder.hpp"
+#include "directory-tree-builders/LazyBuilder.hpp"
 #include "directory-tree-builders/CycleDetector.hpp"
+#include "directory-tree-builders/EntryFilter.hpp"
+#include "directory-tree-builders/FileTableConstructor.hpp"
+#include "directory-tree-builders/TreeSnapshot.hpp"
 #include "directory-iteration-visitors/HashStreamWriter.hpp"
 #include "directory-iteration-visitors/VerificationVisitor.hpp"
 #include "directory-iteration-visitors/ReportWriter.hpp"
+#include "directory-iteration-visitors/FileCollector.hpp"
+#include "hashing-engine/ReadAheadPrefetcher.hpp"
+#include "hashing-engine/HashEngine.hpp"
+#include "hashing-engine/SchedulingStrategyFactory.hpp"
+#include "hashing-engine/StreamingHasher.hpp"
+#include "archive-readers/TarConstructor.hpp"
 #include "utils/ChecksumFileReader.hpp"
 #include "utils/VerificationResultPrinter.hpp"
 #include "file-system-composite/Directory.hpp"
 #include "file-system-composite/File.hpp"
+#include "file-system-composite/FileTable.hpp"
 #include "progress-indicator-observers/ProgressReporter.hpp"
 
 // Helper function to calculate total size of directory tree
@@ -25,17 +40,42 @@ std::uint64_t calculateTotalSize(Directory* root) {
     return static_cast<std::uint64_t>(root->getSize());
 }
 
+// Helper function to read one root path per line of a job file; blank lines and '#' comments are skipped
+bool readJobFile(const std::string& job_file, std::vector<std::string>& roots) {
+    std::ifstream in(job_file);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        roots.push_back(line);
+    }
+    return true;
+}
+
 int main(int argc, char** argv) {
     try {
         // Create command line object
         TCLAP::CmdLine cmd("Checksum calculator - Calculate and verify file checksums", ' ', "0.1");
         
         // Add command line arguments
-        TCLAP::ValueArg<std::string> path_arg("p", "path", 
-            "Target file or directory to analyze (default: current directory)", 
-            false, ".", "path");
+        TCLAP::MultiArg<std::string> path_arg("p", "path", 
+            "Target file or directory to analyze (default: current directory); "
+            "repeat to analyze several roots in one run", 
+            false, "path");
         cmd.add(path_arg);
         
+        TCLAP::ValueArg<std::string> job_file_arg("", "job-file", 
+            "File listing one target path per line, analyzed in addition to any --path", 
+            false, "", "file");
+        cmd.add(job_file_arg);
+        
         TCLAP::ValueArg<std::string> algorithm_arg("a", "algorithm", 
             "Checksum algorithm to use (md5, sha1, sha256)", 
             false, "md5", "algorithm");
@@ -59,22 +99,180 @@ int main(int argc, char** argv) {
             "Display a report of files to be traversed and their sizes", 
             cmd, false);
         
+        TCLAP::ValueArg<unsigned> prefetch_arg("", "prefetch", 
+            "Maximum number of upcoming files to prefetch while hashing (0 disables)", 
+            false, 16, "count");
+        cmd.add(prefetch_arg);
+        
+        TCLAP::ValueArg<unsigned> jobs_arg("j", "jobs", 
+            "Number of worker threads used for hashing (default: 1)", 
+            false, 1, "count");
+        cmd.add(jobs_arg);
+        
+        TCLAP::ValueArg<unsigned> traverse_jobs_arg("", "traverse-jobs", 
+            "Number of threads listing directories while building the tree (default: 1)", 
+            false, 1, "count");
+        cmd.add(traverse_jobs_arg);
+        
+        TCLAP::ValueArg<std::string> schedule_arg("", "schedule", 
+            "Order in which worker threads hash files (name, cache-first, largest-first)", 
+            false, "name", "strategy");
+        cmd.add(schedule_arg);
+        
+        TCLAP::SwitchArg stream_arg("s", "stream", 
+            "Hash files while the directory is traversed, without building the whole tree first "
+            "(symbolic links are not followed, no progress is shown)", 
+            cmd, false);
+        
+        TCLAP::SwitchArg compact_arg("", "compact", 
+            "Keep the tree in a compact table instead of one object per entry, for very large trees "
+            "(symbolic links are not followed, files are hashed by a single thread)", 
+            cmd, false);
+        
+        TCLAP::SwitchArg lazy_arg("", "lazy", 
+            "List each directory only when it is reached while hashing or verifying, "
+            "so output starts at once (no progress is shown, no files are prefetched)", 
+            cmd, false);
+        
+        TCLAP::SwitchArg tar_arg("t", "tar", 
+            "Treat the target as a tar archive (optionally gzip-compressed, '-' for stdin) "
+            "and hash its members without extracting them", 
+            cmd, false);
+        
+        TCLAP::ValueArg<std::string> files_from_arg("", "files-from", 
+            "Hash the files listed in this file ('-' for stdin), separated by NUL or newline characters, "
+            "instead of traversing a target path", 
+            false, "", "list");
+        cmd.add(files_from_arg);
+        
+        TCLAP::MultiArg<std::string> exclude_arg("x", "exclude", 
+            "Skip files, directories and links matching a glob; a glob without '/' matches names, "
+            "one with '/' paths relative to the target (repeatable)", 
+            false, "glob");
+        cmd.add(exclude_arg);
+        
+        TCLAP::MultiArg<std::string> exclude_regex_arg("", "exclude-regex", 
+            "Skip entries whose path relative to the target matches a regular expression (repeatable)", 
+            false, "regex");
+        cmd.add(exclude_regex_arg);
+        
+        TCLAP::MultiArg<std::string> include_arg("i", "include", 
+            "Only hash files matching one of these globs (repeatable)", 
+            false, "glob");
+        cmd.add(include_arg);
+        
+        TCLAP::ValueArg<std::string> max_size_arg("", "max-size", 
+            "Skip files larger than this size (bytes, or with a K, M, G or T suffix)", 
+            false, "", "size");
+        cmd.add(max_size_arg);
+        
+        TCLAP::ValueArg<std::string> newer_than_arg("", "newer-than", 
+            "Skip files last modified before this local time (YYYY-MM-DD [HH:MM[:SS]])", 
+            false, "", "time");
+        cmd.add(newer_than_arg);
+        
+        TCLAP::ValueArg<std::string> snapshot_arg("", "snapshot", 
+            "Load the tree from this snapshot if nothing changed since it was saved, "
+            "otherwise traverse and save it there", 
+            false, "", "file");
+        cmd.add(snapshot_arg);
+        
         // Parse command line
         cmd.parse(argc, argv);
         
         // Get values
-        std::string target_path = path_arg.getValue();
+        std::vector<std::string> target_paths = path_arg.getValue();
         std::string algorithm = algorithm_arg.getValue();
         std::string checksums_file = checksums_arg.getValue();
         std::string output_format = format_arg.getValue();
         bool follow_symbolic_links = follow_links_arg.getValue();
         bool show_report = report_arg.getValue();
+        bool read_tar = tar_arg.getValue();
+        bool stream = stream_arg.getValue();
+        bool compact = compact_arg.getValue();
+        bool lazy = lazy_arg.getValue();
+        unsigned prefetch_window = prefetch_arg.getValue();
+        unsigned jobs = jobs_arg.getValue();
+        unsigned traverse_jobs = traverse_jobs_arg.getValue();
+        std::string schedule = schedule_arg.getValue();
         
-        // Validate arguments
-        if (!std::filesystem::exists(target_path)) {
-            std::cerr << "Error: Target path '" << target_path << "' does not exist." << std::endl;
+        // Compile the filters before anything is traversed
+        EntryFilter filter;
+        try {
+            for (const auto& glob : exclude_arg.getValue()) {
+                filter.exclude(glob);
+            }
+            for (const auto& glob : include_arg.getValue()) {
+                filter.include(glob);
+            }
+            for (const auto& expression : exclude_regex_arg.getValue()) {
+                filter.excludeRegex(expression);
+            }
+        } catch (const std::regex_error& e) {
+            std::cerr << "Error: Invalid regular expression: " << e.what() << std::endl;
             return 1;
         }
+        if (max_size_arg.isSet()) {
+            auto bytes = EntryFilter::parseSize(max_size_arg.getValue());
+            if (!bytes) {
+                std::cerr << "Error: Invalid size '" << max_size_arg.getValue() << "'." << std::endl;
+                return 1;
+            }
+            filter.maxSize(*bytes);
+        }
+        if (newer_than_arg.isSet()) {
+            auto seconds = EntryFilter::parseTime(newer_than_arg.getValue());
+            if (!seconds) {
+                std::cerr << "Error: Invalid time '" << newer_than_arg.getValue() << "'." << std::endl;
+                return 1;
+            }
+            filter.modifiedSince(*seconds);
+        }
+        
+        if (!filter.empty() && (read_tar || stream || compact)) {
+            std::cerr << "Error: Filters cannot be combined with --tar, --stream or --compact." << std::endl;
+            return 1;
+        }
+        
+        // Lazily listed trees are built entry by entry, without a constructor to filter, batch or share the work
+        if (lazy && (read_tar || stream || compact || snapshot_arg.isSet() || files_from_arg.isSet()
+                     || traverse_jobs > 1 || !filter.empty())) {
+            std::cerr << "Error: --lazy cannot be combined with --tar, --stream, --compact, --snapshot, "
+                      << "--files-from, --traverse-jobs or filters." << std::endl;
+            return 1;
+        }
+        
+        if (job_file_arg.isSet() && !readJobFile(job_file_arg.getValue(), target_paths)) {
+            std::cerr << "Error: Job file '" << job_file_arg.getValue() << "' cannot be read." << std::endl;
+            return 1;
+        }
+        if (target_paths.empty()) {
+            target_paths.push_back(".");
+        }
+        if (target_paths.size() > 1 && (read_tar || compact)) {
+            std::cerr << "Error: --tar and --compact take a single target path." << std::endl;
+            return 1;
+        }
+        if (snapshot_arg.isSet() && (target_paths.size() > 1 || read_tar || stream || compact
+                                     || files_from_arg.isSet())) {
+            std::cerr << "Error: --snapshot takes a single target path and cannot be combined with "
+                      << "--tar, --stream, --compact or --files-from." << std::endl;
+            return 1;
+        }
+        // Whether a file passes these depends on its stat, which a snapshot does not redo for files it left out
+        if (snapshot_arg.isSet() && filter.needsAttributes()) {
+            std::cerr << "Error: --snapshot cannot be combined with --max-size or --newer-than." << std::endl;
+            return 1;
+        }
+        const std::string& target_path = target_paths.front();
+        
+        // Validate arguments
+        for (const auto& path : target_paths) {
+            if (!(read_tar && path == "-") && !std::filesystem::exists(path)) {
+                std::cerr << "Error: Target path '" << path << "' does not exist." << std::endl;
+                return 1;
+            }
+        }
         
         // Create checksum calculator
         auto calculator = CalculatorFactory::create(algorithm);
@@ -84,30 +282,185 @@ int main(int argc, char** argv) {
             return 1;
         }
         
-        // Choose appropriate directory structure builder based on link handling preference
-        std::unique_ptr<DirectoryStructureBuilder> builder;
-        if (follow_symbolic_links) {
-            builder = std::make_unique<LinkFollowBuilder>(std::make_unique<CycleDetector>());
-        } else {
-            builder = std::make_unique<NonFollowLinkBuilder>();
+        if (files_from_arg.isSet()) {
+            // The list replaces the traversal, so there is no tree to report on, verify against or filter
+            if (path_arg.isSet() || job_file_arg.isSet() || read_tar || compact || show_report
+                || !checksums_file.empty() || follow_symbolic_links || !filter.empty()) {
+                std::cerr << "Error: --files-from cannot be combined with --path, --job-file, --tar, --compact, "
+                          << "--report, --checksums, --follow-links or filters." << std::endl;
+                return 1;
+            }
+            
+            std::ifstream list_file;
+            std::istream* list = &std::cin;
+            if (files_from_arg.getValue() != "-") {
+                list_file.open(files_from_arg.getValue(), std::ios::binary);
+                if (!list_file) {
+                    std::cerr << "Error: File list '" << files_from_arg.getValue() << "' cannot be read." << std::endl;
+                    return 1;
+                }
+                list = &list_file;
+            } else {
+                // Lists can hold millions of paths
+                std::ios::sync_with_stdio(false);
+            }
+            
+            try {
+                StreamingHasher hasher([algorithm]() { return CalculatorFactory::create(algorithm); },
+                                       std::cout, jobs);
+                hasher.hashList(*list);
+            } catch (const std::exception& e) {
+                std::cerr << "Error during checksum calculation: " << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+        
+        if (read_tar) {
+            // Archive members can only be read once, so they are hashed while the tree is built
+            if (!checksums_file.empty()) {
+                std::cerr << "Error: Verification is not supported for tar archives." << std::endl;
+                return 1;
+            }
+            
+            try {
+                NonFollowLinkBuilder tar_builder;
+                bool only_report = show_report && !algorithm_arg.isSet();
+                HashStreamWriter hash_writer(std::move(calculator), std::cout);
+                TarConstructor tar_constructor(tar_builder, only_report ? nullptr : &hash_writer);
+                tar_constructor.construct(target_path);
+                
+                if (show_report && tar_builder.getTree()) {
+                    if (!only_report) {
+                        std::cout << "\n" << std::string(50, '-') << "\n" << std::endl;
+                    }
+                    ReportWriter report_writer(std::cout);
+                    tar_builder.getTree()->accept(report_writer);
+                    report_writer.writeSummary();
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Error while reading archive: " << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+        
+        if (stream) {
+            // Memory stays bounded by the tree depth, so there is no tree to report on or verify against
+            if (show_report || !checksums_file.empty() || follow_symbolic_links) {
+                std::cerr << "Error: --stream cannot be combined with --report, --checksums or --follow-links." << std::endl;
+                return 1;
+            }
+            
+            try {
+                StreamingHasher hasher([algorithm]() { return CalculatorFactory::create(algorithm); },
+                                       std::cout, jobs);
+                for (const auto& path : target_paths) {
+                    hasher.hash(path);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Error during checksum calculation: " << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
         }
         
-        // Build directory structure
-        DirectoryConstructor constructor(*builder);
-        constructor.construct({target_path});
-        Directory* root = builder->getTree();
+        if (!SchedulingStrategyFactory::create(schedule)) {
+            std::cerr << "Error: Unsupported schedule '" << schedule << "'. "
+                      << "Supported schedules: name, cache-first, largest-first" << std::endl;
+            return 1;
+        }
         
-        if (!root) {
+        if (compact && (follow_symbolic_links || jobs > 1 || schedule_arg.isSet())) {
+            std::cerr << "Error: --compact cannot be combined with --follow-links, --jobs or --schedule." << std::endl;
+            return 1;
+        }
+        
+        // Build directory structure, one tree per root; output follows the order of the roots
+        std::vector<std::unique_ptr<DirectoryStructureBuilder>> builders;
+        std::vector<Directory*> roots;
+        FileTable table;
+        if (compact) {
+            table = FileTableConstructor().construct(target_path);
+        } else {
+            for (const auto& path : target_paths) {
+                // Choose appropriate directory structure builder based on link handling preference
+                std::unique_ptr<DirectoryStructureBuilder> builder;
+                if (follow_symbolic_links) {
+                    builder = std::make_unique<LinkFollowBuilder>(std::make_unique<CycleDetector>());
+                } else {
+                    builder = std::make_unique<NonFollowLinkBuilder>();
+                }
+                
+                // A snapshot only stands for a tree built from the same root, link mode and patterns
+                std::string snapshot_key;
+                if (snapshot_arg.isSet()) {
+                    snapshot_key = std::filesystem::absolute(path).lexically_normal().string()
+                        + (follow_symbolic_links ? "\n-l" : "");
+                    for (const auto& glob : exclude_arg.getValue()) {
+                        snapshot_key += "\n-x " + glob;
+                    }
+                    for (const auto& expression : exclude_regex_arg.getValue()) {
+                        snapshot_key += "\n--exclude-regex " + expression;
+                    }
+                    for (const auto& glob : include_arg.getValue()) {
+                        snapshot_key += "\n-i " + glob;
+                    }
+                }
+                
+                if (lazy && std::filesystem::is_directory(path)) {
+                    // Only the root is listed here; the directories below are listed as they are visited
+                    builder = std::make_unique<LazyBuilder>(std::move(builder));
+                    builder->startBuildDirectory(path);
+                    builder->endBuildDirectory();
+                } else if (!snapshot_arg.isSet() || !TreeSnapshot::load(snapshot_arg.getValue(), *builder, snapshot_key)) {
+                    DirectoryConstructor constructor(*builder, traverse_jobs);
+                    // The report and the progress total need every size; verification alone does not
+                    constructor.collectSizes(show_report || checksums_file.empty());
+                    constructor.setFilter(filter);
+                    // A stale snapshot still spares listing the directories that did not change
+                    DirectoryListings listings;
+                    if (snapshot_arg.isSet() && TreeSnapshot::loadListings(snapshot_arg.getValue(), snapshot_key, listings)) {
+                        constructor.setListings(&listings);
+                    }
+                    auto listed = std::chrono::system_clock::now();
+                    constructor.construct({path});
+                    if (builder->getTree() && snapshot_arg.isSet()
+                        && !TreeSnapshot::save(*builder->getTree(), snapshot_arg.getValue(), snapshot_key, listed)) {
+                        std::cerr << "Warning: Snapshot '" << snapshot_arg.getValue() << "' could not be saved." << std::endl;
+                    }
+                }
+                if (!builder->getTree()) {
+                    std::cerr << "Error: Failed to build directory structure for '" << path << "'." << std::endl;
+                    return 1;
+                }
+                roots.push_back(builder->getTree());
+                builders.push_back(std::move(builder));
+            }
+        }
+        
+        if (roots.empty() && table.empty()) {
             std::cerr << "Error: Failed to build directory structure for '" << target_path << "'." << std::endl;
             return 1;
         }
         
+        // Visitors iterate whichever trees were built
+        auto visitTree = [&](DirectoryIterationVisitor& visitor) {
+            if (!roots.empty()) {
+                for (Directory* root : roots) {
+                    root->accept(visitor);
+                }
+            } else {
+                table.accept(visitor);
+            }
+        };
+        
         // Determine mode of operation
         if (show_report) {
             // Report mode - show files to be traversed and their sizes
             try {
                 ReportWriter report_writer(std::cout);
-                root->accept(report_writer);
+                visitTree(report_writer);
                 report_writer.writeSummary();
                 
                 // Continue with other operations if verification or explicit algorithm was requested
@@ -137,7 +490,7 @@ int main(int argc, char** argv) {
                 auto expected_checksums = reader.readChecksums(checksums_file);
                 
                 VerificationVisitor verification_visitor(expected_checksums);
-                root->accept(verification_visitor);
+                visitTree(verification_visitor);
                 
                 auto results = verification_visitor.getResults();
                 VerificationResultPrinter printer;
@@ -156,20 +509,42 @@ int main(int argc, char** argv) {
                     std::cerr << "Warning: Only text format is currently implemented. Using text format." << std::endl;
                 }
                 
-                // Calculate total size for progress reporting
-                std::uint64_t total_size = calculateTotalSize(root);
-                
-                HashStreamWriter hash_writer(std::move(calculator), std::cout);
+                // Calculate total size for progress reporting; a lazy tree would have to be listed whole for it
+                std::uint64_t total_size = roots.empty() ? table.totalSize() : 0;
+                for (Directory* root : roots) {
+                    total_size += lazy ? 0 : calculateTotalSize(root);
+                }
                 
-                // Create and register progress reporter if total size is significant
+                // Create progress reporter if total size is significant
                 std::unique_ptr<ProgressReporter> progress_reporter;
                 if (total_size > 1024 * 1024) { // Only show progress for files > 1MB
                     progress_reporter = std::make_unique<ProgressReporter>(total_size, std::cerr);
                     progress_reporter->start();
-                    hash_writer.attach(progress_reporter.get());
                 }
                 
-                root->accept(hash_writer);
+                if (jobs > 1 || schedule_arg.isSet()) {
+                    // Worker pool: each worker gets its own calculator, and all roots share the pool
+                    HashEngine engine([algorithm]() { return CalculatorFactory::create(algorithm); },
+                                      std::cout, jobs, SchedulingStrategyFactory::create(schedule));
+                    engine.attach(progress_reporter.get());
+                    engine.hash(std::vector<FileObject*>(roots.begin(), roots.end()));
+                } else {
+                    HashStreamWriter hash_writer(std::move(calculator), std::cout);
+                    hash_writer.attach(progress_reporter.get());
+                    
+                    // Start reading upcoming files while the current one is hashed
+                    std::unique_ptr<ReadAheadPrefetcher> prefetcher;
+                    if (prefetch_window > 0 && !roots.empty() && !lazy) {
+                        FileCollector collector;
+                        visitTree(collector);
+                        prefetcher = std::make_unique<ReadAheadPrefetcher>(collector.getFiles(), prefetch_window,
+                                                                           collector.getReachedPaths());
+                        hash_writer.attach(prefetcher.get());
+                        prefetcher->start();
+                    }
+                    
+                    visitTree(hash_writer);
+                }
                 
                 // Ensure final newline after progress display
                 if (progress_reporter) {
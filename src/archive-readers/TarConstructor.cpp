@@ -0,0 +1,128 @@
+#include "TarConstructor.hpp"
+#include "directory-iteration-visitors/HashStreamWriter.hpp"
+#include <iostream>
+#include <sstream>
+
+TarConstructor::TarConstructor(DirectoryStructureBuilder& builder, HashStreamWriter* writer)
+    : _builder(builder), _writer(writer) {}
+
+void TarConstructor::construct(const std::filesystem::path& archive, const std::filesystem::path& root) {
+    TarReader reader(archive);
+
+    _builder.startBuildDirectory(root);
+    _open_dirs.clear();
+
+    TarEntry entry;
+    while (reader.next(entry)) {
+        try {
+            buildMember(entry, reader);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Warning: Could not process archive member: " << entry.path
+                      << ". Reason: " << e.what() << '\n';
+        }
+    }
+
+    enterDirectory({});
+    _builder.endBuildDirectory();
+}
+
+std::vector<std::string> TarConstructor::components(const std::string& member_path) {
+    std::vector<std::string> parts;
+    std::istringstream iss(member_path);
+    std::string part;
+    while (std::getline(iss, part, '/')) {
+        if (part.empty() || part == ".") {
+            continue;
+        }
+        // Never let a member escape the root
+        if (part == "..") {
+            return {};
+        }
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+std::string TarConstructor::join(const std::vector<std::string>& parts) {
+    std::string joined;
+    for (const auto& part : parts) {
+        if (!joined.empty()) joined += '/';
+        joined += part;
+    }
+    return joined;
+}
+
+void TarConstructor::enterDirectory(const std::vector<std::string>& dirs) {
+    std::size_t common = 0;
+    while (common < _open_dirs.size() && common < dirs.size() && _open_dirs[common] == dirs[common]) {
+        ++common;
+    }
+    while (_open_dirs.size() > common) {
+        _builder.endBuildDirectory();
+        _open_dirs.pop_back();
+    }
+    for (std::size_t i = common; i < dirs.size(); ++i) {
+        _builder.startBuildDirectory(dirs[i]);
+        _open_dirs.push_back(dirs[i]);
+    }
+}
+
+void TarConstructor::buildMember(const TarEntry& entry, TarReader& reader) {
+    auto parts = components(entry.path);
+    if (parts.empty()) {
+        if (entry.type != TarEntry::Type::Directory) {
+            std::cerr << "Warning: Skipping archive member with unsafe path: " << entry.path << '\n';
+        }
+        return;
+    }
+
+    if (entry.type == TarEntry::Type::Directory) {
+        enterDirectory(parts);
+        return;
+    }
+
+    std::string name = parts.back();
+    parts.pop_back();
+    enterDirectory(parts);
+
+    switch (entry.type) {
+        case TarEntry::Type::File: {
+            File* file = _builder.buildFile(name);
+            if (!file) {
+                return;
+            }
+            file->setSize(static_cast<size_t>(entry.size));
+            if (_writer) {
+                std::string checksum = _writer->visitStream(*file, reader.contents());
+                parts.push_back(name);
+                _hashed[join(parts)] = {entry.size, checksum};
+            }
+            break;
+        }
+        case TarEntry::Type::Hardlink: {
+            // Extracted, a hardlink is a regular file with the contents of its target
+            File* file = _builder.buildFile(name);
+            if (!file || !_writer) {
+                return;
+            }
+            auto it = _hashed.find(join(components(entry.link_target)));
+            if (it == _hashed.end()) {
+                std::cerr << "Warning: Hardlink target not found in archive: " << entry.link_target << '\n';
+                return;
+            }
+            file->setSize(static_cast<size_t>(it->second.size));
+            _writer->writeDigest(*file, it->second.checksum);
+            break;
+        }
+        case TarEntry::Type::Symlink: {
+            // Link targets refer to the extracted tree, so they are never followed here
+            if (_builder.buildLink(name, entry.link_target)) {
+                _builder.endBuildDirectory();
+            }
+            break;
+        }
+        case TarEntry::Type::Other:
+        case TarEntry::Type::Directory:
+            break;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "TarReader.hpp"
+#include "directory-tree-builders/DirectoryStructureBuilder.hpp"
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class HashStreamWriter;
+
+/**
+ * @brief Director class in the Builder structure for tar archives.
+ *
+ * Creates the in-memory file structure from the archive headers, without
+ * extracting anything to disk. When a HashStreamWriter is given, every member
+ * is hashed straight from the archive stream in the same sequential pass,
+ * producing the same lines as hashing the extracted tree under the root name.
+ *
+ * Links in the archive are recorded but never followed.
+ */
+class TarConstructor {
+public:
+    /**
+     * @param builder Builder receiving the archive structure.
+     * @param writer Optional writer that hashes member data while it is read.
+     */
+    explicit TarConstructor(DirectoryStructureBuilder& builder, HashStreamWriter* writer = nullptr);
+
+    /**
+     * @param archive Archive path, or "-" for standard input.
+     * @param root Name of the root directory members are placed under.
+     * @throws std::runtime_error if the archive cannot be opened or is corrupt.
+     */
+    void construct(const std::filesystem::path& archive, const std::filesystem::path& root = ".");
+
+private:
+    /**
+     * @brief Split a member path into clean components; empty if the path must be skipped.
+     */
+    static std::vector<std::string> components(const std::string& member_path);
+    static std::string join(const std::vector<std::string>& parts);
+
+    /**
+     * @brief Make the builder's current directory the one named by the given components.
+     */
+    void enterDirectory(const std::vector<std::string>& dirs);
+
+    void buildMember(const TarEntry& entry, TarReader& reader);
+
+    DirectoryStructureBuilder& _builder;
+    HashStreamWriter* _writer;
+
+    std::vector<std::string> _open_dirs; ///< Directories currently open in the builder, below the root
+
+    struct HashedMember {
+        std::uint64_t size;
+        std::string checksum;
+    };
+    /**
+     * @brief Results of members already read, keyed by their cleaned path,
+     * so hardlinks to them can be reported
+     */
+    std::unordered_map<std::string, HashedMember> _hashed;
+};
@@ -0,0 +1,296 @@
+#include "TarReader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+#endif
+
+namespace {
+    constexpr std::size_t BLOCK = 512;
+
+    std::string field(const char* header, std::size_t offset, std::size_t length) {
+        const char* begin = header + offset;
+        const char* end = static_cast<const char*>(std::memchr(begin, '\0', length));
+        return std::string(begin, end ? end : begin + length);
+    }
+
+    /**
+     * @brief Parse a numeric header field, either octal text or GNU base-256
+     * (used for sizes of 8 GiB and more).
+     */
+    std::uint64_t number(const char* header, std::size_t offset, std::size_t length) {
+        const auto* p = reinterpret_cast<const unsigned char*>(header + offset);
+        std::uint64_t value = 0;
+        if (p[0] & 0x80) {
+            value = p[0] & 0x7f;
+            for (std::size_t i = 1; i < length; ++i) {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+        std::size_t i = 0;
+        while (i < length && (p[i] == ' ' || p[i] == '\0')) ++i;
+        for (; i < length && p[i] >= '0' && p[i] <= '7'; ++i) {
+            value = (value << 3) | static_cast<std::uint64_t>(p[i] - '0');
+        }
+        return value;
+    }
+
+    bool checksumMatches(const char* header) {
+        std::uint64_t expected = number(header, 148, 8);
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < BLOCK; ++i) {
+            bool in_checksum_field = i >= 148 && i < 156;
+            sum += in_checksum_field ? ' ' : static_cast<unsigned char>(header[i]);
+        }
+        return sum == expected;
+    }
+
+    bool isZeroBlock(const char* header) {
+        return std::all_of(header, header + BLOCK, [](char c) { return c == '\0'; });
+    }
+
+    std::uint64_t paddingFor(std::uint64_t size) {
+        return (BLOCK - size % BLOCK) % BLOCK;
+    }
+}
+
+TarReader::TarReader(const std::filesystem::path& archive)
+    : _buffer(*this), _stream(&_buffer) {
+    bool from_stdin = archive == "-";
+#ifdef HAVE_ZLIB
+    gzFile gz = from_stdin ? gzdopen(dup(fileno(stdin)), "rb") : gzopen(archive.string().c_str(), "rb");
+    if (!gz) {
+        throw std::runtime_error("Error: Failed to open archive: " + archive.string());
+    }
+    gzbuffer(gz, 256 * 1024);
+    _gz = gz;
+#else
+    _file = from_stdin ? stdin : std::fopen(archive.string().c_str(), "rb");
+    if (!_file) {
+        throw std::runtime_error("Error: Failed to open archive: " + archive.string());
+    }
+    _close_file = !from_stdin;
+#endif
+}
+
+TarReader::~TarReader() {
+#ifdef HAVE_ZLIB
+    if (_gz) {
+        gzclose(static_cast<gzFile>(_gz));
+    }
+#endif
+    if (_file && _close_file) {
+        std::fclose(_file);
+    }
+}
+
+bool TarReader::supportsGzip() noexcept {
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool TarReader::readRaw(char* buffer, std::size_t size) {
+    std::size_t done = 0;
+    while (done < size) {
+        std::size_t got = 0;
+#ifdef HAVE_ZLIB
+        unsigned chunk = static_cast<unsigned>(std::min<std::size_t>(size - done, 1u << 30));
+        int n = gzread(static_cast<gzFile>(_gz), buffer + done, chunk);
+        if (n < 0) {
+            throw std::runtime_error("Error: Failed to decompress archive");
+        }
+        got = static_cast<std::size_t>(n);
+#else
+        got = std::fread(buffer + done, 1, size - done, _file);
+#endif
+        if (got == 0) {
+            return false;
+        }
+        done += got;
+    }
+    return true;
+}
+
+void TarReader::skipRemaining() {
+    char scratch[64 * 1024];
+    std::uint64_t left = _remaining + _padding;
+    while (left > 0) {
+        std::size_t take = static_cast<std::size_t>(std::min<std::uint64_t>(left, sizeof(scratch)));
+        if (!readRaw(scratch, take)) {
+            throw std::runtime_error("Error: Unexpected end of archive");
+        }
+        left -= take;
+    }
+    _remaining = _padding = 0;
+    _stream.clear();
+    _buffer.discard();
+}
+
+void TarReader::applyPaxRecords(const std::string& records, TarEntry& overrides, bool& has_size) {
+    // Each record is "<length> <key>=<value>\n", where length counts the whole record
+    std::size_t pos = 0;
+    while (pos < records.size()) {
+        std::size_t space = records.find(' ', pos);
+        if (space == std::string::npos) break;
+        std::size_t length = std::strtoull(records.c_str() + pos, nullptr, 10);
+        if (length == 0 || pos + length > records.size()) break;
+
+        std::string record = records.substr(space + 1, pos + length - space - 2);
+        std::size_t eq = record.find('=');
+        if (eq != std::string::npos) {
+            std::string key = record.substr(0, eq);
+            std::string value = record.substr(eq + 1);
+            if (key == "path") {
+                overrides.path = value;
+            } else if (key == "linkpath") {
+                overrides.link_target = value;
+            } else if (key == "size") {
+                overrides.size = std::strtoull(value.c_str(), nullptr, 10);
+                has_size = true;
+            } else if (key == "mtime") {
+                overrides.mtime = std::strtoll(value.c_str(), nullptr, 10);
+            }
+        }
+        pos += length;
+    }
+}
+
+bool TarReader::next(TarEntry& entry) {
+    if (_finished) {
+        return false;
+    }
+    skipRemaining();
+
+    TarEntry overrides;
+    bool has_size = false;
+    bool first = true;
+    char header[BLOCK];
+
+    while (true) {
+        if (!readRaw(header, BLOCK)) {
+            // Some writers omit the terminating zero blocks
+            _finished = true;
+            return false;
+        }
+        if (first && !supportsGzip()
+            && static_cast<unsigned char>(header[0]) == 0x1f && static_cast<unsigned char>(header[1]) == 0x8b) {
+            throw std::runtime_error("Error: Archive is gzip-compressed, but zlib support is not available");
+        }
+        first = false;
+
+        if (isZeroBlock(header)) {
+            _finished = true;
+            return false;
+        }
+        if (!checksumMatches(header)) {
+            throw std::runtime_error("Error: Corrupt tar header (checksum mismatch)");
+        }
+
+        char type = header[156];
+        std::uint64_t size = number(header, 124, 12);
+
+        // Extended headers carry data for the member that follows them
+        if (type == 'x' || type == 'g' || type == 'L' || type == 'K') {
+            std::string data(static_cast<std::size_t>(size), '\0');
+            if (!readRaw(data.data(), data.size())) {
+                throw std::runtime_error("Error: Unexpected end of archive");
+            }
+            _remaining = 0;
+            _padding = paddingFor(size);
+            skipRemaining();
+
+            if (type == 'x') {
+                applyPaxRecords(data, overrides, has_size);
+            } else if (type == 'L') {
+                overrides.path = data.c_str();
+            } else if (type == 'K') {
+                overrides.link_target = data.c_str();
+            }
+            // Global ('g') records describe the whole archive and are ignored
+            continue;
+        }
+
+        entry = TarEntry();
+        entry.path = field(header, 0, 100);
+        if (std::memcmp(header + 257, "ustar", 5) == 0) {
+            std::string prefix = field(header, 345, 155);
+            if (!prefix.empty()) {
+                entry.path = prefix + "/" + entry.path;
+            }
+        }
+        entry.link_target = field(header, 157, 100);
+        entry.size = size;
+        entry.mtime = static_cast<std::int64_t>(number(header, 136, 12));
+
+        if (!overrides.path.empty()) entry.path = overrides.path;
+        if (!overrides.link_target.empty()) entry.link_target = overrides.link_target;
+        if (has_size) entry.size = overrides.size;
+        if (overrides.mtime != 0) entry.mtime = overrides.mtime;
+
+        bool has_data = false;
+        switch (type) {
+            case '0': case '\0': case '7':
+                has_data = true;
+                // Pre-POSIX archives mark directories with a trailing slash only
+                entry.type = (type == '\0' && !entry.path.empty() && entry.path.back() == '/')
+                    ? TarEntry::Type::Directory : TarEntry::Type::File;
+                break;
+            case '5': entry.type = TarEntry::Type::Directory; break;
+            case '2': entry.type = TarEntry::Type::Symlink; break;
+            case '1': entry.type = TarEntry::Type::Hardlink; break;
+            case '3': case '4': case '6': entry.type = TarEntry::Type::Other; break;
+            default:
+                has_data = true;
+                entry.type = TarEntry::Type::Other;
+                break;
+        }
+        if (entry.type == TarEntry::Type::Directory) {
+            has_data = false;
+        }
+
+        _remaining = has_data ? entry.size : 0;
+        _padding = has_data ? paddingFor(entry.size) : 0;
+        return true;
+    }
+}
+
+std::size_t TarReader::read(char* buffer, std::size_t size) {
+    std::size_t take = static_cast<std::size_t>(std::min<std::uint64_t>(size, _remaining));
+    if (take == 0) {
+        return 0;
+    }
+    if (!readRaw(buffer, take)) {
+        throw std::runtime_error("Error: Unexpected end of archive");
+    }
+    _remaining -= take;
+    return take;
+}
+
+std::istream& TarReader::contents() {
+    return _stream;
+}
+
+TarReader::MemberBuffer::int_type TarReader::MemberBuffer::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    std::size_t got = _reader.read(_data, sizeof(_data));
+    if (got == 0) {
+        return traits_type::eof();
+    }
+    setg(_data, _data, _data + got);
+    return traits_type::to_int_type(*gptr());
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Header information of a single archive member.
+ */
+struct TarEntry {
+    enum class Type { File, Directory, Symlink, Hardlink, Other };
+
+    std::string path;        ///< Member path as stored in the archive
+    Type type = Type::Other;
+    std::uint64_t size = 0;  ///< Size of the member data in bytes
+    std::string link_target; ///< Target of symlinks and hardlinks
+    std::int64_t mtime = 0;
+};
+
+/**
+ * @class TarReader
+ * @brief Sequential, single-pass reader for ustar/pax (and GNU long name) tar archives.
+ *
+ * The archive is never seeked, so it can be read from a pipe ("-" means stdin).
+ * When built with zlib, gzip-compressed archives are decompressed transparently.
+ *
+ * Usage: call next() to advance to a member, then read its data through contents()
+ * before calling next() again. Unread data is skipped automatically.
+ */
+class TarReader {
+public:
+    /**
+     * @param archive Path to the archive, or "-" for standard input.
+     * @throws std::runtime_error if the archive cannot be opened.
+     */
+    explicit TarReader(const std::filesystem::path& archive);
+    ~TarReader();
+
+    TarReader(const TarReader&) = delete;
+    TarReader& operator=(const TarReader&) = delete;
+
+    /**
+     * @brief Advance to the next member.
+     * @param entry Filled with the member's header information.
+     * @return false at the end of the archive.
+     * @throws std::runtime_error on a truncated or corrupt archive.
+     */
+    bool next(TarEntry& entry);
+
+    /**
+     * @brief Read up to size bytes of the current member's data.
+     * @return number of bytes read, 0 once the member is exhausted.
+     */
+    std::size_t read(char* buffer, std::size_t size);
+
+    /**
+     * @brief Stream over the current member's data; reaches EOF at the end of the member.
+     */
+    std::istream& contents();
+
+    /**
+     * @brief Whether the reader can decompress gzip archives.
+     */
+    static bool supportsGzip() noexcept;
+
+private:
+    class MemberBuffer : public std::streambuf {
+    public:
+        explicit MemberBuffer(TarReader& reader) : _reader(reader) {}
+        /// Drop buffered data left over from the previous member
+        void discard() { setg(_data, _data, _data); }
+    protected:
+        int_type underflow() override;
+    private:
+        TarReader& _reader;
+        char _data[64 * 1024];
+    };
+
+    /**
+     * @brief Read exactly size bytes from the underlying (possibly compressed) source.
+     * @return false if the source ended first.
+     */
+    bool readRaw(char* buffer, std::size_t size);
+    void skipRemaining();
+    void applyPaxRecords(const std::string& records, TarEntry& overrides, bool& has_size);
+
+    void* _gz = nullptr;          ///< gzFile handle when zlib is available
+    std::FILE* _file = nullptr;   ///< Plain handle otherwise
+    bool _close_file = false;
+
+    std::uint64_t _remaining = 0; ///< Unread data bytes of the current member
+    std::uint64_t _padding = 0;   ///< Padding after the current member's data
+    bool _finished = false;
+
+    MemberBuffer _buffer;
+    std::istream _stream;
+};
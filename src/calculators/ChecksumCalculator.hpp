@@ -1,15 +1,38 @@
 #pragma once
 #include <string>
+#include <cstddef>
 #include "progress-indicator-observers/Observable.hpp"
 
 /**
  * @interface ChecksumCalculator
  * @brief Strategy interface for checksum algorithms. Observable to report progress.
+ *
+ * Besides the one-shot calculate(), data can be fed incrementally:
+ * reset(), any number of update() calls, then digest().
  */
 class ChecksumCalculator : public Observable {
 public:
     /// Calculate checksum for given data
     virtual std::string calculate(const std::string& data) noexcept = 0;
     virtual std::string getAlgorithmName() const noexcept = 0;
+
+    /// Start a new incremental computation
+    virtual void reset() noexcept { _pending.clear(); }
+
+    /// Feed the next chunk of data to the incremental computation
+    virtual void update(const char* data, std::size_t size) noexcept { _pending.append(data, size); }
+
+    /// Finish the incremental computation and return the checksum
+    virtual std::string digest() noexcept {
+        std::string result = calculate(_pending);
+        _pending.clear();
+        return result;
+    }
+
     virtual ~ChecksumCalculator() = default;
-};
\ No newline at end of file
+private:
+    /**
+     * @brief Fallback buffer for calculators that only implement calculate()
+     */
+    std::string _pending;
+};
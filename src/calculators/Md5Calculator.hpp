@@ -12,7 +12,12 @@ public:
     std::string calculate(const std::string& data) noexcept override;
     std::string getAlgorithmName() const noexcept override { return "md5"; }
 
+    void reset() noexcept override;
+    void update(const char* data, std::size_t size) noexcept override;
+    std::string digest() noexcept override;
+
 private:
     
-    static MD5 md5; ///< Shared MD5 instance for checksum calculations
+    std::size_t _processed = 0; ///< Bytes fed since the last reset
+    MD5 _md5; ///< Per-instance state, so calculators can run on separate threads
 };
\ No newline at end of file
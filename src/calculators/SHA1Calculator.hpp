@@ -15,8 +15,13 @@ public:
      */
     std::string calculate(const std::string& data) noexcept override;
     std::string getAlgorithmName() const noexcept override { return "sha1"; }
+
+    void reset() noexcept override;
+    void update(const char* data, std::size_t size) noexcept override;
+    std::string digest() noexcept override;
 private:
 
     
-    static SHA1 sha1;  ///< Shared SHA1 instance for checksum calculations
+    std::size_t _processed = 0; ///< Bytes fed since the last reset
+    SHA1 _sha1; ///< Per-instance state, so calculators can run on separate threads
 };
\ No newline at end of file
@@ -1,25 +1,35 @@
 #include "SHA256Calculator.hpp"
 #include "progress-indicator-observers/Message.hpp"
 
-SHA256 SHA256Calculator::sha256 = SHA256();
-
 std::string SHA256Calculator::calculate(const std::string& data) noexcept {
-    sha256.reset();
+    reset();
 
     constexpr std::size_t CHUNK = 1024; // 1 KiB ticks
-    std::size_t processed = 0;
 
     const char* ptr = data.data();
     std::size_t remaining = data.size();
 
     while (remaining > 0) {
         std::size_t take = remaining < CHUNK ? remaining : CHUNK;
-        sha256.add(ptr, take);
+        update(ptr, take);
         ptr += take;
         remaining -= take;
-        processed += take;
-        notify(*this, BytesReadMessage(static_cast<std::uint64_t>(processed)));
     }
 
-    return sha256.getHash();
-}
\ No newline at end of file
+    return digest();
+}
+
+void SHA256Calculator::reset() noexcept {
+    _sha256.reset();
+    _processed = 0;
+}
+
+void SHA256Calculator::update(const char* data, std::size_t size) noexcept {
+    _sha256.add(data, size);
+    _processed += size;
+    notify(*this, BytesReadMessage(static_cast<std::uint64_t>(_processed)));
+}
+
+std::string SHA256Calculator::digest() noexcept {
+    return _sha256.getHash();
+}
@@ -15,7 +15,12 @@ public:
      */
     std::string calculate(const std::string& data) noexcept override;
     std::string getAlgorithmName() const noexcept override { return "sha256"; }
+
+    void reset() noexcept override;
+    void update(const char* data, std::size_t size) noexcept override;
+    std::string digest() noexcept override;
 private:
     
-    static SHA256 sha256; ///< Shared SHA256 instance for checksum calculations
+    std::size_t _processed = 0; ///< Bytes fed since the last reset
+    SHA256 _sha256; ///< Per-instance state, so calculators can run on separate threads
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "DirectoryIterationVisitor.hpp"
+#include "file-system-composite/Link.hpp"
 
 DirectoryIterationVisitor::DirectoryIterationVisitor(std::ostream& os) : _output(os) {}
 
@@ -7,4 +8,46 @@ void DirectoryIterationVisitor::processFile(File& file) {
     preProcess(file);
     applyAlgorithm(file);
     postProcess(file);
-}
\ No newline at end of file
+}
+
+std::filesystem::path DirectoryIterationVisitor::pathOf(const FileObject& object) const {
+    std::filesystem::path path = object.getPath();
+    if (_aliases.empty()) {
+        return path;
+    }
+
+    std::string full = path.string();
+    for (auto it = _aliases.rbegin(); it != _aliases.rend(); ++it) {
+        const std::string& from = it->first;
+        if (full.compare(0, from.size(), from) != 0) {
+            continue;
+        }
+        if (full.size() == from.size()) {
+            return it->second;
+        }
+        if (full[from.size()] == static_cast<char>(std::filesystem::path::preferred_separator)) {
+            return it->second / full.substr(from.size() + 1);
+        }
+    }
+    return path;
+}
+
+void DirectoryIterationVisitor::visitTarget(Link& link) {
+    FileObject* target = link.getResolvedTarget();
+    if (!target) {
+        return;
+    }
+    if (link.ownsResolvedTarget()) {
+        target->accept(*this);
+        return;
+    }
+
+    _aliases.emplace_back(target->getPath().string(), pathOf(link));
+    try {
+        target->accept(*this);
+    } catch (...) {
+        _aliases.pop_back();
+        throw;
+    }
+    _aliases.pop_back();
+}
@@ -1,8 +1,13 @@
 #pragma once
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
 
 class Directory;
 class File;
+class FileObject;
 class Link;
 
 class DirectoryIterationVisitor {
@@ -15,13 +20,34 @@ public:
     
     virtual void visitLink(Link& link) { }
 
+    /**
+     * @return true if the visitor reads the data of the files it visits. Only then
+     * does Directory::accept keep the directories being walked open, so that files
+     * are opened relative to them.
+     */
+    virtual bool readsFiles() const { return false; }
+
     void processFile(File& file);
+
+    /**
+     * @return path object is reached by in the current walk. Below a link sharing the
+     * target of another link, this is the path under the link being walked, not the
+     * path the shared target was built at.
+     */
+    std::filesystem::path pathOf(const FileObject& object) const;
 protected:
     DirectoryIterationVisitor(std::ostream& os);
 
     virtual void preProcess(File& file) { }
     virtual void applyAlgorithm(File& file) { }
     virtual void postProcess(File& file) { }
+
+    /**
+     * @brief Walk the resolved target of link, if any, reporting it under the link's path
+     */
+    void visitTarget(Link& link);
 protected:
     std::ostream& _output; // For testing
+private:
+    std::vector<std::pair<std::string, std::filesystem::path>> _aliases; ///< Shared target path, path it is reached by; innermost last
 };
\ No newline at end of file
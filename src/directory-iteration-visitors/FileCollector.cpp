@@ -0,0 +1,25 @@
+#include "FileCollector.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include "file-system-composite/Link.hpp"
+
+FileCollector::FileCollector() : DirectoryIterationVisitor(std::cout) {}
+
+void FileCollector::visitFile(File& file) {
+    std::filesystem::path reached = pathOf(file);
+    if (reached != file.getPath()) {
+        _reached_paths.emplace(_files.size(), std::move(reached));
+    }
+    _files.push_back(&file);
+}
+
+void FileCollector::visitDirectory(Directory& dir) {
+    // The first directory visited is the root, whose totals count every file to come
+    if (_files.capacity() == 0) {
+        _files.reserve(static_cast<std::size_t>(dir.getTotals().files));
+    }
+}
+
+void FileCollector::visitLink(Link& link) {
+    visitTarget(link);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "DirectoryIterationVisitor.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class FileCollector
+ * @brief Visitor that records every File in the order HashStreamWriter would process them.
+ *
+ * Links are followed to their resolved targets, the same way hashing does, so a
+ * target shared by several links is collected once per link.
+ */
+class FileCollector : public DirectoryIterationVisitor {
+public:
+    FileCollector();
+
+    void visitFile(File& file) override;
+    void visitDirectory(Directory& dir) override;
+    void visitLink(Link& link) override;
+
+    /// @return collected files, in visiting order
+    const std::vector<File*>& getFiles() const { return _files; }
+
+    /// Paths files were reached by below shared link targets, by index; other files are reached at their own path
+    using ReachedPaths = std::unordered_map<std::size_t, std::filesystem::path>;
+
+    const ReachedPaths& getReachedPaths() const { return _reached_paths; }
+
+private:
+    std::vector<File*> _files;
+    ReachedPaths _reached_paths;
+};
@@ -4,7 +4,7 @@
 #include "file-system-composite/Link.hpp"
 #include "calculators/ChecksumCalculator.hpp"
 #include <stdexcept>
-#include <fstream>
+#include <vector>
 
 HashStreamWriter::HashStreamWriter(std::unique_ptr<ChecksumCalculator> calc, std::ostream& os)
     : DirectoryIterationVisitor(os), _hash_strategy(std::move(calc)) {
@@ -20,27 +20,96 @@ void HashStreamWriter::visitFile(File& file) {
 void HashStreamWriter::visitDirectory(Directory&) {}
 
 void HashStreamWriter::visitLink(Link& link) {
-    if (auto* target = link.getResolvedTarget()) {
-    target->accept(*this);
+    if (!link.isTargetShared()) {
+        visitTarget(link);
+        return;
     }
+    ++_shared_depth;
+    try {
+        visitTarget(link);
+    } catch (...) {
+        --_shared_depth;
+        throw;
+    }
+    --_shared_depth;
 }
 
 void HashStreamWriter::applyAlgorithm(File& file) {
-    std::vector<char> content;
-#ifdef DEBUG
-    std::ifstream debug_stream(file.getPath().string(), std::ios::in | std::ios::binary);
-    if (debug_stream.is_open()) {
-        content = file.read(debug_stream);
-        debug_stream.close();
-    } else {
-        content = file.read();
-    }
-#else
-    content = file.read();
-#endif
-    std::string content_str(content.begin(), content.end());
-    std::string checksum = _hash_strategy->calculate(content_str);
-    _output << _hash_strategy->getAlgorithmName() << " " << checksum << " " << file.getPath().string() << '\n';
+    if (_shared_depth > 0) {
+        auto it = _shared_checksums.find(&file);
+        if (it != _shared_checksums.end()) {
+            // Its data was counted once, the first time it was read
+            writeDigest(file, it->second);
+            return;
+        }
+    }
+
+    auto inode = file.getSharedInode();
+    if (inode) {
+        auto it = _inode_checksums.find(*inode);
+        if (it != _inode_checksums.end()) {
+            // Counted as read, so progress totals that include every name still add up
+            notify(*this, BytesReadMessage(static_cast<std::uint64_t>(file.getSize())));
+            writeDigest(file, it->second);
+            return;
+        }
+    }
+
+    // Streamed chunk by chunk, so neither the file nor its holes are held in memory
+    _hash_strategy->reset();
+    file.read([&](const char* data, std::size_t size) { _hash_strategy->update(data, size); });
+    std::string checksum = _hash_strategy->digest();
+    if (inode) {
+        _inode_checksums.emplace(*inode, checksum);
+    }
+    if (_shared_depth > 0) {
+        _shared_checksums.emplace(&file, checksum);
+    }
+    writeDigest(file, checksum);
+}
+
+std::string HashStreamWriter::visitStream(File& file, std::istream& content) {
+    preProcess(file);
+
+    constexpr std::size_t CHUNK = 64 * 1024;
+    std::vector<char> buffer(CHUNK);
+
+    _hash_strategy->reset();
+    while (content) {
+        content.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize got = content.gcount();
+        if (got <= 0) {
+            break;
+        }
+        _hash_strategy->update(buffer.data(), static_cast<std::size_t>(got));
+    }
+    if (content.bad()) {
+        throw std::ios_base::failure("Error: Failed to read data for: " + file.getPath().string());
+    }
+
+    std::string checksum = _hash_strategy->digest();
+    writeDigest(file, checksum);
+    return checksum;
+}
+
+void HashStreamWriter::writeDigest(const File& file, const std::string& checksum) {
+    writeDigest(pathOf(file), checksum);
+}
+
+void HashStreamWriter::writeDigest(const std::filesystem::path& path, const std::string& checksum) {
+    std::string line;
+    appendDigest(line, path, checksum);
+    _output << line;
+}
+
+void HashStreamWriter::appendDigest(std::string& lines, const std::filesystem::path& path,
+                                    const std::string& checksum) const {
+    lines += _hash_strategy->getAlgorithmName();
+    lines += ' ';
+    lines += checksum;
+    lines += ' ';
+    lines += path.string();
+    lines += '\n';
 }
 
 void HashStreamWriter::attach(Observer* observer) {
@@ -51,5 +120,5 @@ void HashStreamWriter::attach(Observer* observer) {
 }
 
 void HashStreamWriter::preProcess(File& file) {
-    notify(*this, NewFileMessage(file.getPath().string()));
+    notify(*this, NewFileMessage(pathOf(file).string()));
 }
\ No newline at end of file
@@ -3,14 +3,22 @@
 #include "calculators/ChecksumCalculator.hpp"
 #include "progress-indicator-observers/Message.hpp"
 #include "progress-indicator-observers/Observable.hpp"
+#include "file-system-composite/FileId.hpp"
+#include <filesystem>
 #include <memory>
 #include <iostream>
+#include <string>
+#include <unordered_map>
 
 /**
 * @class HashStreamWriter
 * @brief Visitor that computes a checksum for each visited File and writes it to an output stream.
 *
 * Output format: `<hash><two spaces><path>\n`
+*
+* Files known to share an inode with other names (hard links) are read once;
+* the other names get the remembered checksum. Likewise the files of a link
+* target shared by several links are read once and written under each link.
 */
 class HashStreamWriter : public DirectoryIterationVisitor, public Observable {
 public:
@@ -24,6 +32,32 @@ public:
     void visitFile(File& file) override;
     void visitDirectory(Directory& dir) override;
     void visitLink(Link& link) override;
+    bool readsFiles() const override { return true; }
+
+    /**
+    * @brief Hash a file whose contents come from a stream instead of the disk
+    * (e.g. a member of an archive) and write its line.
+    * @param file Node the line is written for.
+    * @param content Stream positioned at the start of the file data; read until EOF.
+    * @return The computed checksum.
+    */
+    std::string visitStream(File& file, std::istream& content);
+
+    /**
+    * @brief Write the line for a file whose checksum is already known.
+    */
+    void writeDigest(const File& file, const std::string& checksum);
+
+    /**
+    * @brief Write the line for a path whose checksum is already known.
+    */
+    void writeDigest(const std::filesystem::path& path, const std::string& checksum);
+
+    /**
+    * @brief Append the line for a path whose checksum is already known to lines,
+    * so that several lines can be written to the stream at once.
+    */
+    void appendDigest(std::string& lines, const std::filesystem::path& path, const std::string& checksum) const;
 
     void attach(Observer* observer) override;
 protected:
@@ -31,4 +65,7 @@ protected:
     void applyAlgorithm(File& file) override;
 private:
     std::unique_ptr<ChecksumCalculator> _hash_strategy;
+    std::unordered_map<FileId, std::string, FileIdHash> _inode_checksums; ///< Of hard-linked files only
+    std::unordered_map<const File*, std::string> _shared_checksums; ///< Of files below shared link targets only
+    std::size_t _shared_depth = 0; ///< Number of shared link targets being walked
 };
\ No newline at end of file
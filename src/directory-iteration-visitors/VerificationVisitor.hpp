@@ -22,6 +22,7 @@ public:
 
     void visitFile(File &file) override;
     void visitDirectory(Directory &dir) override { }
+    bool readsFiles() const override { return true; }
 
     std::map<std::string, VerificationStatus> getResults();
 
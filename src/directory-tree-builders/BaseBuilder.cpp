@@ -11,7 +11,10 @@ void BaseBuilder::startBuildDirectory(const std::filesystem::path& name) {
         _build_stack.push_back(_root.get());
         return;
     }
-    Directory* dir_ptr = _build_stack.back()->createSubdirectory(name);
+    Directory* dir_ptr = dynamic_cast<Directory*>(_build_stack.back()->getChild(name));
+    if (!dir_ptr) {
+        dir_ptr = _build_stack.back()->createSubdirectory(name);
+    }
     _build_stack.push_back(dir_ptr);
 }
 
@@ -21,8 +24,16 @@ void BaseBuilder::endBuildDirectory() {
     }
 }
 
-void BaseBuilder::buildFile(const std::filesystem::path& name) {
-    _build_stack.back()->createFile(name);
+void BaseBuilder::resumeBuildDirectory(Directory& dir) {
+    _build_stack.push_back(&dir);
+}
+
+Directory* BaseBuilder::currentDirectory() const {
+    return _build_stack.empty() ? nullptr : _build_stack.back();
+}
+
+File* BaseBuilder::buildFile(const std::filesystem::path& name) {
+    return _build_stack.back()->createFile(name);
 }
 
 // std::unique_ptr<Directory> BaseBuilder::getTree() {
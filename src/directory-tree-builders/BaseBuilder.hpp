@@ -9,11 +9,19 @@
 class BaseBuilder : public DirectoryStructureBuilder {
 public:
 
+/**
+ * @brief Open a directory for building. If the current directory already
+ * has a subdirectory with this name, building continues inside it.
+ */
 void startBuildDirectory(const std::filesystem::path& name) override;
 
 void endBuildDirectory() override;
 
-void buildFile(const std::filesystem::path& name) override;
+void resumeBuildDirectory(Directory& dir) override;
+
+Directory* currentDirectory() const override;
+
+File* buildFile(const std::filesystem::path& name) override;
 
 // std::unique_ptr<Directory> getTree() override;
 
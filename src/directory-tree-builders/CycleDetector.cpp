@@ -1,25 +1,100 @@
 #include "CycleDetector.hpp"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
 bool CycleDetector::check(const std::filesystem::path& path) {
-    
-    std::filesystem::path canonical;
-    
-    try {
-        canonical = std::filesystem::canonical(path);
-    } 
-    catch (std::filesystem::filesystem_error& e) {
+    auto id = identify(path);
+    if (!id) {
         std::cerr << "Path does not exist" << std::endl;
         return false;
     }
-    catch (...) {
-        std::cerr << "Memory allocation error when calling canonical" << std::endl;
+    return !enter(*id);
+}
+
+std::optional<FileId> CycleDetector::identify(const std::filesystem::path& path) noexcept {
+    FileId id;
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat st {};
+    if (::stat(path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+    id.dev = static_cast<std::uint64_t>(st.st_dev);
+    id.ino = static_cast<std::uint64_t>(st.st_ino);
+#else
+    // Without inode numbers, the canonical path stands in for the identity
+    std::error_code ec;
+    auto canonical = std::filesystem::canonical(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    id.ino = std::hash<std::filesystem::path::string_type>()(canonical.native());
+#endif
+    // The all-zero identity marks empty slots
+    if (isEmpty(id)) {
+        id.ino = 1;
+    }
+    return id;
+}
+
+std::size_t CycleDetector::find(const FileId& id) const noexcept {
+    std::size_t mask = _slots.size() - 1;
+    std::size_t slot = hash(id) & mask;
+    while (!isEmpty(_slots[slot]) && _slots[slot] != id) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+bool CycleDetector::contains(const FileId& id) const noexcept {
+    return !isEmpty(_slots[find(id)]);
+}
+
+bool CycleDetector::enter(const FileId& id) {
+    std::size_t slot = find(id);
+    if (!isEmpty(_slots[slot])) {
         return false;
     }
-    
-    if (_visited_paths.count(canonical)) {
-        return true;
+    // Keep the table at most half full, so probe sequences stay short
+    if ((_size + 1) * 2 > _slots.size()) {
+        grow();
+        slot = find(id);
+    }
+    _slots[slot] = id;
+    ++_size;
+    return true;
+}
+
+void CycleDetector::leave(const FileId& id) noexcept {
+    std::size_t slot = find(id);
+    if (isEmpty(_slots[slot])) {
+        return;
+    }
+    _slots[slot] = FileId();
+    --_size;
+
+    // Shift later entries of the probe sequence back, so no tombstones are needed
+    std::size_t mask = _slots.size() - 1;
+    std::size_t hole = slot;
+    for (std::size_t next = (hole + 1) & mask; !isEmpty(_slots[next]); next = (next + 1) & mask) {
+        std::size_t home = hash(_slots[next]) & mask;
+        // Move the entry unless its home lies cyclically in (hole, next]
+        bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!stays) {
+            _slots[hole] = _slots[next];
+            _slots[next] = FileId();
+            hole = next;
+        }
     }
+}
 
-    _visited_paths.insert(canonical);
-    return false;
+void CycleDetector::grow() {
+    std::vector<FileId> old(_slots.size() * 2);
+    old.swap(_slots);
+    for (const auto& id : old) {
+        if (!isEmpty(id)) {
+            _slots[find(id)] = id;
+        }
+    }
 }
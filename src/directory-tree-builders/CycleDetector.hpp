@@ -1,16 +1,61 @@
 #pragma once
-#include <unordered_set>
+#include <cstdint>
 #include <filesystem>
+#include <optional>
 #include <stdexcept>
 #include <iostream>
+#include <vector>
 #include "DetectionStrategy.hpp"
+#include "file-system-composite/FileId.hpp"
 
 /**
  * @brief Class for tracking circular dependencies between links
+ *
+ * Objects are identified by device and inode, so different spellings of a path
+ * and links to the same target are recognized with a single stat. Identities
+ * are kept in a small open-addressing set; a builder following links keeps
+ * exactly the identities of the current ancestry chain in it (see enter() and
+ * leave()), so only links back into that chain are cycles.
  */
 class CycleDetector : public DetectionStrategy {
 public:
-    bool check(const std::filesystem::path& path);
+    /**
+     * @brief Record the path's target as visited.
+     * @return true if it was visited before; false if it is new or does not exist
+     */
+    bool check(const std::filesystem::path& path) override;
+
+    /**
+     * @return identity of the object the path resolves to, or nothing if it does not exist
+     */
+    static std::optional<FileId> identify(const std::filesystem::path& path) noexcept;
+
+    /**
+     * @brief Add an identity to the set.
+     * @return false if it was already there
+     */
+    bool enter(const FileId& id);
+
+    /**
+     * @brief Remove an identity from the set, if present
+     */
+    void leave(const FileId& id) noexcept;
+
+    bool contains(const FileId& id) const noexcept;
+
+    std::size_t size() const noexcept { return _size; }
+
 private:
-    std::unordered_set<std::filesystem::path> _visited_paths;
-};
\ No newline at end of file
+    /**
+     * @return slot holding id, or the empty slot where it belongs
+     */
+    std::size_t find(const FileId& id) const noexcept;
+    void grow();
+
+    static bool isEmpty(const FileId& slot) noexcept { return slot.dev == 0 && slot.ino == 0; }
+    static std::size_t hash(const FileId& id) noexcept { return FileIdHash()(id); }
+
+    /// Linear probing over a power-of-two table; an all-zero FileId marks an empty slot
+    std::vector<FileId> _slots = std::vector<FileId>(16);
+    std::size_t _size = 0;
+};
@@ -1,13 +1,22 @@
 #include "DirectoryConstructor.hpp"
+#include "DirectoryScanner.hpp"
+#include "ParallelTraversal.hpp"
+#include <algorithm>
 #include <iostream>
 
-DirectoryConstructor::DirectoryConstructor(DirectoryStructureBuilder& builder) : _builder(builder) {
+namespace {
+    /// Frames of the traversal that keep their directory open; outer ones are reopened when resumed
+    constexpr std::size_t MAX_OPEN_FRAMES = 64;
+}
+
+DirectoryConstructor::DirectoryConstructor(DirectoryStructureBuilder& builder, std::size_t threads)
+    : _builder(builder), _threads(threads) {
     // if (!_builder) {
     //     throw std::invalid_argument("Builder provided to DirectoryConstructor cannot be null.");
     // }
 }
 
-void DirectoryConstructor::construct(std::initializer_list<std::filesystem::path> root_paths) {
+void DirectoryConstructor::construct(const std::vector<std::filesystem::path>& root_paths) {
     for (const auto& root_path : root_paths) {
         try {
             if (!std::filesystem::exists(root_path)) {
@@ -16,6 +25,7 @@ void DirectoryConstructor::construct(std::initializer_list<std::filesystem::path
             }
 
             if (std::filesystem::is_directory(root_path)) {
+                _root = root_path;
                 _builder.startBuildDirectory(root_path);
                 traverse(root_path);
                 _builder.endBuildDirectory();
@@ -26,6 +36,7 @@ void DirectoryConstructor::construct(std::initializer_list<std::filesystem::path
                 if (parent_path.empty()) {
                     parent_path = ".";
                 }
+                _root = parent_path;
                 _builder.startBuildDirectory(parent_path);
                 auto target = std::filesystem::read_symlink(root_path);
                 Directory* traversal_target = _builder.buildLink(root_path.filename(), target);
@@ -41,6 +52,7 @@ void DirectoryConstructor::construct(std::initializer_list<std::filesystem::path
                 if (parent_path.empty()) {
                     parent_path = ".";
                 }
+                _root = parent_path;
                 _builder.startBuildDirectory(parent_path);
                 _builder.buildFile(root_path.filename());
                 _builder.endBuildDirectory();
@@ -54,37 +66,329 @@ void DirectoryConstructor::construct(std::initializer_list<std::filesystem::path
     }
 }
 
+void DirectoryConstructor::collectSizes(bool enable) {
+    if (!enable) {
+        _stat_batcher.reset();
+    } else if (!_stat_batcher) {
+        _stat_batcher = std::make_unique<StatBatcher>();
+    }
+}
+
+void DirectoryConstructor::setFilter(EntryFilter filter) {
+    if (filter.empty()) {
+        _filter.reset();
+    } else {
+        _filter = std::make_unique<EntryFilter>(std::move(filter));
+    }
+}
+
+void DirectoryConstructor::setListings(const DirectoryListings* listings) {
+    _listings = listings;
+}
+
+std::filesystem::path DirectoryConstructor::relativePath(const std::filesystem::path& parent, const std::string& name) const {
+    if (!_filter || !_filter->needsPath()) {
+        return {};
+    }
+    return (parent / name).lexically_relative(_root);
+}
+
+void DirectoryConstructor::applyAttributes(File* file, const std::optional<EntryFilter::Attributes>& attributes) {
+    if (file && attributes) {
+        file->setInode(attributes->inode, attributes->links);
+        file->setSize(static_cast<size_t>(attributes->size));
+    }
+}
+
 void DirectoryConstructor::traverse(const std::filesystem::path& currentPath) {
+    if (_threads > 1 && ParallelTraversal::supported()) {
+        if (Directory* current = _builder.currentDirectory()) {
+            traverseParallel(*current);
+            return;
+        }
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    DirectoryHandle dir = DirectoryHandle::open(-1, currentPath);
+    if (dir.isOpen() && traverseAt(std::move(dir), currentPath)) {
+        return;
+    }
+#endif
+
+    traversePaths(currentPath);
+}
+
+void DirectoryConstructor::traversePaths(const std::filesystem::path& rootPath) {
+    // One iterator per directory being listed, innermost last; the builder is inside the innermost one
+    struct PathFrame {
+        std::filesystem::path path;
+        std::filesystem::directory_iterator it;
+    };
+    std::vector<PathFrame> stack;
+    auto enter = [&](const std::filesystem::path& path) {
+        try {
+            stack.push_back(PathFrame{path, std::filesystem::directory_iterator(path)});
+            return true;
+        } catch (const std::filesystem::filesystem_error& e) {
+            std::cerr << "Error accessing directory: " << e.path1()
+                      << ". Reason: " << e.what() << '\n';
+            return false;
+        }
+    };
+
+    enter(rootPath);
+    while (!stack.empty()) {
+        PathFrame& top = stack.back();
+        if (top.it == std::filesystem::directory_iterator()) {
+            stack.pop_back();
+            if (!stack.empty()) {
+                _builder.endBuildDirectory();
+            }
+            continue;
+        }
+
+        std::filesystem::directory_entry entry;
+        std::filesystem::path currentPath = top.path;
+        try {
+            entry = *top.it;
+            ++top.it;
+        } catch (const std::filesystem::filesystem_error& e) {
+            std::cerr << "Error accessing directory: " << e.path1()
+                      << ". Reason: " << e.what() << '\n';
+            top.it = std::filesystem::directory_iterator();
+            continue;
+        }
+
+        try {
+            std::string name = entry.path().filename().string();
+            std::optional<EntryFilter::Attributes> attributes;
+            if (_filter) {
+                auto relative = relativePath(currentPath, name);
+                bool excluded = entry.is_regular_file() && !entry.is_symlink()
+                    ? _filter->excludesFileAt(-1, entry.path(), name, relative, attributes)
+                    : _filter->excludes(name, relative)
+                      || (entry.is_symlink() && _builder.followsLinks()
+                          && _filter->excludesLinkTarget(-1, entry.path(), name, relative));
+                if (excluded) {
+                    continue;
+                }
+            }
 
-    try {
-        for (const auto& entry : std::filesystem::directory_iterator(currentPath)) {
-            
             if (entry.is_symlink()) {
                 try {
                     auto target = std::filesystem::read_symlink(entry.path());
                     auto traversal_target = _builder.buildLink(entry.path().filename(), target);
 
-                    if (traversal_target) {
-                        traverse(traversal_target->getPath().string());
+                    if (traversal_target && !enter(traversal_target->getPath())) {
                         _builder.endBuildDirectory();
                     }
                 } catch (const std::filesystem::filesystem_error& e) {
                     std::cerr << "Warning: Could not process symlink: " << e.path1()
                               << ". Reason: " << e.what() << '\n';
                 }
-            
+
             } else if (entry.is_directory()) {
                 _builder.startBuildDirectory(entry.path().filename());
-                traverse(entry.path());
-                _builder.endBuildDirectory();
-            
+                if (!enter(entry.path())) {
+                    _builder.endBuildDirectory();
+                }
+
             } else if (entry.is_regular_file()) {
-                _builder.buildFile(entry.path().filename());
+                applyAttributes(_builder.buildFile(entry.path().filename()), attributes);
+            }
+        } catch (const std::filesystem::filesystem_error& e) {
+            std::cerr << "Error accessing directory: " << e.path1()
+                      << ". Reason: " << e.what() << '\n';
+        }
+    }
+}
+
+void DirectoryConstructor::traverseParallel(Directory& dir) {
+    ParallelTraversal traversal(_threads, _stat_batcher != nullptr, _filter.get(), _root, _listings);
+    auto links = traversal.run(dir);
+
+    // Links go through the builder, which decides whether (and how) they are followed
+    for (const auto& link : links) {
+        if (_filter && _builder.followsLinks()) {
+            auto path = link.parent->getPath() / link.name;
+            if (_filter->excludesLinkTarget(-1, path, link.name, relativePath(link.parent->getPath(), link.name))) {
+                continue;
+            }
+        }
+        _builder.resumeBuildDirectory(*link.parent);
+        auto traversal_target = _builder.buildLink(link.name, link.target);
+        if (traversal_target) {
+            traverse(traversal_target->getPath().string());
+            _builder.endBuildDirectory();
+        }
+        _builder.endBuildDirectory();
+    }
+}
+
+bool DirectoryConstructor::traverseAt(DirectoryHandle dir, const std::filesystem::path& currentPath) {
+    // Directories being filled, innermost last, instead of one call per level
+    std::vector<TraversalFrame> stack;
+    stack.emplace_back(std::move(dir), currentPath, std::string());
+    if (!listAt(stack.back())) {
+        return false;
+    }
+
+    while (!stack.empty()) {
+        TraversalFrame& top = stack.back();
+        if (top.next == top.subdirs.size()) {
+            stack.pop_back();
+            if (!stack.empty()) {
+                _builder.endBuildDirectory();
             }
+            continue;
+        }
+
+        auto& subdir = top.subdirs[top.next++];
+        auto path = top.path / subdir.name;
+        // Symlinks are opened through the link, like the targets they were built for
+        DirectoryHandle child;
+        if (top.handle.isOpen() || reopenTop(stack)) {
+            child = DirectoryHandle::open(top.handle.fd(), subdir.name);
+        }
+        _builder.resumeBuildDirectory(*subdir.dir);
+        if (!child.isOpen()) {
+            // Out of descriptors or no permission: the path-based walk reports the error
+            traversePaths(path);
+            _builder.endBuildDirectory();
+            continue;
+        }
+
+        std::string name = subdir.name; // subdir is moved along if the stack grows
+        stack.emplace_back(std::move(child), std::move(path), std::move(name));
+        if (!listAt(stack.back())) {
+            path = stack.back().path;
+            stack.pop_back();
+            traversePaths(path);
+            _builder.endBuildDirectory();
+            continue;
+        }
+
+        // Deep trees would otherwise hold one descriptor per level; the first frame
+        // stays open, so closed ones can always be reopened relative to it
+        if (stack.size() > MAX_OPEN_FRAMES + 1) {
+            stack[stack.size() - 1 - MAX_OPEN_FRAMES].handle.close();
+        }
+    }
+    return true;
+}
+
+bool DirectoryConstructor::reopenTop(std::vector<TraversalFrame>& stack) {
+    std::size_t open = stack.size() - 1;
+    while (open > 0 && !stack[open].handle.isOpen()) {
+        --open;
+    }
+    if (!stack[open].handle.isOpen()) {
+        return false;
+    }
+
+    // Only the top frame keeps its handle; the ones in between stay closed
+    DirectoryHandle dir;
+    int parent = stack[open].handle.fd();
+    for (std::size_t i = open + 1; i < stack.size(); ++i) {
+        dir = DirectoryHandle::open(parent, stack[i].name);
+        if (!dir.isOpen()) {
+            return false;
+        }
+        parent = dir.fd();
+    }
+    stack.back().handle = std::move(dir);
+    return true;
+}
+
+bool DirectoryConstructor::listAt(TraversalFrame& frame) {
+    const DirectoryHandle& dir = frame.handle;
+    const std::filesystem::path& currentPath = frame.path;
+    std::vector<ScannedEntry> entries;
+    auto collect = [&](const ScannedEntry& entry) {
+        entries.push_back(entry);
+    };
+    bool listed = _listings ? _listings->list(dir, currentPath, collect)
+                            : DirectoryScanner::scan(dir, currentPath, collect);
+    // A listing that failed partway is redone by path; entries built now would be built twice
+    if (!listed) {
+        return false;
+    }
+
+    // Listings come in hash order; in inode order, stats and opens read the inode table mostly sequentially
+    std::stable_sort(entries.begin(), entries.end(), [](const ScannedEntry& a, const ScannedEntry& b) {
+        return a.ino < b.ino;
+    });
+
+    std::vector<bool> excluded(entries.size(), false);
+    std::vector<std::optional<EntryFilter::Attributes>> attributes(entries.size());
+    if (_filter) {
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const auto& entry = entries[i];
+            auto relative = relativePath(currentPath, entry.name);
+            excluded[i] = entry.type == ScannedEntry::Type::File
+                ? _filter->excludesFileAt(dir.fd(), entry.name, entry.name, relative, attributes[i])
+                : _filter->excludes(entry.name, relative)
+                  || (entry.type == ScannedEntry::Type::Symlink && _builder.followsLinks()
+                      && _filter->excludesLinkTarget(dir.fd(), entry.name, entry.name, relative));
+        }
+    }
+
+    // In name order every child is appended at the end of its directory's sorted children
+    std::vector<std::size_t> by_name;
+    by_name.reserve(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (!excluded[i]) {
+            by_name.push_back(i);
+        }
+    }
+    std::sort(by_name.begin(), by_name.end(), [&entries](std::size_t a, std::size_t b) {
+        return entries[a].name < entries[b].name;
+    });
+
+    // Directories and link targets are created now and filled afterwards, in inode order
+    std::vector<File*> files(entries.size(), nullptr);
+    std::vector<Directory*> subdirs(entries.size(), nullptr);
+    for (std::size_t i : by_name) {
+        const auto& entry = entries[i];
+        switch (entry.type) {
+            case ScannedEntry::Type::Symlink:
+                subdirs[i] = _builder.buildLink(entry.name, entry.link_target);
+                if (subdirs[i]) {
+                    _builder.endBuildDirectory();
+                }
+                break;
+            case ScannedEntry::Type::Directory:
+                _builder.startBuildDirectory(entry.name);
+                subdirs[i] = _builder.currentDirectory();
+                _builder.endBuildDirectory();
+                break;
+            case ScannedEntry::Type::File:
+                files[i] = _builder.buildFile(entry.name);
+                break;
+        }
+    }
+
+    std::vector<File*> unsized;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        File* file = files[i];
+        // Otherwise the size is stat'ed only when something asks for it
+        if (file && attributes[i]) {
+            applyAttributes(file, attributes[i]);
+        } else if (file && entries[i].size) {
+            file->setInode(entries[i].inode, entries[i].links);
+            file->setSize(static_cast<size_t>(*entries[i].size));
+        } else if (file && _stat_batcher) {
+            unsized.push_back(file);
+        }
+    }
+    if (_stat_batcher) {
+        _stat_batcher->fillSizes(dir.fd(), unsized);
+    }
 
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (subdirs[i]) {
+            frame.subdirs.push_back(TraversalFrame::Subdirectory{subdirs[i], std::move(entries[i].name)});
         }
-    } catch (const std::filesystem::filesystem_error& e) {
-        std::cerr << "Error accessing directory: " << e.path1()
-                  << ". Reason: " << e.what() << '\n';
     }
+    return true;
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 #include "DirectoryStructureBuilder.hpp"
-#include <initializer_list>
+#include "DirectoryListings.hpp"
+#include "EntryFilter.hpp"
+#include "StatBatcher.hpp"
+#include "file-system-composite/DirectoryHandle.hpp"
+#include <vector>
 
 /**
  * @brief Director class in the Builder structure
@@ -8,12 +12,112 @@
  */
 class DirectoryConstructor {
 public:
-    explicit DirectoryConstructor(DirectoryStructureBuilder& builder);
+    /**
+     * @param builder Builder that creates the composite.
+     * @param threads Number of threads listing directories; more than one enables
+     * the parallel traversal, which builds the same tree as the serial one.
+     */
+    explicit DirectoryConstructor(DirectoryStructureBuilder& builder, std::size_t threads = 1);
 
-    void construct(std::initializer_list<std::filesystem::path> rootPaths);
+    /**
+     * @brief Build the tree of each root path, in order, through the same builder.
+     * To get one tree per root, construct each root with its own builder.
+     */
+    void construct(const std::vector<std::filesystem::path>& root_paths);
+
+    /**
+     * @brief Record the size of every file while the tree is built, in batches
+     * (see StatBatcher), instead of one stat whenever a size is first asked for.
+     */
+    void collectSizes(bool enable);
+
+    /**
+     * @brief Skip the entries filter excludes. Excluded directories and links are
+     * neither opened nor followed; the root paths themselves are never filtered.
+     */
+    void setFilter(EntryFilter filter);
+
+    /**
+     * @brief Take the entries of directories unchanged since listings were made
+     * from listings instead of listing them again (non-owning, may be nullptr).
+     * Listings are only used where directories are listed through handles.
+     */
+    void setListings(const DirectoryListings* listings);
 
 private:
+    /**
+     * @brief A directory whose entries are built, with the subdirectories still
+     * to be filled. Traversals keep these on an explicit stack rather than
+     * recursing once per level, so deep trees do not overflow the call stack.
+     * The stack is local to one traverseAt() call: a traversal cannot be paused
+     * or split between threads through it.
+     */
+    struct TraversalFrame {
+        struct Subdirectory {
+            Directory* dir;   ///< Directory or followed link target, already built
+            std::string name; ///< Entry name, relative to the frame's directory
+        };
+
+        TraversalFrame(DirectoryHandle handle, std::filesystem::path path, std::string name)
+            : handle(std::move(handle)), path(std::move(path)), name(std::move(name)) {}
+
+        DirectoryHandle handle; ///< Closed for frames far below the top; reopened when resumed
+        std::filesystem::path path;
+        std::string name;      ///< Entry name in the frame below, empty for the first frame
+        std::vector<Subdirectory> subdirs; ///< In inode order
+        std::size_t next = 0;  ///< First subdirectory not filled yet
+    };
+
     void traverse(const std::filesystem::path& path);
 
+    /**
+     * @brief Traverse with std::filesystem, where directories cannot be opened as handles.
+     */
+    void traversePaths(const std::filesystem::path& path);
+
+    /**
+     * @brief Traverse an already opened directory. Entries are stat'ed and
+     * subdirectories opened relative to the handle (fstatat/openat).
+     * @return false if the directory could not be listed; the caller falls back to traverse()
+     */
+    bool traverseAt(DirectoryHandle dir, const std::filesystem::path& path);
+
+    /**
+     * @brief List the directory of frame and build its entries in the builder's
+     * current directory, recording the subdirectories to fill.
+     * @return false if the directory could not be listed to the end; nothing is
+     * built then, so the caller can list it again from the start
+     */
+    bool listAt(TraversalFrame& frame);
+
+    /**
+     * @brief Reopen the closed handle of the top frame, one name at a time from
+     * the nearest frame that is still open, so paths longer than PATH_MAX work.
+     * @return false if a directory on the way cannot be opened
+     */
+    static bool reopenTop(std::vector<TraversalFrame>& stack);
+
+    /**
+     * @brief List the directory the builder is currently in, and everything below it,
+     * on a work-stealing pool; symlinks are then built serially through the builder.
+     */
+    void traverseParallel(Directory& dir);
+
+    /**
+     * @return path of entry name of directory parent relative to the root being
+     * constructed, or an empty path if the filter does not look at paths
+     */
+    std::filesystem::path relativePath(const std::filesystem::path& parent, const std::string& name) const;
+
+    /**
+     * @brief Record what the filter stat'ed, so the size is not stat'ed again.
+     */
+    static void applyAttributes(File* file, const std::optional<EntryFilter::Attributes>& attributes);
+
     DirectoryStructureBuilder& _builder;
+    std::size_t _threads;
+    std::unique_ptr<StatBatcher> _stat_batcher; ///< Set when sizes are collected
+    std::unique_ptr<EntryFilter> _filter; ///< Set when entries are filtered
+    std::filesystem::path _root; ///< Directory holding the root path being constructed, or the root itself
+    const DirectoryListings* _listings = nullptr; ///< Listings of an earlier run, if set
 };
\ No newline at end of file
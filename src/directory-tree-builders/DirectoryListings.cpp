@@ -0,0 +1,51 @@
+#include "DirectoryListings.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+void DirectoryListings::add(const Stamp& stamp, std::vector<ScannedEntry> entries) {
+    _listings[stamp.id] = Listing{stamp.mtime, stamp.ctime, std::move(entries)};
+}
+
+bool DirectoryListings::list(const DirectoryHandle& dir, const std::filesystem::path& path,
+                             const DirectoryScanner::EntryConsumer& consumer) const {
+    Stamp stamp;
+    if (!_listings.empty() && stampOf(dir.fd(), stamp)) {
+        auto cached = _listings.find(stamp.id);
+        if (cached != _listings.end() && cached->second.mtime == stamp.mtime && cached->second.ctime == stamp.ctime) {
+            _reused.fetch_add(1, std::memory_order_relaxed);
+            for (const auto& entry : cached->second.entries) {
+                consumer(entry);
+            }
+            return true;
+        }
+    }
+
+    _relisted.fetch_add(1, std::memory_order_relaxed);
+    return DirectoryScanner::scan(dir, path, consumer);
+}
+
+bool DirectoryListings::stampOf(int dir_fd, Stamp& stamp) {
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat st {};
+    if (dir_fd < 0 || ::fstat(dir_fd, &st) != 0) {
+        return false;
+    }
+#ifdef __APPLE__
+    const struct timespec& mtime = st.st_mtimespec;
+    const struct timespec& ctime = st.st_ctimespec;
+#else
+    const struct timespec& mtime = st.st_mtim;
+    const struct timespec& ctime = st.st_ctim;
+#endif
+    stamp.id = FileId{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)};
+    stamp.mtime = static_cast<std::int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec;
+    stamp.ctime = static_cast<std::int64_t>(ctime.tv_sec) * 1000000000 + ctime.tv_nsec;
+    return true;
+#else
+    (void)dir_fd;
+    (void)stamp;
+    return false;
+#endif
+}
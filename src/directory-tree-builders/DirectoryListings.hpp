@@ -0,0 +1,71 @@
+#pragma once
+#include "DirectoryScanner.hpp"
+#include "file-system-composite/FileId.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class DirectoryListings
+ * @brief Listings of directories from an earlier run, reused while the
+ * directories have not changed since.
+ *
+ * Adding or removing an entry updates its directory's mtime and ctime, so a
+ * directory whose identity, mtime and ctime are those of its cached listing
+ * still holds the same entries. Such a directory is not listed again; the other
+ * ones are. Only names, types and link targets are cached: files are stat'ed as
+ * they would be after a fresh listing.
+ *
+ * Listings are filled before a traversal and only read during it, so list()
+ * may be called from several threads.
+ */
+class DirectoryListings {
+public:
+    /**
+     * @brief When and how a directory was last changed.
+     */
+    struct Stamp {
+        FileId id;
+        std::int64_t mtime = 0; ///< Nanoseconds since the epoch
+        std::int64_t ctime = 0; ///< Nanoseconds since the epoch
+    };
+
+    /**
+     * @brief Cache the entries of the directory stamp describes.
+     */
+    void add(const Stamp& stamp, std::vector<ScannedEntry> entries);
+
+    /**
+     * @brief List a directory: from its cached listing if it is unchanged, with
+     * DirectoryScanner otherwise.
+     * @return false if the directory could not be listed.
+     */
+    bool list(const DirectoryHandle& dir, const std::filesystem::path& path,
+              const DirectoryScanner::EntryConsumer& consumer) const;
+
+    /**
+     * @brief Stat an open directory (always false on non-POSIX platforms).
+     */
+    static bool stampOf(int dir_fd, Stamp& stamp);
+
+    bool empty() const { return _listings.empty(); }
+
+    /// @return directories listed from the cache so far
+    std::size_t reused() const { return _reused.load(std::memory_order_relaxed); }
+
+    /// @return directories listed again so far
+    std::size_t relisted() const { return _relisted.load(std::memory_order_relaxed); }
+
+private:
+    struct Listing {
+        std::int64_t mtime = 0;
+        std::int64_t ctime = 0;
+        std::vector<ScannedEntry> entries;
+    };
+
+    std::unordered_map<FileId, Listing, FileIdHash> _listings;
+    mutable std::atomic<std::size_t> _reused{0};
+    mutable std::atomic<std::size_t> _relisted{0};
+};
@@ -0,0 +1,246 @@
+#include "DirectoryScanner.hpp"
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <vector>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace {
+#ifdef __linux__
+    /// Record layout returned by getdents64
+    struct LinuxDirent64 {
+        std::uint64_t d_ino;
+        std::int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    /// Enough for a few thousand entries per syscall
+    constexpr std::size_t GETDENTS_BUFFER = 256 * 1024;
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    bool isDotOrDotDot(const char* name) {
+        return std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0;
+    }
+#endif
+}
+
+bool DirectoryScanner::scan(const DirectoryHandle& dir, const std::filesystem::path& path, const EntryConsumer& consumer) {
+#ifdef __linux__
+    return scanGetdents(dir, path, consumer);
+#else
+    return scanReaddir(dir, path, consumer);
+#endif
+}
+
+bool DirectoryScanner::scanPath(const std::filesystem::path& path, const EntryConsumer& consumer) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(path, ec);
+    ScannedEntry scanned;
+    for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        auto status = it->symlink_status(ec);
+        if (ec) {
+            // Removed while being listed
+            ec.clear();
+            continue;
+        }
+
+        scanned.name = it->path().filename().string();
+        scanned.size.reset();
+        scanned.link_target.clear();
+        if (std::filesystem::is_symlink(status)) {
+            scanned.type = ScannedEntry::Type::Symlink;
+            scanned.link_target = std::filesystem::read_symlink(it->path(), ec).string();
+            if (ec) {
+                std::cerr << "Warning: Could not process symlink: " << it->path()
+                          << ". Reason: " << ec.message() << '\n';
+                ec.clear();
+                continue;
+            }
+        } else if (std::filesystem::is_directory(status)) {
+            scanned.type = ScannedEntry::Type::Directory;
+        } else if (std::filesystem::is_regular_file(status)) {
+            scanned.type = ScannedEntry::Type::File;
+        } else {
+            continue;
+        }
+        consumer(scanned);
+    }
+    if (ec) {
+        std::cerr << "Error accessing directory: " << path << ". Reason: " << ec.message() << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool DirectoryScanner::statEntry(int dir_fd, ScannedEntry& entry) {
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat st {};
+    if (::fstatat(dir_fd, entry.name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    if (S_ISLNK(st.st_mode)) {
+        entry.type = ScannedEntry::Type::Symlink;
+    } else if (S_ISDIR(st.st_mode)) {
+        entry.type = ScannedEntry::Type::Directory;
+    } else if (S_ISREG(st.st_mode)) {
+        entry.type = ScannedEntry::Type::File;
+        entry.size = static_cast<std::uint64_t>(st.st_size);
+        entry.inode = FileId{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)};
+        entry.links = static_cast<std::uint64_t>(st.st_nlink);
+    } else {
+        return false;
+    }
+    return true;
+#else
+    (void)dir_fd;
+    (void)entry;
+    return false;
+#endif
+}
+
+bool DirectoryScanner::readLink(int dir_fd, const std::filesystem::path& path, ScannedEntry& entry) {
+#if defined(__unix__) || defined(__APPLE__)
+    std::vector<char> target(PATH_MAX);
+    while (true) {
+        ssize_t length = ::readlinkat(dir_fd, entry.name.c_str(), target.data(), target.size());
+        if (length < 0) {
+            std::cerr << "Warning: Could not process symlink: " << path / entry.name
+                      << ". Reason: " << std::strerror(errno) << '\n';
+            return false;
+        }
+        // A full buffer may mean a truncated target
+        if (static_cast<std::size_t>(length) < target.size()) {
+            entry.link_target.assign(target.data(), static_cast<std::size_t>(length));
+            return true;
+        }
+        target.resize(target.size() * 2);
+    }
+#else
+    (void)dir_fd;
+    (void)path;
+    (void)entry;
+    return false;
+#endif
+}
+
+bool DirectoryScanner::scanGetdents(const DirectoryHandle& dir, const std::filesystem::path& path, const EntryConsumer& consumer) {
+#ifdef __linux__
+    if (!dir.isOpen() || ::lseek(dir.fd(), 0, SEEK_SET) < 0) {
+        return false;
+    }
+
+    std::vector<char> buffer(GETDENTS_BUFFER);
+    ScannedEntry scanned;
+    while (true) {
+        long got = ::syscall(SYS_getdents64, dir.fd(), buffer.data(), buffer.size());
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            // Not supported by the filesystem: let readdir try
+            return (errno == ENOSYS || errno == EINVAL) && scanReaddir(dir, path, consumer);
+        }
+        if (got == 0) {
+            return true;
+        }
+
+        for (long offset = 0; offset < got;) {
+            const auto* entry = reinterpret_cast<const LinuxDirent64*>(buffer.data() + offset);
+            offset += entry->d_reclen;
+            if (isDotOrDotDot(entry->d_name)) {
+                continue;
+            }
+
+            scanned.name = entry->d_name;
+            scanned.ino = entry->d_ino;
+            scanned.size.reset();
+            scanned.link_target.clear();
+            switch (entry->d_type) {
+                case DT_REG: scanned.type = ScannedEntry::Type::File; break;
+                case DT_DIR: scanned.type = ScannedEntry::Type::Directory; break;
+                case DT_LNK: scanned.type = ScannedEntry::Type::Symlink; break;
+                case DT_UNKNOWN:
+                    if (!statEntry(dir.fd(), scanned)) continue;
+                    break;
+                default:
+                    continue;
+            }
+            if (scanned.type == ScannedEntry::Type::Symlink && !readLink(dir.fd(), path, scanned)) {
+                continue;
+            }
+            consumer(scanned);
+        }
+    }
+#else
+    (void)dir;
+    (void)path;
+    (void)consumer;
+    return false;
+#endif
+}
+
+bool DirectoryScanner::scanReaddir(const DirectoryHandle& dir, const std::filesystem::path& path, const EntryConsumer& consumer) {
+#if defined(__unix__) || defined(__APPLE__)
+    // fdopendir takes ownership of the descriptor it is given
+    int list_fd = dir.isOpen() ? ::dup(dir.fd()) : -1;
+    DIR* stream = list_fd >= 0 ? ::fdopendir(list_fd) : nullptr;
+    if (!stream) {
+        if (list_fd >= 0) ::close(list_fd);
+        return false;
+    }
+    ::rewinddir(stream);
+
+    ScannedEntry scanned;
+    while (true) {
+        // readdir signals both the end and a failure with nullptr; only errno tells them apart
+        errno = 0;
+        dirent* entry = ::readdir(stream);
+        if (!entry) {
+            break;
+        }
+        if (isDotOrDotDot(entry->d_name)) {
+            continue;
+        }
+
+        scanned.name = entry->d_name;
+        scanned.ino = static_cast<std::uint64_t>(entry->d_ino);
+        scanned.size.reset();
+        scanned.link_target.clear();
+        if (!statEntry(dir.fd(), scanned)) {
+            continue;
+        }
+        if (scanned.type == ScannedEntry::Type::Symlink && !readLink(dir.fd(), path, scanned)) {
+            continue;
+        }
+
+        try {
+            consumer(scanned);
+        } catch (...) {
+            ::closedir(stream);
+            throw;
+        }
+    }
+
+    int read_errno = errno;
+    ::closedir(stream);
+    errno = read_errno;
+    return read_errno == 0;
+#else
+    (void)dir;
+    (void)path;
+    (void)consumer;
+    return false;
+#endif
+}
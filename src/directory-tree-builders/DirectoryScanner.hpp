@@ -0,0 +1,73 @@
+#pragma once
+#include "file-system-composite/DirectoryHandle.hpp"
+#include "file-system-composite/FileId.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+
+/**
+ * @brief One entry of a scanned directory.
+ */
+struct ScannedEntry {
+    enum class Type { File, Directory, Symlink };
+
+    std::string name;        ///< Entry name, without the directory path
+    Type type = Type::File;
+    std::uint64_t ino = 0;   ///< Inode number reported by the listing (d_ino), 0 if unknown
+    std::optional<std::uint64_t> size; ///< Size of regular files, if the scan needed a stat anyway
+    FileId inode;            ///< Set together with size
+    std::uint64_t links = 0; ///< Number of names of the inode, set together with size
+    std::string link_target; ///< Target of symlinks
+};
+
+/**
+ * @class DirectoryScanner
+ * @brief Lists a directory through an open handle.
+ *
+ * On Linux entries are read in large getdents64 batches and classified by
+ * their d_type, so no stat is needed unless the filesystem does not report
+ * the type. Elsewhere, entries are listed with readdir and stat'ed relative to
+ * the handle (fstatat). Symlinks are read with readlinkat.
+ *
+ * Entries other than regular files, directories and symlinks are skipped,
+ * as are entries removed while the directory is being listed.
+ */
+class DirectoryScanner {
+public:
+    using EntryConsumer = std::function<void(const ScannedEntry& entry)>;
+
+    /**
+     * @param dir Open handle of the directory.
+     * @param path Path of the directory, used in warnings.
+     * @param consumer Called with each entry, in directory order.
+     * @return false, with errno set, if the directory could not be listed or the
+     * listing failed partway (always false on non-POSIX platforms).
+     */
+    static bool scan(const DirectoryHandle& dir, const std::filesystem::path& path, const EntryConsumer& consumer);
+
+    /**
+     * @brief List a directory by its path with std::filesystem, for when listing
+     * through a handle failed. Sizes and inode numbers are left unknown.
+     * @return false (after a warning) if the listing failed partway; entries
+     * passed to the consumer until then are not taken back.
+     */
+    static bool scanPath(const std::filesystem::path& path, const EntryConsumer& consumer);
+
+private:
+    static bool scanGetdents(const DirectoryHandle& dir, const std::filesystem::path& path, const EntryConsumer& consumer);
+    static bool scanReaddir(const DirectoryHandle& dir, const std::filesystem::path& path, const EntryConsumer& consumer);
+
+    /**
+     * @brief Complete an entry of unknown type with fstatat.
+     * @return false if the entry should be skipped.
+     */
+    static bool statEntry(int dir_fd, ScannedEntry& entry);
+
+    /**
+     * @brief Read the target of a symlink entry with readlinkat.
+     * @return false (after a warning) if it cannot be read.
+     */
+    static bool readLink(int dir_fd, const std::filesystem::path& path, ScannedEntry& entry);
+};
@@ -23,9 +23,26 @@ public:
     
     virtual void endBuildDirectory() {}
 
+    /**
+     * @brief Continue building inside a directory that is already part of the tree.
+     * Ended with endBuildDirectory().
+     */
+    virtual void resumeBuildDirectory(Directory& dir) {}
+
+    /**
+     * @return the directory currently being built, or nullptr
+     */
+    virtual Directory* currentDirectory() const { return nullptr; }
+
     virtual Directory* buildLink(const std::filesystem::path& name, const std::filesystem::path& target) { return nullptr; }
 
-    virtual void buildFile(const std::filesystem::path& name) {}
+    /**
+     * @return true if buildLink() resolves links to their targets, so links to
+     * files stand for those files
+     */
+    virtual bool followsLinks() const { return false; }
+
+    virtual File* buildFile(const std::filesystem::path& name) { return nullptr; }
 
     // virtual std::unique_ptr<Directory> getTree() const { return nullptr; }
 
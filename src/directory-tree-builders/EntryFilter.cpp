@@ -0,0 +1,337 @@
+#include "EntryFilter.hpp"
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <chrono>
+#endif
+
+namespace {
+    bool hasWildcard(const std::string& glob, std::size_t from, std::size_t to) {
+        return glob.find_first_of("*?[", from) < to;
+    }
+
+    bool endsWith(const std::string& text, const std::string& suffix) {
+        return text.size() >= suffix.size()
+            && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    /// Path globs are anchored at the root: a leading or trailing '/' adds nothing
+    std::string trimSlashes(const std::string& glob) {
+        auto first = glob.find_first_not_of('/');
+        if (first == std::string::npos) {
+            return {};
+        }
+        auto last = glob.find_last_not_of('/');
+        return glob.substr(first, last - first + 1);
+    }
+
+    bool isPathGlob(const std::string& glob) {
+        return glob.find('/') != std::string::npos;
+    }
+}
+
+void EntryFilter::NameGlobs::add(const std::string& glob) {
+    if (!hasWildcard(glob, 0, glob.size())) {
+        literals.insert(glob);
+    } else if (glob.size() > 1 && glob.front() == '*' && !hasWildcard(glob, 1, glob.size())) {
+        suffixes.push_back(glob.substr(1));
+    } else if (glob.size() > 1 && glob.back() == '*' && !hasWildcard(glob, 0, glob.size() - 1)) {
+        prefixes.push_back(glob.substr(0, glob.size() - 1));
+    } else {
+        wildcards.push_back(glob);
+    }
+}
+
+bool EntryFilter::NameGlobs::empty() const {
+    return literals.empty() && suffixes.empty() && prefixes.empty() && wildcards.empty();
+}
+
+bool EntryFilter::NameGlobs::matches(const std::string& name) const {
+    if (literals.count(name) > 0) {
+        return true;
+    }
+    for (const auto& suffix : suffixes) {
+        if (endsWith(name, suffix)) return true;
+    }
+    for (const auto& prefix : prefixes) {
+        if (name.compare(0, prefix.size(), prefix) == 0) return true;
+    }
+    for (const auto& glob : wildcards) {
+        if (matchesGlob(glob.c_str(), name.c_str(), false)) return true;
+    }
+    return false;
+}
+
+void EntryFilter::exclude(const std::string& glob) {
+    if (isPathGlob(glob)) {
+        _exclude_paths.push_back(trimSlashes(glob));
+    } else {
+        _exclude_names.add(glob);
+    }
+}
+
+void EntryFilter::include(const std::string& glob) {
+    if (isPathGlob(glob)) {
+        _include_paths.push_back(trimSlashes(glob));
+    } else {
+        _include_names.add(glob);
+    }
+}
+
+void EntryFilter::excludeRegex(const std::string& expression) {
+    _regexes.emplace_back(expression, std::regex::ECMAScript | std::regex::optimize);
+}
+
+void EntryFilter::maxSize(std::uint64_t bytes) {
+    _max_size = bytes;
+}
+
+void EntryFilter::modifiedSince(std::int64_t seconds) {
+    _modified_since = seconds;
+}
+
+bool EntryFilter::empty() const {
+    return _exclude_names.empty() && _exclude_paths.empty() && _regexes.empty()
+        && _include_names.empty() && _include_paths.empty()
+        && !_max_size && !_modified_since;
+}
+
+bool EntryFilter::excludes(const std::string& name, const std::filesystem::path& relative) const {
+    return excludedByPattern(name, relative);
+}
+
+bool EntryFilter::excludesFile(const std::string& name, const std::filesystem::path& relative,
+                               const Attributes* attributes) const {
+    // Without a stat there is nothing to compare; the file is kept
+    return excludedByName(name, relative) || (attributes && excludedByAttributes(*attributes));
+}
+
+bool EntryFilter::excludesFileAt(int dir_fd, const std::filesystem::path& stat_path, const std::string& name,
+                                 const std::filesystem::path& relative, std::optional<Attributes>& attributes) const {
+    attributes.reset();
+    // Names first, so files the patterns drop are not stat'ed
+    if (excludedByName(name, relative)) {
+        return true;
+    }
+    if (!needsAttributes()) {
+        return false;
+    }
+    Attributes read;
+    if (!readAttributes(dir_fd, stat_path, read)) {
+        return false;
+    }
+    attributes = read;
+    return excludedByAttributes(read);
+}
+
+bool EntryFilter::excludesLinkTarget(int dir_fd, const std::filesystem::path& stat_path, const std::string& name,
+                                     const std::filesystem::path& relative) const {
+    if (_include_names.empty() && _include_paths.empty() && !needsAttributes()) {
+        return false;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat st {};
+    if (::fstatat(dir_fd >= 0 ? dir_fd : AT_FDCWD, stat_path.c_str(), &st, 0) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    Attributes target;
+    target.size = static_cast<std::uint64_t>(st.st_size);
+    target.mtime = static_cast<std::int64_t>(st.st_mtime);
+    return excludesFile(name, relative, &target);
+#else
+    (void)dir_fd;
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(stat_path, ec)) {
+        return false;
+    }
+    Attributes target;
+    return excludesFile(name, relative, readAttributes(-1, stat_path, target) ? &target : nullptr);
+#endif
+}
+
+bool EntryFilter::excludedByName(const std::string& name, const std::filesystem::path& relative) const {
+    if (excludedByPattern(name, relative)) {
+        return true;
+    }
+    if (_include_names.empty() && _include_paths.empty()) {
+        return false;
+    }
+    if (_include_names.matches(name)) {
+        return false;
+    }
+    std::string path = relative.generic_string();
+    for (const auto& glob : _include_paths) {
+        if (matchesGlob(glob.c_str(), path.c_str(), true)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EntryFilter::excludedByAttributes(const Attributes& attributes) const {
+    if (_max_size && attributes.size > *_max_size) {
+        return true;
+    }
+    return _modified_since && attributes.mtime < *_modified_since;
+}
+
+bool EntryFilter::excludedByPattern(const std::string& name, const std::filesystem::path& relative) const {
+    if (_exclude_names.matches(name)) {
+        return true;
+    }
+    if (_exclude_paths.empty() && _regexes.empty()) {
+        return false;
+    }
+
+    std::string path = relative.generic_string();
+    for (const auto& glob : _exclude_paths) {
+        if (matchesGlob(glob.c_str(), path.c_str(), true)) return true;
+    }
+    for (const auto& regex : _regexes) {
+        if (std::regex_search(path, regex)) return true;
+    }
+    return false;
+}
+
+bool EntryFilter::matchesGlob(const char* glob, const char* text, bool path) {
+    while (*glob) {
+        if (*glob == '*') {
+            // In paths a single '*' stays within one component
+            bool crosses = !path || glob[1] == '*';
+            while (*glob == '*') ++glob;
+            for (const char* rest = text;; ++rest) {
+                if (matchesGlob(glob, rest, path)) return true;
+                if (!*rest || (!crosses && *rest == '/')) return false;
+            }
+        }
+        if (!*text || (path && *text == '/' && *glob != '/')) {
+            return false;
+        }
+
+        if (*glob == '[') {
+            const char* end = glob + 1;
+            if (*end == '!' || *end == '^') ++end;
+            if (*end == ']') ++end;
+            while (*end && *end != ']') ++end;
+
+            if (*end) {
+                const char* c = glob + 1;
+                bool negated = *c == '!' || *c == '^';
+                if (negated) ++c;
+                bool matched = false;
+                while (c < end) {
+                    if (c + 2 < end && c[1] == '-') {
+                        matched = matched || (*text >= c[0] && *text <= c[2]);
+                        c += 3;
+                    } else {
+                        matched = matched || *text == *c;
+                        ++c;
+                    }
+                }
+                if (matched == negated) return false;
+                glob = end + 1;
+                ++text;
+                continue;
+            }
+            // No closing bracket: '[' is an ordinary character
+        }
+
+        if (*glob != '?' && *glob != *text) {
+            return false;
+        }
+        ++glob;
+        ++text;
+    }
+    return !*text;
+}
+
+bool EntryFilter::readAttributes(int dir_fd, const std::filesystem::path& name, Attributes& attributes) {
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat st {};
+    if (::fstatat(dir_fd >= 0 ? dir_fd : AT_FDCWD, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    attributes.size = static_cast<std::uint64_t>(st.st_size);
+    attributes.mtime = static_cast<std::int64_t>(st.st_mtime);
+    attributes.inode = FileId{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)};
+    attributes.links = static_cast<std::uint64_t>(st.st_nlink);
+    return true;
+#else
+    (void)dir_fd;
+    std::error_code ec;
+    auto size = std::filesystem::file_size(name, ec);
+    if (ec) return false;
+    auto written = std::filesystem::last_write_time(name, ec);
+    if (ec) return false;
+    // The file clock has no fixed epoch before C++20; convert through the current time
+    auto now = std::chrono::system_clock::now()
+        + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            written - std::filesystem::file_time_type::clock::now());
+    attributes.size = static_cast<std::uint64_t>(size);
+    attributes.mtime = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    return true;
+#endif
+}
+
+std::optional<std::uint64_t> EntryFilter::parseSize(const std::string& text) {
+    std::size_t digits = 0;
+    while (digits < text.size() && std::isdigit(static_cast<unsigned char>(text[digits]))) {
+        ++digits;
+    }
+    if (digits == 0 || digits > 19) {
+        return std::nullopt;
+    }
+
+    std::uint64_t value = std::stoull(text.substr(0, digits));
+    std::string unit = text.substr(digits);
+    if (!unit.empty() && (unit.back() == 'B' || unit.back() == 'b')) {
+        unit.pop_back();
+    }
+    if (unit.size() == 2 && (unit[1] == 'i' || unit[1] == 'I')) {
+        unit.pop_back();
+    }
+    if (unit.size() > 1) {
+        return std::nullopt;
+    }
+
+    unsigned shift = 0;
+    if (!unit.empty()) {
+        switch (std::toupper(static_cast<unsigned char>(unit[0]))) {
+            case 'K': shift = 10; break;
+            case 'M': shift = 20; break;
+            case 'G': shift = 30; break;
+            case 'T': shift = 40; break;
+            default: return std::nullopt;
+        }
+    }
+    if (shift > 0 && value > (std::numeric_limits<std::uint64_t>::max() >> shift)) {
+        return std::nullopt;
+    }
+    return value << shift;
+}
+
+std::optional<std::int64_t> EntryFilter::parseTime(const std::string& text) {
+    for (const char* format : {"%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%d"}) {
+        std::tm tm {};
+        std::istringstream in(text);
+        in >> std::get_time(&tm, format);
+        if (in.fail() || in.peek() != std::char_traits<char>::eof()) {
+            continue;
+        }
+        tm.tm_isdst = -1;
+        std::time_t seconds = std::mktime(&tm);
+        if (seconds == static_cast<std::time_t>(-1)) {
+            return std::nullopt;
+        }
+        return static_cast<std::int64_t>(seconds);
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include "file-system-composite/FileId.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <regex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @class EntryFilter
+ * @brief Decides which entries a traversal skips, from include/exclude patterns
+ * and file size and modification time limits.
+ *
+ * Patterns are compiled when they are added. A glob without '/' is matched
+ * against the entry name: plain names are looked up in a hash set, "*.ext" and
+ * "prefix*" become suffix and prefix comparisons, other globs use a small
+ * wildcard matcher ('*', '?', '[...]'). A glob with '/' is matched against the
+ * path relative to the traversal root, where '*' stops at '/' and '**' does not.
+ * Regular expressions are searched for in the relative path.
+ *
+ * Exclusions apply to directories, files and links alike, so an excluded
+ * directory is pruned before it is opened. Inclusions, sizes and times apply to
+ * files only: a directory can hold included files whatever its own name. A
+ * followed link to a file counts as a file, with its target's size and time.
+ */
+class EntryFilter {
+public:
+    /**
+     * @brief What a stat tells about a file; filled by readAttributes().
+     */
+    struct Attributes {
+        std::uint64_t size = 0;
+        std::int64_t mtime = 0; ///< Seconds since the epoch
+        FileId inode;
+        std::uint64_t links = 0;
+    };
+
+    /// @brief Skip entries matching the glob.
+    void exclude(const std::string& glob);
+
+    /// @brief Keep only files matching one of the included globs.
+    void include(const std::string& glob);
+
+    /**
+     * @brief Skip entries whose relative path contains a match of the expression.
+     * @throws std::regex_error if the expression is invalid.
+     */
+    void excludeRegex(const std::string& expression);
+
+    /// @brief Skip files larger than bytes.
+    void maxSize(std::uint64_t bytes);
+
+    /// @brief Skip files last modified before seconds since the epoch.
+    void modifiedSince(std::int64_t seconds);
+
+    /// @return true if nothing is ever skipped
+    bool empty() const;
+
+    /// @return true if the relative path of entries has to be passed to the checks
+    bool needsPath() const { return !_exclude_paths.empty() || !_regexes.empty() || !_include_paths.empty(); }
+
+    /// @return true if files have to be stat'ed for the checks
+    bool needsAttributes() const { return _max_size || _modified_since; }
+
+    /**
+     * @brief Check a directory or link, before it is opened or followed.
+     * @param name Entry name.
+     * @param relative Path relative to the traversal root, including name; may be empty if !needsPath().
+     */
+    bool excludes(const std::string& name, const std::filesystem::path& relative) const;
+
+    /**
+     * @brief Check a regular file.
+     * @param attributes The file's stat; may be nullptr if !needsAttributes().
+     */
+    bool excludesFile(const std::string& name, const std::filesystem::path& relative,
+                      const Attributes* attributes) const;
+
+    /**
+     * @brief Check a regular file, stat'ing it first if needsAttributes().
+     * @param dir_fd Descriptor of the directory stat_path is relative to, or -1.
+     * @param stat_path Name of the file relative to dir_fd, or its full path.
+     * @param attributes Receives the stat, if one was made, so it is not repeated.
+     */
+    bool excludesFileAt(int dir_fd, const std::filesystem::path& stat_path, const std::string& name,
+                        const std::filesystem::path& relative, std::optional<Attributes>& attributes) const;
+
+    /**
+     * @brief Check a symlink that is followed. When its target is a regular file,
+     * inclusions, sizes and times apply to the link as to that file; links to
+     * directories and broken links are left to excludes().
+     * @param dir_fd Descriptor of the directory stat_path is relative to, or -1.
+     * @param stat_path Name of the link relative to dir_fd, or its full path.
+     */
+    bool excludesLinkTarget(int dir_fd, const std::filesystem::path& stat_path, const std::string& name,
+                            const std::filesystem::path& relative) const;
+
+    /**
+     * @brief Stat a file without following links.
+     * @param dir_fd Descriptor of the directory name is relative to, or -1 if name is a full path.
+     * @return false if it cannot be stat'ed.
+     */
+    static bool readAttributes(int dir_fd, const std::filesystem::path& name, Attributes& attributes);
+
+    /**
+     * @brief Parse a size such as "1048576", "512K", "10G" (binary units).
+     */
+    static std::optional<std::uint64_t> parseSize(const std::string& text);
+
+    /**
+     * @brief Parse a local date "YYYY-MM-DD", optionally followed by " HH:MM[:SS]".
+     * @return seconds since the epoch
+     */
+    static std::optional<std::int64_t> parseTime(const std::string& text);
+
+private:
+    /**
+     * @brief Globs matched against names, split by how cheaply they match.
+     */
+    struct NameGlobs {
+        std::unordered_set<std::string> literals;
+        std::vector<std::string> suffixes; ///< From "*suffix"
+        std::vector<std::string> prefixes; ///< From "prefix*"
+        std::vector<std::string> wildcards;
+
+        void add(const std::string& glob);
+        bool empty() const;
+        bool matches(const std::string& name) const;
+    };
+
+    static bool matchesGlob(const char* glob, const char* text, bool path);
+    bool excludedByPattern(const std::string& name, const std::filesystem::path& relative) const;
+
+    /// @return true if a file is excluded by its name or path alone
+    bool excludedByName(const std::string& name, const std::filesystem::path& relative) const;
+    bool excludedByAttributes(const Attributes& attributes) const;
+
+    NameGlobs _exclude_names;
+    std::vector<std::string> _exclude_paths;
+    std::vector<std::regex> _regexes;
+
+    NameGlobs _include_names;
+    std::vector<std::string> _include_paths;
+
+    std::optional<std::uint64_t> _max_size;
+    std::optional<std::int64_t> _modified_since;
+};
@@ -0,0 +1,92 @@
+#include "FileTableConstructor.hpp"
+#include "DirectoryScanner.hpp"
+#include <iostream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+#if defined(__unix__) || defined(__APPLE__)
+    std::int64_t mtimeOf(const struct stat& st) {
+        return static_cast<std::int64_t>(st.st_mtime);
+    }
+#endif
+}
+
+FileTable FileTableConstructor::construct(const std::filesystem::path& root) {
+    FileTable table;
+
+    std::error_code ec;
+    auto status = std::filesystem::symlink_status(root, ec);
+    if (ec || !std::filesystem::exists(status)) {
+        std::cerr << "Warning: Path does not exist, skipping: " << root << '\n';
+        return table;
+    }
+
+    if (std::filesystem::is_directory(status)) {
+        FileTable::Index index = table.addRoot(root);
+        DirectoryHandle handle = DirectoryHandle::open(-1, root);
+        fill(table, index, handle, root);
+    } else if (std::filesystem::is_regular_file(status)) {
+        auto parent_path = root.parent_path();
+        FileTable::Index index = table.addRoot(parent_path.empty() ? "." : parent_path);
+        std::vector<FileTable::Entry> children(1);
+        children[0].name = root.filename().string();
+        children[0].size = std::filesystem::file_size(root, ec);
+        table.addChildren(index, children);
+    }
+
+    table.shrink();
+    return table;
+}
+
+void FileTableConstructor::fill(FileTable& table, FileTable::Index dir, const DirectoryHandle& handle,
+                                const std::filesystem::path& path) {
+#if defined(__unix__) || defined(__APPLE__)
+    std::vector<FileTable::Entry> children;
+    bool listed = DirectoryScanner::scan(handle, path, [&](const ScannedEntry& scanned) {
+        FileTable::Entry entry;
+        entry.name = scanned.name;
+        entry.link_target = scanned.link_target;
+        switch (scanned.type) {
+            case ScannedEntry::Type::File: entry.type = FileTable::Type::File; break;
+            case ScannedEntry::Type::Directory: entry.type = FileTable::Type::Directory; break;
+            case ScannedEntry::Type::Symlink: entry.type = FileTable::Type::Link; break;
+        }
+
+        struct stat st {};
+        if (::fstatat(handle.fd(), scanned.name.c_str(), &st, AT_SYMLINK_NOFOLLOW) == 0) {
+            entry.mtime = mtimeOf(st);
+            if (entry.type == FileTable::Type::File) {
+                entry.size = static_cast<std::uint64_t>(st.st_size);
+            }
+        }
+        children.push_back(std::move(entry));
+    });
+    if (!listed) {
+        std::cerr << "Error accessing directory: " << path
+                  << ". Reason: " << std::strerror(errno) << '\n';
+        return;
+    }
+
+    FileTable::Index first = table.addChildren(dir, children);
+    for (FileTable::Index i = 0; i < children.size(); ++i) {
+        if (children[i].type != FileTable::Type::Directory) {
+            continue;
+        }
+        // Sorted by addChildren, so children[i] is entry first + i
+        DirectoryHandle child = DirectoryHandle::open(handle.fd(), children[i].name);
+        fill(table, first + i, child, path / children[i].name);
+    }
+#else
+    (void)table;
+    (void)dir;
+    (void)handle;
+    std::cerr << "Error accessing directory: " << path << ". Reason: not supported on this platform" << '\n';
+#endif
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "file-system-composite/DirectoryHandle.hpp"
+#include "file-system-composite/FileTable.hpp"
+#include <filesystem>
+
+/**
+ * @brief Director that fills a FileTable instead of building the composite.
+ *
+ * Lists the tree the way DirectoryConstructor does (one handle per directory on
+ * the current path, entries stat'ed relative to it), recording size and mtime
+ * of every entry. Symbolic links are recorded, never followed.
+ */
+class FileTableConstructor {
+public:
+    /**
+     * @brief Build the table of everything below root.
+     * A file root gives a table of its parent directory holding just that file.
+     */
+    FileTable construct(const std::filesystem::path& root);
+
+private:
+    void fill(FileTable& table, FileTable::Index dir, const DirectoryHandle& handle,
+              const std::filesystem::path& path);
+};
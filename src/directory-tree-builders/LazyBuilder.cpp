@@ -0,0 +1,127 @@
+#include "LazyBuilder.hpp"
+#include "DirectoryScanner.hpp"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+LazyBuilder::LazyBuilder(std::unique_ptr<DirectoryStructureBuilder> builder) : _builder(std::move(builder)) {}
+
+void LazyBuilder::startBuildDirectory(const std::filesystem::path& name) {
+    _builder->startBuildDirectory(name);
+    defer(_builder->currentDirectory());
+}
+
+void LazyBuilder::endBuildDirectory() {
+    _builder->endBuildDirectory();
+}
+
+void LazyBuilder::resumeBuildDirectory(Directory& dir) {
+    _builder->resumeBuildDirectory(dir);
+}
+
+Directory* LazyBuilder::currentDirectory() const {
+    return _builder->currentDirectory();
+}
+
+Directory* LazyBuilder::buildLink(const std::filesystem::path& name, const std::filesystem::path& target) {
+    Directory* dir = _builder->buildLink(name, target);
+    defer(dir);
+    return dir;
+}
+
+File* LazyBuilder::buildFile(const std::filesystem::path& name) {
+    return _builder->buildFile(name);
+}
+
+bool LazyBuilder::followsLinks() const {
+    return _builder->followsLinks();
+}
+
+Directory* LazyBuilder::getTree() const {
+    return _builder->getTree();
+}
+
+void LazyBuilder::defer(Directory* dir) {
+    // Directories already holding entries were built eagerly by someone else
+    if (dir && dir->isExpanded() && dir->getChildCount() == 0) {
+        dir->setExpander(this);
+    }
+}
+
+void LazyBuilder::expand(Directory& dir) {
+    std::vector<ScannedEntry> entries;
+    bool listed = false;
+
+    // Relative to the parent while it is pinned, as when a visitor walks the tree
+    auto* parent = dynamic_cast<Directory*>(dir.getOwner());
+    DirectoryHandle handle;
+    if (parent && parent->tryPin()) {
+        handle = DirectoryHandle::open(parent->handle(), dir.getName());
+        parent->unpin();
+    }
+    if (!handle.isOpen()) {
+        handle = DirectoryHandle::open(-1, dir.getPath());
+    }
+    if (handle.isOpen()) {
+        listed = DirectoryScanner::scan(handle, dir.getPath(), [&entries](const ScannedEntry& entry) {
+            entries.push_back(entry);
+        });
+    }
+
+    if (!listed) {
+        // Without handles (other platforms), list by path
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(dir.getPath(), ec), end; !ec && it != end; it.increment(ec)) {
+            ScannedEntry entry;
+            entry.name = it->path().filename().string();
+            if (it->is_symlink(ec)) {
+                entry.type = ScannedEntry::Type::Symlink;
+                entry.link_target = std::filesystem::read_symlink(it->path(), ec).string();
+            } else if (it->is_directory(ec)) {
+                entry.type = ScannedEntry::Type::Directory;
+            } else if (!it->is_regular_file(ec)) {
+                continue;
+            }
+            if (!ec) {
+                entries.push_back(std::move(entry));
+            }
+        }
+        if (ec) {
+            std::cerr << "Error accessing directory: " << dir.getPath() << ". Reason: " << ec.message() << '\n';
+        }
+    }
+
+    // In name order every child is appended at the end of its directory's sorted children
+    std::sort(entries.begin(), entries.end(), [](const ScannedEntry& a, const ScannedEntry& b) {
+        return a.name < b.name;
+    });
+
+    _builder->resumeBuildDirectory(dir);
+    for (const auto& entry : entries) {
+        try {
+            switch (entry.type) {
+                case ScannedEntry::Type::Symlink:
+                    if (buildLink(entry.name, entry.link_target)) {
+                        _builder->endBuildDirectory();
+                    }
+                    break;
+                case ScannedEntry::Type::Directory:
+                    startBuildDirectory(entry.name);
+                    _builder->endBuildDirectory();
+                    break;
+                case ScannedEntry::Type::File: {
+                    File* file = _builder->buildFile(entry.name);
+                    if (file && entry.size) {
+                        file->setInode(entry.inode, entry.links);
+                        file->setSize(static_cast<size_t>(*entry.size));
+                    }
+                    break;
+                }
+            }
+        } catch (const std::exception& e) {
+            // Entries added to the directory before it was expanded are kept
+            std::cerr << "Warning: Could not add " << dir.getPath() / entry.name << ": " << e.what() << '\n';
+        }
+    }
+    _builder->endBuildDirectory();
+}
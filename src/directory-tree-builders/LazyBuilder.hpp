@@ -0,0 +1,49 @@
+#pragma once
+#include "DirectoryStructureBuilder.hpp"
+#include "file-system-composite/DirectoryExpander.hpp"
+#include <memory>
+
+/**
+ * @class LazyBuilder
+ * @brief Builder recording directories as unexpanded stubs, whose entries are
+ * listed only when something first needs them (see Directory::setExpander).
+ *
+ * Build just the root, with startBuildDirectory() and endBuildDirectory(); the
+ * tree below is listed as it is visited or looked up, so a run that stops early
+ * or only looks into one subtree lists only what it reaches. Entries are built
+ * through the wrapped builder, which still decides how links are resolved;
+ * directories it builds for followed links are stubs too.
+ *
+ * The builder must outlive the tree it built.
+ */
+class LazyBuilder : public DirectoryStructureBuilder, public DirectoryExpander {
+public:
+    explicit LazyBuilder(std::unique_ptr<DirectoryStructureBuilder> builder);
+
+    void startBuildDirectory(const std::filesystem::path& name) override;
+
+    void endBuildDirectory() override;
+
+    void resumeBuildDirectory(Directory& dir) override;
+
+    Directory* currentDirectory() const override;
+
+    Directory* buildLink(const std::filesystem::path& name, const std::filesystem::path& target) override;
+
+    File* buildFile(const std::filesystem::path& name) override;
+
+    bool followsLinks() const override;
+
+    Directory* getTree() const override;
+
+    /**
+     * @brief List dir and build its entries; subdirectories become stubs in turn.
+     */
+    void expand(Directory& dir) override;
+
+private:
+    /// Leave an empty directory to be listed on demand
+    void defer(Directory* dir);
+
+    std::unique_ptr<DirectoryStructureBuilder> _builder;
+};
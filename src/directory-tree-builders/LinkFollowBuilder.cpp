@@ -1,36 +1,113 @@
 #include "LinkFollowBuilder.hpp"
 #include "file-system-composite/File.hpp"
+#include <algorithm>
 
 LinkFollowBuilder::LinkFollowBuilder(std::unique_ptr<CycleDetector> tracker) : BaseBuilder(), _cycle_tracker(std::move(tracker)) {}
 
-Directory* LinkFollowBuilder::buildLink(const std::filesystem::path& name, const std::filesystem::path& target) {
-    if (_cycle_tracker->check(target)) {
-        std::cerr << "Circular dependancy detected" << '\n';
-        return nullptr;
+void LinkFollowBuilder::enterChain(const Directory& dir) {
+    // Directories entered through links are owned by the link, which the walk passes through
+    std::vector<const Directory*> ancestry;
+    for (const FileObject* node = &dir; node; node = node->getOwner()) {
+        if (auto* ancestor = dynamic_cast<const Directory*>(node)) {
+            ancestry.push_back(ancestor);
+        }
+    }
+    std::reverse(ancestry.begin(), ancestry.end());
+
+    std::size_t common = 0;
+    while (common < _chain.size() && common < ancestry.size() && _chain[common].dir == ancestry[common]) {
+        ++common;
+    }
+    while (_chain.size() > common) {
+        if (_chain.back().id) {
+            _cycle_tracker->leave(*_chain.back().id);
+        }
+        _chain.pop_back();
     }
 
+    for (std::size_t i = common; i < ancestry.size(); ++i) {
+        auto it = _link_targets.find(ancestry[i]);
+        if (it != _link_targets.end() && it->second.lifetime.expired()) {
+            // Removed from the tree; another directory now has its address
+            _link_targets.erase(it);
+            it = _link_targets.end();
+        }
+        std::optional<FileId> id = it != _link_targets.end()
+            ? std::optional<FileId>(it->second.value)
+            : CycleDetector::identify(ancestry[i]->getPath());
+        if (id && !_cycle_tracker->enter(*id)) {
+            id.reset();
+        }
+        _chain.push_back({ancestry[i], id});
+    }
+}
+
+bool LinkFollowBuilder::shareTarget(std::unique_ptr<Link>& link, const std::optional<FileId>& id) {
+    if (!id) {
+        return false;
+    }
+    auto it = _target_owners.find(*id);
+    if (it != _target_owners.end() && it->second.lifetime.expired()) {
+        // The owner was removed from the tree; the next link to the target owns it anew
+        _target_owners.erase(it);
+        return false;
+    }
+    if (it == _target_owners.end() || !link->shareResolvedTarget(*it->second.value)) {
+        return false;
+    }
+    if (!_build_stack.back()->add(std::move(link))) {
+        std::cerr << "Error while adding link to composite" << '\n';
+    }
+    return true;
+}
+
+Directory* LinkFollowBuilder::buildLink(const std::filesystem::path& name, const std::filesystem::path& target) {
     try {
         auto link = std::make_unique<Link>(name, target, _build_stack.back());
         if (std::filesystem::is_directory(target)) {
+            auto id = CycleDetector::identify(target);
+            enterChain(*_build_stack.back());
+            if (id && _cycle_tracker->contains(*id)) {
+                std::cerr << "Circular dependancy detected" << '\n';
+                return nullptr;
+            }
+            if (shareTarget(link, id)) {
+                return nullptr;
+            }
+
             auto dir_p = std::make_unique<Directory>(name, link.get());
             Directory* dir_internal = dir_p.get();
             link->setResolveTarget(std::move(dir_p));
+            Link* link_internal = link.get();
             
             if (!_build_stack.back()->add(std::move(link))) {
                 std::cerr << "Error while adding link to composite" << '\n';
                 return nullptr;
             }
             
+            if (id) {
+                _link_targets[dir_internal] = {*id, link_internal->lifetime()};
+                _target_owners.emplace(*id, Remembered<Link*>{link_internal, link_internal->lifetime()});
+            }
             _build_stack.push_back(dir_internal);
             return dir_internal;
         } else if (std::filesystem::is_regular_file(target)) {
+            auto id = CycleDetector::identify(target);
+            if (shareTarget(link, id)) {
+                return nullptr;
+            }
+
             auto file_p = std::make_unique<File>(name, link.get());
             link->setResolveTarget(std::move(file_p));
+            Link* link_internal = link.get();
             
             if (!_build_stack.back()->add(std::move(link))) {
                 std::cerr << "Error while adding link to composite" << '\n';
                 return nullptr;
             }
+            if (id) {
+                _target_owners.emplace(*id, Remembered<Link*>{link_internal, link_internal->lifetime()});
+            }
             
             return nullptr;
         }
@@ -1,14 +1,60 @@
 #pragma once
-#include <unordered_set>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "CycleDetector.hpp"
 #include "BaseBuilder.hpp"
 
+/**
+ * @class LinkFollowBuilder
+ * @brief Builder that follows links, building their targets below them.
+ *
+ * A link to a directory is a cycle only if its target is the directory holding
+ * the link or one of its ancestors. Links reaching the same target along
+ * different branches (diamonds) are not cycles, and links to files are never
+ * cycles.
+ *
+ * The first link followed to a target owns the subtree built for it; later links
+ * to the same target share that subtree instead of building it again, so its
+ * files are stat'ed and hashed once.
+ */
 class LinkFollowBuilder : public BaseBuilder {
 public:
     LinkFollowBuilder(std::unique_ptr<CycleDetector> tracker);
     
     Directory* buildLink(const std::filesystem::path& name, const std::filesystem::path& target) override;
 
+    bool followsLinks() const override { return true; }
+
 private:
-    std::unique_ptr<DetectionStrategy> _cycle_tracker;
-};
\ No newline at end of file
+    /**
+     * @brief Let link share the subtree already built for target id, if any, and add it.
+     * @return true if the link was handled this way
+     */
+    bool shareTarget(std::unique_ptr<Link>& link, const std::optional<FileId>& id);
+
+    /**
+     * @brief Make the detector hold the identities of dir and its ancestors, and no others.
+     * Ancestors shared with the previous chain keep their identity, so each directory
+     * is stat'ed at most once while it stays on the chain.
+     */
+    void enterChain(const Directory& dir);
+
+    struct ChainEntry {
+        const Directory* dir;
+        std::optional<FileId> id; ///< Empty if it could not be identified or was already on the chain
+    };
+
+    std::unique_ptr<CycleDetector> _cycle_tracker;
+    std::vector<ChainEntry> _chain; ///< Root first
+    /// A link remembered by the builder; the entry is stale once lifetime expires
+    template <typename T>
+    struct Remembered {
+        T value;
+        std::weak_ptr<const void> lifetime;
+    };
+
+    /// Directories built for followed links, with the identity of their target
+    std::unordered_map<const Directory*, Remembered<FileId>> _link_targets;
+    std::unordered_map<FileId, Remembered<Link*>, FileIdHash> _target_owners; ///< Link owning the subtree built for each target
+};
@@ -0,0 +1,234 @@
+#include "ParallelTraversal.hpp"
+#include "DirectoryScanner.hpp"
+#include "file-system-composite/File.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <cerrno>
+#include <thread>
+
+namespace {
+    /// Keeps warnings of different workers from interleaving
+    std::mutex log_mutex;
+}
+
+ParallelTraversal::ParallelTraversal(std::size_t workers, bool collect_sizes,
+                                     const EntryFilter* filter, std::filesystem::path filter_root,
+                                     const DirectoryListings* listings)
+    : _worker_count(std::max<std::size_t>(workers, 1)), _collect_sizes(collect_sizes),
+      _filter(filter), _filter_root(std::move(filter_root)), _listings(listings) {}
+
+bool ParallelTraversal::supported() noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::vector<DeferredLink> ParallelTraversal::run(Directory& dir) {
+    _workers.clear();
+    for (std::size_t i = 0; i < _worker_count; ++i) {
+        _workers.push_back(std::make_unique<Worker>());
+        if (_collect_sizes) {
+            // Workers already run in parallel, so each one stats its batches inline
+            _workers.back()->stats = std::make_unique<StatBatcher>(1);
+        }
+    }
+    _error = nullptr;
+    _pending = 0;
+    _queued = 0;
+    pushTask(0, Task{&dir, nullptr});
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < _worker_count; ++i) {
+        threads.emplace_back(&ParallelTraversal::work, this, i);
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (_error) {
+        std::rethrow_exception(_error);
+    }
+
+    std::vector<DeferredLink> links;
+    for (auto& worker : _workers) {
+        std::move(worker->links.begin(), worker->links.end(), std::back_inserter(links));
+    }
+    // Same order for every run, regardless of which worker found which link
+    std::sort(links.begin(), links.end(), [](const DeferredLink& a, const DeferredLink& b) {
+        return a.parent->getPath() / a.name < b.parent->getPath() / b.name;
+    });
+    return links;
+}
+
+void ParallelTraversal::pushTask(std::size_t index, Task task) {
+    ++_pending;
+    {
+        std::lock_guard<std::mutex> lock(_workers[index]->mutex);
+        _workers[index]->tasks.push_back(std::move(task));
+    }
+    ++_queued;
+    {
+        std::lock_guard<std::mutex> lock(_idle_mutex);
+    }
+    _work_available.notify_one();
+}
+
+bool ParallelTraversal::takeTask(std::size_t index, Task& task) {
+    // Own deque from the back: depth first, the subtree is likely still in the dentry cache
+    {
+        Worker& own = *_workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --_queued;
+            return true;
+        }
+    }
+    // Steal from the front: the oldest task is the closest to the root, so the largest
+    for (std::size_t offset = 1; offset < _workers.size(); ++offset) {
+        Worker& victim = *_workers[(index + offset) % _workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --_queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ParallelTraversal::work(std::size_t index) {
+    while (true) {
+        Task task;
+        if (takeTask(index, task)) {
+            try {
+                scan(index, task);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(_error_mutex);
+                if (!_error) {
+                    _error = std::current_exception();
+                }
+            }
+            if (--_pending == 0) {
+                std::lock_guard<std::mutex> lock(_idle_mutex);
+                _work_available.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_idle_mutex);
+        _work_available.wait(lock, [this]() { return _queued > 0 || _pending == 0; });
+        if (_pending == 0) {
+            return;
+        }
+    }
+}
+
+void ParallelTraversal::scan(std::size_t index, Task& task) {
+    Directory& dir = *task.dir;
+    const std::filesystem::path& path = dir.getPath();
+    DirectoryHandle opened;
+    if (task.parent) {
+        opened = DirectoryHandle::open(task.parent->fd(), dir.getName());
+        task.parent.reset();
+    }
+    if (!opened.isOpen()) {
+        opened = DirectoryHandle::open(-1, path);
+    }
+    if (!opened.isOpen()) {
+        int error = errno;
+        std::lock_guard<std::mutex> lock(log_mutex);
+        std::cerr << "Error accessing directory: " << path << ". Reason: " << std::strerror(error) << '\n';
+        return;
+    }
+    // Shared with the subdirectory tasks, which open themselves relative to it
+    auto handle = std::make_shared<const DirectoryHandle>(std::move(opened));
+
+    Worker& worker = *_workers[index];
+    std::vector<File*> unsized;
+    // Children of a directory seen for the first time come from this listing only,
+    // so they are unique and can be appended unchecked, then sorted once
+    bool fresh = dir.getChildCount() == 0;
+    std::optional<EntryFilter::Attributes> attributes;
+    auto consume = [&](const ScannedEntry& entry) {
+        if (_filter) {
+            auto relative = _filter->needsPath() ? (path / entry.name).lexically_relative(_filter_root)
+                                                 : std::filesystem::path();
+            bool excluded = entry.type == ScannedEntry::Type::File
+                ? _filter->excludesFileAt(handle->fd(), entry.name, entry.name, relative, attributes)
+                : _filter->excludes(entry.name, relative);
+            if (excluded) {
+                return;
+            }
+        }
+
+        switch (entry.type) {
+            case ScannedEntry::Type::Symlink:
+                worker.links.push_back({&dir, entry.name, entry.link_target});
+                break;
+            case ScannedEntry::Type::Directory: {
+                Directory* subdir = nullptr;
+                if (fresh) {
+                    subdir = static_cast<Directory*>(dir.append(std::make_unique<Directory>(entry.name, &dir)));
+                } else {
+                    subdir = dynamic_cast<Directory*>(dir.getChild(entry.name));
+                    if (!subdir) {
+                        subdir = dir.createSubdirectory(entry.name);
+                    }
+                }
+                pushTask(index, Task{subdir, handle});
+                break;
+            }
+            case ScannedEntry::Type::File: {
+                File* file = fresh ? static_cast<File*>(dir.append(std::make_unique<File>(entry.name, &dir)))
+                                   : dir.createFile(entry.name);
+                if (attributes) {
+                    file->setInode(attributes->inode, attributes->links);
+                    file->setSize(static_cast<size_t>(attributes->size));
+                } else if (entry.size) {
+                    file->setInode(entry.inode, entry.links);
+                    file->setSize(static_cast<size_t>(*entry.size));
+                } else if (worker.stats) {
+                    unsized.push_back(file);
+                }
+                break;
+            }
+        }
+    };
+    std::vector<ScannedEntry> entries;
+    auto collect = [&entries](const ScannedEntry& entry) {
+        entries.push_back(entry);
+    };
+    bool listed = _listings ? _listings->list(*handle, path, collect) : DirectoryScanner::scan(*handle, path, collect);
+    if (!listed) {
+        // What was read before the failure is dropped, not kept as the whole directory
+        int error = errno;
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+            std::cerr << "Error accessing directory: " << path << ". Reason: " << std::strerror(error)
+                      << "; listing it again by path" << '\n';
+        }
+        entries.clear();
+        DirectoryScanner::scanPath(path, collect);
+    }
+
+    // Listings come in hash order; in inode order, stats and opens read the inode table mostly sequentially
+    std::stable_sort(entries.begin(), entries.end(), [](const ScannedEntry& a, const ScannedEntry& b) {
+        return a.ino < b.ino;
+    });
+    for (const auto& entry : entries) {
+        consume(entry);
+    }
+
+    dir.sortChildren();
+
+    if (listed && worker.stats) {
+        worker.stats->fillSizes(handle->fd(), unsized);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "DirectoryListings.hpp"
+#include "EntryFilter.hpp"
+#include "StatBatcher.hpp"
+#include "file-system-composite/Directory.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Symlink found during a parallel traversal, to be built by the caller.
+ */
+struct DeferredLink {
+    Directory* parent = nullptr;
+    std::string name;
+    std::filesystem::path target;
+};
+
+/**
+ * @class ParallelTraversal
+ * @brief Lists a directory tree on a work-stealing thread pool.
+ *
+ * Every subdirectory is a task. A worker pushes the subdirectories it finds
+ * onto its own deque and takes work from its back; idle workers steal from the
+ * front of the other deques, so large subtrees get split between threads.
+ * Directories and files are created directly in the composite; symlinks are
+ * returned instead, since whether they are followed is up to the builder.
+ * Entries excluded by the filter are skipped, so excluded directories never
+ * become tasks.
+ *
+ * Each directory is opened relative to its parent's handle, which stays open
+ * until the last of its subdirectories is, so only one path component is
+ * resolved per directory and trees deeper than PATH_MAX can be listed.
+ * A listing that fails partway is redone by path instead of being kept.
+ */
+class ParallelTraversal {
+public:
+    /**
+     * @param workers Number of threads; at least one is used.
+     * @param collect_sizes Record file sizes while listing (see StatBatcher).
+     * @param filter Entries to skip, or nullptr (non-owning).
+     * @param filter_root Path the filter's relative paths start from.
+     * @param listings Listings reused for unchanged directories, or nullptr (non-owning).
+     */
+    explicit ParallelTraversal(std::size_t workers, bool collect_sizes = false,
+                               const EntryFilter* filter = nullptr, std::filesystem::path filter_root = {},
+                               const DirectoryListings* listings = nullptr);
+
+    /**
+     * @brief Fill dir, recursively, with the contents of dir.getPath().
+     * Directories that already exist in the tree are reused.
+     * @return the symlinks found, ordered by path.
+     * @throws the first exception raised while creating the tree.
+     */
+    std::vector<DeferredLink> run(Directory& dir);
+
+    /**
+     * @return whether directories can be listed in parallel on this platform.
+     */
+    static bool supported() noexcept;
+
+private:
+    /// A directory to list, with the handle of its parent to open it relative to
+    struct Task {
+        Directory* dir = nullptr;
+        std::shared_ptr<const DirectoryHandle> parent; ///< Closed once its last child is open
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::vector<DeferredLink> links;
+        std::unique_ptr<StatBatcher> stats; ///< Set when sizes are collected
+    };
+
+    void work(std::size_t index);
+    bool takeTask(std::size_t index, Task& task);
+    void pushTask(std::size_t index, Task task);
+    void scan(std::size_t index, Task& task);
+
+    std::size_t _worker_count;
+    bool _collect_sizes;
+    const EntryFilter* _filter;
+    std::filesystem::path _filter_root;
+    const DirectoryListings* _listings;
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    std::atomic<std::size_t> _pending{0}; ///< Tasks queued or being scanned
+    std::atomic<std::size_t> _queued{0};  ///< Tasks waiting in a deque
+
+    std::mutex _idle_mutex;
+    std::condition_variable _work_available;
+
+    std::mutex _error_mutex;
+    std::exception_ptr _error;
+};
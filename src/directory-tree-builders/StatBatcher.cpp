@@ -0,0 +1,297 @@
+#include "StatBatcher.hpp"
+#include <algorithm>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <cerrno>
+#endif
+
+namespace {
+    /// Batches smaller than this are not worth waking the pool for
+    constexpr std::size_t MIN_POOL_BATCH = 32;
+
+    /// Submission queue size; larger batches are submitted in several rounds
+    constexpr unsigned RING_ENTRIES = 256;
+
+    /**
+     * @brief Stat one file, relative to dir_fd when it is open.
+     */
+    void statFile(int dir_fd, File& file) {
+#if defined(__unix__) || defined(__APPLE__)
+        struct stat st {};
+        int result = dir_fd >= 0
+            ? ::fstatat(dir_fd, file.getName().c_str(), &st, AT_SYMLINK_NOFOLLOW)
+            : ::lstat(file.getPath().c_str(), &st);
+        if (result == 0 && S_ISREG(st.st_mode)) {
+            file.setInode(FileId{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)},
+                          static_cast<std::uint64_t>(st.st_nlink));
+            file.setSize(static_cast<size_t>(st.st_size));
+        }
+#else
+        (void)dir_fd;
+        file.getSize();
+#endif
+    }
+}
+
+#ifdef HAVE_IO_URING
+/**
+ * @brief Minimal io_uring set up with raw syscalls, used only for batches of statx.
+ */
+class StatBatcher::IoUring {
+public:
+    /**
+     * @return the ring, or nullptr if the kernel does not provide io_uring.
+     */
+    static std::unique_ptr<IoUring> create() {
+        io_uring_params params {};
+        int fd = static_cast<int>(::syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+        if (fd < 0) {
+            return nullptr;
+        }
+        std::unique_ptr<IoUring> ring(new IoUring(fd));
+        if (!ring->map(params)) {
+            return nullptr;
+        }
+        return ring;
+    }
+
+    ~IoUring() {
+        if (_sqes != MAP_FAILED) ::munmap(_sqes, _sqes_size);
+        if (_cq_ptr != MAP_FAILED && _cq_ptr != _sq_ptr) ::munmap(_cq_ptr, _cq_size);
+        if (_sq_ptr != MAP_FAILED) ::munmap(_sq_ptr, _sq_size);
+        ::close(_fd);
+    }
+
+    /**
+     * @return false if the kernel does not support statx through io_uring;
+     * the batch is then left to the caller.
+     */
+    bool statFiles(int dir_fd, const std::vector<File*>& files) {
+        std::vector<struct statx> results(std::min<std::size_t>(files.size(), _sq_entries));
+        std::vector<std::string> names(results.size());
+
+        for (std::size_t begin = 0; begin < files.size(); begin += results.size()) {
+            std::size_t count = std::min(results.size(), files.size() - begin);
+
+            unsigned tail = *_sq_tail;
+            for (std::size_t i = 0; i < count; ++i) {
+                File& file = *files[begin + i];
+                names[i] = dir_fd >= 0 ? file.getName() : file.getPath().string();
+
+                unsigned index = (tail + static_cast<unsigned>(i)) & *_sq_mask;
+                io_uring_sqe& sqe = _sqes[index];
+                sqe = io_uring_sqe {};
+                sqe.opcode = IORING_OP_STATX;
+                sqe.fd = dir_fd >= 0 ? dir_fd : AT_FDCWD;
+                sqe.addr = reinterpret_cast<std::uint64_t>(names[i].c_str());
+                sqe.len = STATX_TYPE | STATX_SIZE | STATX_INO | STATX_NLINK;
+                sqe.off = reinterpret_cast<std::uint64_t>(&results[i]);
+                sqe.statx_flags = AT_SYMLINK_NOFOLLOW;
+                sqe.user_data = i;
+                _sq_array[index] = index;
+            }
+            __atomic_store_n(_sq_tail, tail + static_cast<unsigned>(count), __ATOMIC_RELEASE);
+
+            std::size_t submitted = 0;
+            std::size_t completed = 0;
+            while (completed < count) {
+                unsigned to_submit = static_cast<unsigned>(count - submitted);
+                long entered = ::syscall(__NR_io_uring_enter, _fd, to_submit,
+                                         static_cast<unsigned>(count - completed), IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (entered < 0) {
+                    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+                    return false;
+                }
+                submitted += static_cast<std::size_t>(entered);
+
+                unsigned head = *_cq_head;
+                unsigned cq_tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+                for (; head != cq_tail; ++head) {
+                    const io_uring_cqe& cqe = _cqes[head & *_cq_mask];
+                    std::size_t i = static_cast<std::size_t>(cqe.user_data);
+                    if (cqe.res == -EINVAL) {
+                        _unsupported = true;
+                    } else if (cqe.res == 0 && S_ISREG(results[i].stx_mode)) {
+                        const struct statx& stx = results[i];
+                        // Encoded like st_dev, so identities from stat and statx compare equal
+                        FileId id{static_cast<std::uint64_t>(makedev(stx.stx_dev_major, stx.stx_dev_minor)), stx.stx_ino};
+                        files[begin + i]->setInode(id, stx.stx_nlink);
+                        files[begin + i]->setSize(static_cast<size_t>(stx.stx_size));
+                    }
+                    ++completed;
+                }
+                __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+            }
+            if (_unsupported) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    explicit IoUring(int fd) : _fd(fd) {}
+
+    bool map(const io_uring_params& params) {
+        _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+        }
+
+        _sq_ptr = ::mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+        if (_sq_ptr == MAP_FAILED) return false;
+        _cq_ptr = single_mmap ? _sq_ptr
+            : ::mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+        if (_cq_ptr == MAP_FAILED) return false;
+        _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE,
+                                                  MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES));
+        if (_sqes == MAP_FAILED) return false;
+
+        auto* sq = static_cast<char*>(_sq_ptr);
+        _sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        _sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        _sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        _sq_entries = params.sq_entries;
+
+        auto* cq = static_cast<char*>(_cq_ptr);
+        _cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        _cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        _cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    int _fd;
+    void* _sq_ptr = MAP_FAILED;
+    void* _cq_ptr = MAP_FAILED;
+    io_uring_sqe* _sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t _sq_size = 0;
+    std::size_t _cq_size = 0;
+    std::size_t _sqes_size = 0;
+
+    unsigned* _sq_tail = nullptr;
+    unsigned* _sq_mask = nullptr;
+    unsigned* _sq_array = nullptr;
+    unsigned _sq_entries = 0;
+    unsigned* _cq_head = nullptr;
+    unsigned* _cq_tail = nullptr;
+    unsigned* _cq_mask = nullptr;
+    io_uring_cqe* _cqes = nullptr;
+
+    bool _unsupported = false;
+};
+#else
+class StatBatcher::IoUring {
+public:
+    static std::unique_ptr<IoUring> create() { return nullptr; }
+    bool statFiles(int, const std::vector<File*>&) { return false; }
+};
+#endif
+
+StatBatcher::StatBatcher(std::size_t threads, Backend backend)
+    : _ring(backend == Backend::Auto ? IoUring::create() : nullptr),
+      _threads(std::max<std::size_t>(threads, 1)) {}
+
+StatBatcher::~StatBatcher() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _batch_ready.notify_all();
+    for (auto& thread : _pool) {
+        thread.join();
+    }
+}
+
+void StatBatcher::fillSizes(int dir_fd, const std::vector<File*>& files) {
+    if (files.empty()) {
+        return;
+    }
+    if (_ring) {
+        if (_ring->statFiles(dir_fd, files)) {
+            return;
+        }
+        // statx is not supported through this kernel's io_uring; use the pool from now on
+        _ring.reset();
+    }
+    statInPool(dir_fd, files);
+}
+
+void StatBatcher::statInPool(int dir_fd, const std::vector<File*>& files) {
+    if (_threads == 1 || files.size() < MIN_POOL_BATCH) {
+        for (File* file : files) {
+            statFile(dir_fd, *file);
+        }
+        return;
+    }
+
+    if (_pool.empty()) {
+        // The calling thread works too
+        for (std::size_t i = 1; i < _threads; ++i) {
+            _pool.emplace_back(&StatBatcher::poolWorker, this);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _batch = &files;
+        _batch_dir_fd = dir_fd;
+        _next = 0;
+        _busy = _pool.size();
+        ++_generation;
+    }
+    _batch_ready.notify_all();
+
+    statRange(dir_fd, files);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _batch_done.wait(lock, [this]() { return _busy == 0; });
+    _batch = nullptr;
+}
+
+void StatBatcher::poolWorker() {
+    std::size_t seen = 0;
+    while (true) {
+        const std::vector<File*>* batch = nullptr;
+        int dir_fd = -1;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _batch_ready.wait(lock, [&]() { return _stop || _generation != seen; });
+            if (_stop) {
+                return;
+            }
+            seen = _generation;
+            batch = _batch;
+            dir_fd = _batch_dir_fd;
+        }
+
+        statRange(dir_fd, *batch);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            --_busy;
+        }
+        _batch_done.notify_one();
+    }
+}
+
+void StatBatcher::statRange(int dir_fd, const std::vector<File*>& files) {
+    for (std::size_t i = _next++; i < files.size(); i = _next++) {
+        statFile(dir_fd, *files[i]);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "file-system-composite/File.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class StatBatcher
+ * @brief Records the sizes of many files at once, so they are known before
+ * anything (report, progress total) asks for them.
+ *
+ * On Linux the statx calls of a batch are submitted together through io_uring
+ * and completed asynchronously by the kernel. Where io_uring is not available
+ * (other platforms, old kernels, disabled by policy), the files are stat'ed by
+ * a small pool of threads instead.
+ *
+ * A batcher is not thread-safe; use one per thread.
+ */
+class StatBatcher {
+public:
+    enum class Backend {
+        Auto,      ///< io_uring when available, the thread pool otherwise
+        ThreadPool ///< Always the thread pool
+    };
+
+    /**
+     * @param threads Size of the fallback thread pool; with 1, files are stat'ed inline.
+     * @param backend How batches are submitted.
+     */
+    explicit StatBatcher(std::size_t threads = 4, Backend backend = Backend::Auto);
+    ~StatBatcher();
+
+    StatBatcher(const StatBatcher&) = delete;
+    StatBatcher& operator=(const StatBatcher&) = delete;
+
+    /**
+     * @brief Record the size of each regular file with File::setSize.
+     * Files that cannot be stat'ed are left unchanged.
+     * @param dir_fd Descriptor of the directory the file names are relative to,
+     * or -1 to stat the files by their full paths.
+     */
+    void fillSizes(int dir_fd, const std::vector<File*>& files);
+
+    /**
+     * @return whether batches are submitted through io_uring.
+     */
+    bool usesIoUring() const noexcept { return _ring != nullptr; }
+
+private:
+    class IoUring;
+
+    void statInPool(int dir_fd, const std::vector<File*>& files);
+    void poolWorker();
+    void statRange(int dir_fd, const std::vector<File*>& files);
+
+    std::unique_ptr<IoUring> _ring;
+
+    std::size_t _threads;
+    std::vector<std::thread> _pool;
+    std::mutex _mutex;
+    std::condition_variable _batch_ready;
+    std::condition_variable _batch_done;
+    const std::vector<File*>* _batch = nullptr;
+    int _batch_dir_fd = -1;
+    std::size_t _generation = 0;
+    std::size_t _busy = 0;
+    std::atomic<std::size_t> _next{0};
+    bool _stop = false;
+};
@@ -0,0 +1,478 @@
+#include "TreeSnapshot.hpp"
+#include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
+#include "file-system-composite/DirectoryHandle.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char MAGIC[8] = {'C', 'K', 'S', 'N', 'A', 'P', '\0', '\1'};
+    constexpr std::uint32_t VERSION = 2;
+    constexpr std::uint32_t NONE = static_cast<std::uint32_t>(-1);
+
+    enum class RecordType : std::uint8_t { File, Directory, Link };
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t key;          ///< Offset of the key in the names
+        std::uint64_t record_count;
+        std::uint64_t names_size;
+        std::int64_t listed;        ///< Nanoseconds; when listing the saved tree started
+    };
+
+    /// One entry; the root is record 0, the others follow in visiting order (parents first)
+    struct Record {
+        std::uint32_t parent;
+        std::uint32_t name;        ///< Offset in the names; the root's name is its path
+        std::uint32_t target;      ///< Offset of a link's target, NONE for other entries
+        RecordType type;
+        std::uint8_t padding[3];
+        std::uint64_t size;
+        std::int64_t mtime;        ///< Nanoseconds
+        std::int64_t ctime;        ///< Nanoseconds
+        std::uint64_t dev;
+        std::uint64_t ino;
+        std::uint64_t links;
+    };
+
+    static_assert(sizeof(Header) == 40, "Header layout is part of the file format");
+    static_assert(sizeof(Record) == 64, "Record layout is part of the file format");
+
+    /// Timestamps are coarser than the clock: a change shortly before listing may be stamped a little earlier
+    constexpr std::int64_t TIMESTAMP_SLACK = 1000000000;
+
+#if defined(__unix__) || defined(__APPLE__)
+    std::int64_t nanoseconds(const struct timespec& time) {
+        return static_cast<std::int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+
+    /// Fill the stat fields of a record; false if the entry cannot be stat'ed
+    bool statInto(int dir_fd, const char* name, bool follow, Record& record) {
+        struct stat st {};
+        if (::fstatat(dir_fd >= 0 ? dir_fd : AT_FDCWD, name, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+            return false;
+        }
+#ifdef __APPLE__
+        record.mtime = nanoseconds(st.st_mtimespec);
+        record.ctime = nanoseconds(st.st_ctimespec);
+#else
+        record.mtime = nanoseconds(st.st_mtim);
+        record.ctime = nanoseconds(st.st_ctim);
+#endif
+        record.size = S_ISREG(st.st_mode) ? static_cast<std::uint64_t>(st.st_size) : 0;
+        record.dev = static_cast<std::uint64_t>(st.st_dev);
+        record.ino = static_cast<std::uint64_t>(st.st_ino);
+        record.links = static_cast<std::uint64_t>(st.st_nlink);
+        return true;
+    }
+
+    /**
+     * @brief Records every entry of a tree, with a fresh stat of each.
+     * Directories are pinned while their children are visited, so children are
+     * stat'ed relative to them.
+     */
+    class SnapshotRecorder : public DirectoryIterationVisitor {
+    public:
+        SnapshotRecorder() : DirectoryIterationVisitor(std::cerr) {}
+
+        void visitDirectory(Directory& dir) override {
+            add(dir, RecordType::Directory);
+        }
+
+        void visitFile(File& file) override {
+            // The resolved target of a link is rebuilt by the builder from the link
+            if (!dynamic_cast<Link*>(file.getOwner())) {
+                add(file, RecordType::File);
+            }
+        }
+
+        void visitLink(Link& link) override {
+            add(link, RecordType::Link);
+            // Targets shared with an earlier link are shared again when rebuilt
+            if (link.ownsResolvedTarget()) {
+                link.getResolvedTarget()->accept(*this);
+            }
+        }
+
+        std::uint32_t intern(const std::string& text) {
+            // Offsets are 32 bits wide, with NONE reserved; a larger tree is not saved
+            if (names.size() + text.size() + 1 > NONE) {
+                complete = false;
+                return NONE;
+            }
+            auto offset = static_cast<std::uint32_t>(names.size());
+            names.append(text);
+            names.push_back('\0');
+            return offset;
+        }
+
+        std::vector<Record> records;
+        std::string names;
+        bool complete = true;
+
+    private:
+        void add(FileObject& object, RecordType type) {
+            Record record {};
+            FileObject* owner = object.getOwner();
+            auto parent = owner ? _indices.find(owner) : _indices.end();
+            record.parent = parent != _indices.end() ? parent->second : NONE;
+            record.type = type;
+            record.target = NONE;
+
+            // A link's resolved target is reached through the link; other entries are not followed
+            auto* dir = dynamic_cast<Directory*>(owner);
+            int dir_fd = dir ? dir->handle() : -1;
+            std::string name = dir_fd >= 0 ? object.getName() : object.getPath().string();
+            bool stated = statInto(dir_fd, name.c_str(), dynamic_cast<Link*>(owner) != nullptr, record);
+
+            // The link as found on disk, as the traversal passes it to the builder
+            if (stated && type == RecordType::Link) {
+                std::string target(PATH_MAX, '\0');
+                ssize_t length = ::readlinkat(dir_fd >= 0 ? dir_fd : AT_FDCWD, name.c_str(), &target[0], target.size());
+                stated = length >= 0;
+                target.resize(stated ? static_cast<std::size_t>(length) : 0);
+                record.target = intern(target);
+            }
+            if (!stated || (owner && record.parent == NONE) || records.size() >= NONE) {
+                complete = false;
+                return;
+            }
+
+            record.name = intern(owner ? object.getName() : object.getPath().string());
+
+            _indices[&object] = static_cast<std::uint32_t>(records.size());
+            records.push_back(record);
+        }
+
+        std::unordered_map<const FileObject*, std::uint32_t> _indices;
+    };
+
+    /**
+     * @brief Read-only mapping of a whole file.
+     */
+    class Mapping {
+    public:
+        explicit Mapping(const std::filesystem::path& file) {
+            int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            struct stat st {};
+            if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+                _size = static_cast<std::size_t>(st.st_size);
+                void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                _data = data == MAP_FAILED ? nullptr : data;
+            }
+            ::close(fd);
+        }
+
+        ~Mapping() {
+            if (_data) {
+                ::munmap(_data, _size);
+            }
+        }
+
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        const char* data() const { return static_cast<const char*>(_data); }
+        std::size_t size() const { return _data ? _size : 0; }
+
+    private:
+        void* _data = nullptr;
+        std::size_t _size = 0;
+    };
+
+    /**
+     * @brief Records and names of a mapped snapshot, checked for consistency.
+     */
+    class SnapshotView {
+    public:
+        SnapshotView(const std::filesystem::path& file, const std::string& key) : _mapping(file) {
+            if (_mapping.size() < sizeof(Header)) {
+                return;
+            }
+            std::memcpy(&_header, _mapping.data(), sizeof(_header));
+            if (std::memcmp(_header.magic, MAGIC, sizeof(MAGIC)) != 0 || _header.version != VERSION
+                || _header.record_count == 0
+                || _header.record_count > (_mapping.size() - sizeof(Header)) / sizeof(Record)
+                || _header.names_size != _mapping.size() - sizeof(Header) - _header.record_count * sizeof(Record)
+                || _header.names_size == 0) {
+                return;
+            }
+
+            // The records start right after the header, whose size keeps them aligned in the mapping
+            const auto* records = reinterpret_cast<const Record*>(_mapping.data() + sizeof(Header));
+            _names = _mapping.data() + sizeof(Header) + _header.record_count * sizeof(Record);
+            if (_names[_header.names_size - 1] != '\0' || !nameAt(_header.key) || key != nameAt(_header.key)) {
+                return;
+            }
+            for (std::uint64_t i = 0; i < _header.record_count; ++i) {
+                const Record& record = records[i];
+                bool parent_ok = i == 0 ? record.parent == NONE : record.parent < i;
+                bool target_ok = record.type != RecordType::Link || nameAt(record.target);
+                if (!parent_ok || !target_ok || !nameAt(record.name) || record.type > RecordType::Link
+                    || (i == 0) != (record.type == RecordType::Directory && record.parent == NONE)) {
+                    return;
+                }
+            }
+            _records = records;
+        }
+
+        bool valid() const { return _records != nullptr; }
+        std::uint64_t size() const { return _header.record_count; }
+        const Record& operator[](std::uint64_t index) const { return _records[index]; }
+
+        /// @return the name at offset, or nullptr if it is out of range
+        const char* nameAt(std::uint32_t offset) const {
+            return offset < _header.names_size ? _names + offset : nullptr;
+        }
+
+        /**
+         * @return whether the stamp of directory record was taken after its listing
+         * was complete; if it changed during the listing, the stamp may match an
+         * outdated list of entries
+         */
+        bool settled(const Record& record) const {
+            return record.mtime + TIMESTAMP_SLACK < _header.listed && record.ctime + TIMESTAMP_SLACK < _header.listed;
+        }
+
+    private:
+        Mapping _mapping;
+        Header _header {};
+        const Record* _records = nullptr;
+        const char* _names = nullptr;
+    };
+#endif
+}
+
+bool TreeSnapshot::save(Directory& root, const std::filesystem::path& file, const std::string& key,
+                        std::chrono::system_clock::time_point listed) {
+#if defined(__unix__) || defined(__APPLE__)
+    SnapshotRecorder recorder;
+    Header header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key = recorder.intern(key);
+    header.listed = std::chrono::duration_cast<std::chrono::nanoseconds>(listed.time_since_epoch()).count();
+    root.accept(recorder);
+    if (!recorder.complete || recorder.records.empty()) {
+        return false;
+    }
+    header.record_count = recorder.records.size();
+    header.names_size = recorder.names.size();
+
+    auto temporary = file;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(recorder.records.data()),
+                  static_cast<std::streamsize>(recorder.records.size() * sizeof(Record)));
+        out.write(recorder.names.data(), static_cast<std::streamsize>(recorder.names.size()));
+        if (!out.flush()) {
+            std::filesystem::remove(temporary);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporary, file, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    return true;
+#else
+    (void)root;
+    (void)file;
+    (void)key;
+    (void)listed;
+    return false;
+#endif
+}
+
+bool TreeSnapshot::load(const std::filesystem::path& file, DirectoryStructureBuilder& builder, const std::string& key) {
+#if defined(__unix__) || defined(__APPLE__)
+    SnapshotView records(file, key);
+    if (!records.valid()) {
+        return false;
+    }
+    auto nameAt = [&](std::uint32_t offset) { return records.nameAt(offset); };
+
+    // Confirm every entry before building anything
+    struct Level {
+        std::uint64_t record;
+        DirectoryHandle handle;
+    };
+    std::vector<Level> stack;
+    std::unordered_map<std::uint64_t, Record> changed; ///< Files with new contents
+    for (std::uint64_t i = 0; i < records.size(); ++i) {
+        const Record& record = records[i];
+        while (!stack.empty() && stack.back().record != record.parent) {
+            stack.pop_back();
+        }
+        if (i > 0 && stack.empty()) {
+            return false;
+        }
+
+        Record current = record;
+        int dir_fd = stack.empty() ? -1 : stack.back().handle.fd();
+        switch (record.type) {
+            case RecordType::Directory: {
+                // The target of a followed link is opened through the link
+                const char* name = nameAt(record.name);
+                if (i > 0 && records[record.parent].type == RecordType::Link) {
+                    name = nameAt(records[record.parent].name);
+                    dir_fd = stack.size() > 1 ? stack[stack.size() - 2].handle.fd() : -1;
+                }
+                DirectoryHandle handle = DirectoryHandle::open(dir_fd, name);
+                if (!handle.isOpen() || !records.settled(record) || !statInto(handle.fd(), ".", false, current)
+                    || current.mtime != record.mtime || current.ctime != record.ctime
+                    || current.ino != record.ino || current.dev != record.dev) {
+                    return false;
+                }
+                stack.push_back(Level{i, std::move(handle)});
+                break;
+            }
+            case RecordType::File: {
+                if (!statInto(dir_fd, nameAt(record.name), false, current) || current.ino != record.ino
+                    || current.dev != record.dev) {
+                    return false;
+                }
+                if (current.size != record.size || current.mtime != record.mtime || current.ctime != record.ctime) {
+                    changed[i] = current;
+                }
+                break;
+            }
+            case RecordType::Link: {
+                if (!statInto(dir_fd, nameAt(record.name), false, current) || current.ctime != record.ctime) {
+                    return false;
+                }
+                stack.push_back(Level{i, DirectoryHandle()});
+                break;
+            }
+        }
+    }
+
+    // Rebuild through the builder, which still decides how links are resolved
+    std::vector<std::uint64_t> open{0};
+    std::vector<bool> skipped(records.size(), false);
+    builder.startBuildDirectory(nameAt(records[0].name));
+    for (std::uint64_t i = 1; i < records.size(); ++i) {
+        const Record& record = records[i];
+        if (skipped[record.parent]) {
+            skipped[i] = true;
+            continue;
+        }
+        while (open.back() != record.parent) {
+            builder.endBuildDirectory();
+            open.pop_back();
+        }
+
+        switch (record.type) {
+            case RecordType::Directory:
+                if (records[record.parent].type == RecordType::Link) {
+                    // Already opened by buildLink
+                    open.back() = i;
+                } else {
+                    builder.startBuildDirectory(nameAt(record.name));
+                    open.push_back(i);
+                }
+                break;
+            case RecordType::File: {
+                File* built = builder.buildFile(nameAt(record.name));
+                if (built) {
+                    auto update = changed.find(i);
+                    const Record& current = update != changed.end() ? update->second : record;
+                    built->setInode(FileId{current.dev, current.ino}, current.links);
+                    built->setSize(static_cast<size_t>(current.size));
+                }
+                break;
+            }
+            case RecordType::Link:
+                if (builder.buildLink(nameAt(record.name), nameAt(record.target))) {
+                    open.push_back(i);
+                } else {
+                    skipped[i] = true;
+                }
+                break;
+        }
+    }
+    while (!open.empty()) {
+        builder.endBuildDirectory();
+        open.pop_back();
+    }
+    return true;
+#else
+    (void)file;
+    (void)builder;
+    (void)key;
+    return false;
+#endif
+}
+
+bool TreeSnapshot::loadListings(const std::filesystem::path& file, const std::string& key, DirectoryListings& listings) {
+#if defined(__unix__) || defined(__APPLE__)
+    SnapshotView records(file, key);
+    if (!records.valid()) {
+        return false;
+    }
+
+    // Children follow their parent, so each directory's entries are gathered in one pass
+    std::unordered_map<std::uint64_t, std::vector<ScannedEntry>> entries;
+    for (std::uint64_t i = 0; i < records.size(); ++i) {
+        const Record& record = records[i];
+        if (record.type == RecordType::Directory && records.settled(record)) {
+            entries[i];
+        }
+        if (i == 0 || records[record.parent].type != RecordType::Directory) {
+            continue;
+        }
+        auto listing = entries.find(record.parent);
+        if (listing == entries.end()) {
+            continue;
+        }
+
+        ScannedEntry entry;
+        entry.name = records.nameAt(record.name);
+        entry.ino = record.ino;
+        switch (record.type) {
+            case RecordType::File: entry.type = ScannedEntry::Type::File; break;
+            case RecordType::Directory: entry.type = ScannedEntry::Type::Directory; break;
+            case RecordType::Link:
+                entry.type = ScannedEntry::Type::Symlink;
+                entry.link_target = records.nameAt(record.target);
+                break;
+        }
+        listing->second.push_back(std::move(entry));
+    }
+
+    for (auto& [index, listing] : entries) {
+        const Record& record = records[index];
+        DirectoryListings::Stamp stamp;
+        stamp.id = FileId{record.dev, record.ino};
+        stamp.mtime = record.mtime;
+        stamp.ctime = record.ctime;
+        listings.add(stamp, std::move(listing));
+    }
+    return true;
+#else
+    (void)file;
+    (void)key;
+    (void)listings;
+    return false;
+#endif
+}
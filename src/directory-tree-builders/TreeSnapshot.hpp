@@ -0,0 +1,57 @@
+#pragma once
+#include "DirectoryStructureBuilder.hpp"
+#include "DirectoryListings.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/**
+ * @class TreeSnapshot
+ * @brief Saves a built tree to a compact binary file and rebuilds it from there,
+ * so a later run does not have to list the file system again.
+ *
+ * A snapshot holds one fixed-size record per entry (type, parent, size, mtime,
+ * ctime, device and inode), in the order the tree is visited, followed by an
+ * arena of names. Loading maps the file and reads the records in place.
+ *
+ * Before anything is built, every entry is stat'ed again to confirm it, relative
+ * to its directory's handle. If a directory's mtime or ctime changed, entries may
+ * have been added or removed: the snapshot is stale and nothing is built. Files
+ * whose size or times changed are rebuilt with their new size. A directory
+ * changed while the saved tree was being listed, or just before, is treated as
+ * changed too, since its stamp may not match the entries that were listed.
+ *
+ * A stale snapshot still holds the listings of the directories that did not
+ * change; see loadListings().
+ *
+ * Snapshots are only meant for the machine that wrote them (native byte order,
+ * device numbers). On non-POSIX platforms nothing is saved or loaded.
+ */
+class TreeSnapshot {
+public:
+    /**
+     * @brief Save the tree below root. Written to a temporary file first, then
+     * renamed, so a reader never sees a partial snapshot.
+     * @param key Describes what shaped the tree (root path, link mode, filters);
+     * a snapshot is only loaded with the same key.
+     * @param listed When listing the tree started.
+     * @return false if the snapshot cannot be written
+     */
+    static bool save(Directory& root, const std::filesystem::path& file, const std::string& key,
+                     std::chrono::system_clock::time_point listed);
+
+    /**
+     * @brief Rebuild the tree saved in file through builder, if it is still current.
+     * @return false if there is no valid snapshot with this key, or it is stale;
+     * the builder is then left untouched.
+     */
+    static bool load(const std::filesystem::path& file, DirectoryStructureBuilder& builder, const std::string& key);
+
+    /**
+     * @brief Add the listing of every directory saved in file to listings, so a
+     * traversal only lists the directories changed since.
+     * @return false if there is no valid snapshot with this key
+     */
+    static bool loadListings(const std::filesystem::path& file, const std::string& key, DirectoryListings& listings);
+};
@@ -1,13 +1,35 @@
 #include "Directory.hpp"
 #include "File.hpp"
 #include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <mutex>
 
-size_t Directory::calculateSize() const {
-    size_t totalSize = 0;
-    for (const auto& [path, child] : _children) {
-        totalSize += child->getSize();
+namespace {
+    /// Serializes opening and closing of pinned handles; pins of already pinned directories skip it
+    std::mutex pin_mutex;
+
+    /// Serializes expansions; recursive, since an expander may look into the directory it fills
+    std::recursive_mutex expand_mutex;
+
+    /// Directories a visit keeps pinned at most, innermost first
+    constexpr std::size_t MAX_PINNED_LEVELS = 64;
+}
+
+namespace {
+    /// Names of children are single path components, so comparing the strings
+    /// orders them the same way as comparing them as paths
+    template <typename Child>
+    bool byName(const Child& a, const Child& b) {
+        return a.name < b.name;
+    }
+
+    template <typename Children>
+    auto findChild(Children& children, const std::string& name) {
+        auto it = std::lower_bound(children.begin(), children.end(), name,
+            [](const auto& child, const std::string& key) { return child.name < key; });
+        return (it != children.end() && it->name == name) ? it : children.end();
     }
-    return totalSize;
 }
 
 Directory::Directory(const std::filesystem::path& name, FileObject* owner) 
@@ -17,49 +39,217 @@ std::string Directory::getName() const {
     return _filepath.filename().string();
 }
 
+Directory::~Directory() {
+    // Destroying a deep tree would otherwise recurse once per level
+    std::vector<std::unique_ptr<FileObject>> pending;
+    for (auto& child : _children) {
+        pending.push_back(std::move(child.object));
+    }
+    while (!pending.empty()) {
+        std::unique_ptr<FileObject> object = std::move(pending.back());
+        pending.pop_back();
+        if (auto* dir = dynamic_cast<Directory*>(object.get())) {
+            for (auto& child : dir->_children) {
+                pending.push_back(std::move(child.object));
+            }
+        }
+    }
+}
+
 size_t Directory::getSize() {
-    return calculateSize();
+    // Sizes fetched and entries listed here reach the totals through File::setSize and add()
+    std::vector<Directory*> pending{this};
+    while (!pending.empty()) {
+        Directory* dir = pending.back();
+        pending.pop_back();
+        dir->expand();
+        if (dir->_unsized_count.load() == 0 && dir->_unexpanded_count.load() == 0) {
+            continue;
+        }
+        for (const auto& child : dir->_children) {
+            TreeTotals totals = child.object->getTotals();
+            if (totals.unsized == 0 && totals.unexpanded == 0) {
+                continue;
+            }
+            if (auto* subdir = dynamic_cast<Directory*>(child.object.get())) {
+                pending.push_back(subdir);
+            } else {
+                child.object->getSize();
+            }
+        }
+    }
+    return static_cast<size_t>(_total_size.load());
+}
+
+TreeTotals Directory::getTotals() const {
+    // A directory not listed yet counts itself as unexpanded
+    std::int64_t unexpanded = _unexpanded_count.load() + (isExpanded() ? 0 : 1);
+    return TreeTotals{_total_size.load(), _file_count.load(), _link_count.load(), _unsized_count.load(), unexpanded};
+}
+
+void Directory::setExpander(DirectoryExpander* expander) {
+    DirectoryExpander* previous = _expander.exchange(expander, std::memory_order_acq_rel);
+    if (!previous != !expander) {
+        TreeTotals delta;
+        delta.unexpanded = expander ? 1 : -1;
+        propagateTotals(delta);
+    }
+}
+
+void Directory::expand() const {
+    if (isExpanded()) {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(expand_mutex);
+    DirectoryExpander* expander = _expander.load(std::memory_order_acquire);
+    if (!expander || _expanding) {
+        return;
+    }
+
+    // Entries are listed on demand, even through a const lookup. The directory
+    // counts as expanded even if the expander throws, keeping what it added.
+    struct ExpansionGuard {
+        Directory& dir;
+        ~ExpansionGuard() {
+            dir._expanding = false;
+            dir.setExpander(nullptr);
+        }
+    };
+    auto& self = const_cast<Directory&>(*this);
+    _expanding = true;
+    ExpansionGuard guard{self};
+    expander->expand(self);
+}
+
+void Directory::applyTotals(const TreeTotals& delta) {
+    _total_size.fetch_add(delta.size, std::memory_order_relaxed);
+    _file_count.fetch_add(delta.files, std::memory_order_relaxed);
+    _link_count.fetch_add(delta.links, std::memory_order_relaxed);
+    _unsized_count.fetch_add(delta.unsized, std::memory_order_relaxed);
+    _unexpanded_count.fetch_add(delta.unexpanded, std::memory_order_relaxed);
+    propagateTotals(delta);
+}
+
+void Directory::sortLocked() {
+    if (_sorted_count == _children.size()) {
+        return;
+    }
+    auto middle = _children.begin() + static_cast<std::ptrdiff_t>(_sorted_count);
+    std::stable_sort(middle, _children.end(), byName<Child>);
+    std::inplace_merge(_children.begin(), middle, _children.end(), byName<Child>);
+
+    // Both steps are stable, so of equally named children the one added first is kept
+    auto last = std::unique(_children.begin(), _children.end(),
+        [](const Child& a, const Child& b) { return a.name == b.name; });
+    TreeTotals dropped;
+    for (auto it = last; it != _children.end(); ++it) {
+        dropped += it->object->getTotals();
+    }
+    _children.erase(last, _children.end());
+    _sorted_count = _children.size();
+    applyTotals(-dropped);
+}
+
+void Directory::sortChildren() {
+    std::lock_guard<std::mutex> lock(_children_mutex);
+    sortLocked();
+}
+
+size_t Directory::getChildCount() {
+    expand();
+    std::lock_guard<std::mutex> lock(_children_mutex);
+    sortLocked();
+    return _children.size();
 }
 
 bool Directory::add(std::unique_ptr<FileObject> obj) {
     if (obj == nullptr) {
         return false;
     }
-    auto name = std::filesystem::path(obj->getName());
-    // Same name of a FileObject cannot be added to the Directory
-    if (_children.find(name) != _children.end()) {
-        return false; 
+    std::string name = obj->getName();
+    TreeTotals added = obj->getTotals();
+    std::lock_guard<std::mutex> lock(_children_mutex);
+    sortLocked();
+
+    // Children added in name order, as builders do, are appended without a search
+    auto it = _children.end();
+    if (!_children.empty() && !(_children.back().name < name)) {
+        it = std::lower_bound(_children.begin(), _children.end(), name,
+            [](const Child& child, const std::string& key) { return child.name < key; });
+        // Same name of a FileObject cannot be added to the Directory
+        if (it != _children.end() && it->name == name) {
+            return false;
+        }
     }
 
-    _children[name] = std::move(obj);
-    _children[name]->setOwner(*this);
+    obj->setOwner(*this);
+    _children.insert(it, Child{std::move(name), std::move(obj)});
+    _sorted_count = _children.size();
+    applyTotals(added);
     return true;
 }
 
+FileObject* Directory::append(std::unique_ptr<FileObject> obj) {
+    if (obj == nullptr) {
+        return nullptr;
+    }
+    FileObject* objPtr = obj.get();
+    std::string name = obj->getName();
+    TreeTotals added = obj->getTotals();
+    obj->setOwner(*this);
+
+    std::lock_guard<std::mutex> lock(_children_mutex);
+    bool in_order = _sorted_count == _children.size()
+                    && (_children.empty() || _children.back().name < name);
+    _children.push_back(Child{std::move(name), std::move(obj)});
+    if (in_order) {
+        _sorted_count = _children.size();
+    }
+    applyTotals(added);
+    return objPtr;
+}
+
 bool Directory::remove(const std::filesystem::path& path) {
     if (path.empty()) {
         return false;
     }
-    auto it = _children.find(path);
+    expand();
+    std::lock_guard<std::mutex> lock(_children_mutex);
+    sortLocked();
+    auto it = findChild(_children, path.string());
     if (it != _children.end()) {
+        applyTotals(-it->object->getTotals());
         _children.erase(it);
+        _sorted_count = _children.size();
         return true;
     }
     return false;
 }
 
-FileObject* Directory::getChild(const std::filesystem::path& name) noexcept {
-    auto it = _children.find(name);
+FileObject* Directory::getChild(const std::filesystem::path& name) {
+    expand();
+    std::lock_guard<std::mutex> lock(_children_mutex);
+    sortLocked();
+    auto it = findChild(_children, name.string());
     if (it != _children.end()) {
-        return it->second.get();
+        return it->object.get();
     }
     return nullptr;
 }
 
-const FileObject* Directory::getChild(const std::filesystem::path& name) const noexcept {
-    auto it = _children.find(name);
+const FileObject* Directory::getChild(const std::filesystem::path& name) const {
+    expand();
+    std::lock_guard<std::mutex> lock(_children_mutex);
+    // Without sorting, the appended tail is searched in order; the first of equal names wins
+    auto sorted_end = _children.begin() + static_cast<std::ptrdiff_t>(_sorted_count);
+    std::string key = name.string();
+    auto it = std::lower_bound(_children.begin(), sorted_end, key,
+        [](const Child& child, const std::string& k) { return child.name < k; });
+    if (it == sorted_end || it->name != key) {
+        it = std::find_if(sorted_end, _children.end(), [&](const Child& child) { return child.name == key; });
+    }
     if (it != _children.end()) {
-        return it->second.get();
+        return it->object.get();
     }
     return nullptr;
 }
@@ -87,9 +277,139 @@ File* Directory::createFile(const std::filesystem::path& name) {
 }
 
 void Directory::accept(DirectoryIterationVisitor& visitor) {
-    visitor.visitDirectory(*this);
+    // Directories being visited, innermost last, instead of one call per level;
+    // only the innermost ones stay pinned, so deep trees do not run out of descriptors
+    struct Frame {
+        Directory* dir;
+        std::size_t next;
+        bool pinned;
+    };
+    std::vector<Frame> stack;
+    // Visitors that only look at names and sizes would open a descriptor per directory for nothing
+    const bool pins = visitor.readsFiles();
+    auto enter = [&](Directory& dir) {
+        dir.expand();
+        visitor.visitDirectory(dir);
+        dir.sortChildren();
+        if (pins) {
+            dir.pin();
+        }
+        stack.push_back(Frame{&dir, 0, pins});
+        if (pins && stack.size() > MAX_PINNED_LEVELS) {
+            Frame& outer = stack[stack.size() - 1 - MAX_PINNED_LEVELS];
+            if (outer.pinned) {
+                outer.dir->unpin();
+                outer.pinned = false;
+            }
+        }
+    };
+
+    try {
+        enter(*this);
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            if (top.next == top.dir->_children.size()) {
+                if (top.pinned) {
+                    top.dir->unpin();
+                }
+                stack.pop_back();
+                continue;
+            }
+            if (pins && !top.pinned) {
+                top.dir->pin();
+                top.pinned = true;
+            }
+
+            FileObject* child = top.dir->_children[top.next++].object.get();
+            if (auto* dir = dynamic_cast<Directory*>(child)) {
+                enter(*dir);
+            } else {
+                child->accept(visitor);
+            }
+        }
+    } catch (...) {
+        for (const auto& frame : stack) {
+            if (frame.pinned) {
+                frame.dir->unpin();
+            }
+        }
+        throw;
+    }
+}
+
+void Directory::pin() {
+    if (tryPin()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(pin_mutex);
+    if (_pins.load() > 0) {
+        _pins.fetch_add(1);
+        return;
+    }
+
+    // Nobody holds a pin, and tryPin() fails until the count is published below,
+    // so the handle can be replaced before anyone reads it
+    DirectoryHandle handle;
+    // Open relative to the parent when it is pinned, so only one component is resolved
+    auto* parent = dynamic_cast<Directory*>(_owner);
+    if (parent && parent->_pins.load() > 0 && parent->handle() >= 0) {
+        handle = DirectoryHandle::open(parent->handle(), getName());
+    } else {
+        handle = DirectoryHandle::open(-1, _filepath);
+#ifdef ENAMETOOLONG
+        if (!handle.isOpen() && errno == ENAMETOOLONG) {
+            handle = openByNames();
+        }
+#endif
+    }
+    _handle = std::move(handle);
+    _handle_fd.store(_handle.fd(), std::memory_order_release);
+    _pins.fetch_add(1);
+}
 
-    for(const auto& [name, child] : _children) {
-        child->accept(visitor);
+DirectoryHandle Directory::openByNames() const {
+    // Handles of pinned directories are only closed under pin_mutex, which the caller holds
+    std::vector<const Directory*> chain{this};
+    int parent = -1;
+    for (auto* dir = dynamic_cast<Directory*>(_owner); dir; dir = dynamic_cast<Directory*>(dir->_owner)) {
+        if (dir->_pins.load() > 0 && dir->handle() >= 0) {
+            parent = dir->handle();
+            break;
+        }
+        chain.push_back(dir);
+    }
+
+    DirectoryHandle dir;
+    if (parent < 0) {
+        // Nothing above is pinned: the outermost directory is opened by its path
+        dir = DirectoryHandle::open(-1, chain.back()->_filepath);
+        chain.pop_back();
+        parent = dir.fd();
+    }
+    for (auto it = chain.rbegin(); it != chain.rend() && parent >= 0; ++it) {
+        dir = DirectoryHandle::open(parent, (*it)->getName());
+        parent = dir.fd();
+    }
+    return dir;
+}
+
+bool Directory::tryPin() noexcept {
+    int pins = _pins.load();
+    while (pins > 0) {
+        if (_pins.compare_exchange_weak(pins, pins + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Directory::unpin() noexcept {
+    if (_pins.fetch_sub(1) != 1) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(pin_mutex);
+    if (_pins.load() == 0) {
+        _handle_fd.store(-1, std::memory_order_release);
+        _handle.close();
     }
 }
\ No newline at end of file
@@ -1,18 +1,36 @@
 #pragma once
 
 #include "FileObject.hpp"
-#include <map>
+#include "DirectoryHandle.hpp"
+#include "DirectoryExpander.hpp"
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 /**
  * @class child class, that represents the "Composite" in the Composite pattern.
  * 
  * It represents a directory in the file system.
+ * Children are kept in a contiguous vector sorted by name, so lookups are binary
+ * searches and visiting them walks memory in order.
+ * Adding, removing and looking up children is thread-safe, so a tree can be
+ * filled by several threads; iterating over the children is not.
+ *
+ * A directory with an expander is populated lazily: its entries are listed when
+ * it is first visited, looked up in, counted or sized. Totals only cover what has
+ * been listed so far.
  */
 class Directory: public FileObject {
 public:
     Directory(const std::filesystem::path& name, FileObject* owner = nullptr);
 
+    /**
+     * @brief Destroys the subtree level by level, without recursing per level.
+     */
+    ~Directory() override;
+
     /**multiple
      * @brief Factory method to create a subdirectory and add it to this directory
      * @param name - name of the new subdirectory
@@ -39,28 +57,143 @@ public:
      */
     bool remove(const std::filesystem::path&) override;
 
+    /**
+     * @brief Bulk insertion for builders: append a child without looking for its
+     * place. Appended children are sorted once, by sortChildren() or by the next
+     * lookup, instead of shifting the vector on every insertion.
+     *
+     * The caller must not append a name that is already taken; such a child is
+     * discarded when the children are sorted.
+     * @return raw pointer to the appended child (ownership transferred to this directory)
+     */
+    FileObject* append(std::unique_ptr<FileObject> obj);
+
+    /**
+     * @brief Leave listing this directory's entries to expander (non-owning),
+     * until something needs them; nullptr marks it as complete.
+     */
+    void setExpander(DirectoryExpander* expander);
+
+    /**
+     * @return false while the entries are still to be listed by an expander
+     */
+    bool isExpanded() const noexcept { return _expander.load(std::memory_order_acquire) == nullptr; }
+
+    /**
+     * @brief Sort the children appended since the last sort into place.
+     */
+    void sortChildren();
+
+    size_t getChildCount();
+
     /**
      * @brief Get a child Component from the Composite collection
      * @param index - index of the child to get
      * @return pointer to the child FileObject, or nullptr if not found
      */
-    FileObject* getChild(const std::filesystem::path& name) noexcept override;
-    const FileObject* getChild(const std::filesystem::path& name) const noexcept override;
+    FileObject* getChild(const std::filesystem::path& name) override;
+    const FileObject* getChild(const std::filesystem::path& name) const override;
 
     std::string getName() const override;
 
+    /**
+     * @brief Total size of the files below this directory, kept up to date as the
+     * tree is built. Only files whose size was never fetched are stat'ed, and only
+     * directories not yet listed are expanded.
+     */
     size_t getSize() override;
 
+    /**
+     * @return sizes and counts of everything below this directory, in O(1)
+     */
+    TreeTotals getTotals() const override;
+
+    /**
+     * @brief Visit this directory, then its children, depth first. Subdirectories
+     * are walked with an explicit stack, so the depth of the tree is not limited by
+     * the call stack. For visitors that read files, a directory is pinned while its
+     * children are visited, except for outer ones when the walk is deep.
+     */
     void accept(DirectoryIterationVisitor& visitor) override;
+
+    /**
+     * @brief Keep a handle to this directory open, so that its children are opened
+     * relative to it instead of resolving their full path on every syscall.
+     * Pins are counted; the handle is closed by the last unpin(). Thread-safe.
+     */
+    void pin();
+
+    /**
+     * @brief Add a pin only if the directory is already pinned.
+     * @return true if pinned; the caller must then unpin()
+     */
+    bool tryPin() noexcept;
+
+    void unpin() noexcept;
+
+    /**
+     * @return descriptor of the pinned directory, or -1. Only valid while the caller holds a pin.
+     */
+    int handle() const noexcept { return _handle_fd.load(std::memory_order_acquire); }
+
+    /**
+     * @brief RAII helper holding a pin for the lifetime of the object
+     */
+    class Pin {
+    public:
+        explicit Pin(Directory& dir) : _dir(dir) { _dir.pin(); }
+        ~Pin() { _dir.unpin(); }
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+    private:
+        Directory& _dir;
+    };
+protected:
+    void applyTotals(const TreeTotals& delta) override;
+
 private:
+
+    struct Child {
+        std::string name;
+        std::unique_ptr<FileObject> object;
+    };
+
+    /**
+     * @brief Merge the appended tail into the sorted prefix. Called with _children_mutex held.
+     */
+    void sortLocked();
+
     /**
-     * @brief Calculate the size of the whole 
-     * directory by summing all children's sizes
+     * @brief Open this directory one name at a time from the nearest pinned
+     * ancestor (or the outermost one), for paths too long to be opened whole.
+     * Called with pin_mutex held.
+     * @return the handle; not open on failure
      */
-    size_t calculateSize() const;
+    DirectoryHandle openByNames() const;
 
     /**
-     * @brief name of file - pointer to object
+     * @brief List the entries through the expander, if they have not been yet.
      */
-    std::map<std::filesystem::path, std::unique_ptr<FileObject>> _children;
+    void expand() const;
+
+    /**
+     * @brief Children sorted by name up to _sorted_count; appended ones follow unsorted
+     */
+    std::vector<Child> _children;
+    size_t _sorted_count = 0;
+    mutable std::mutex _children_mutex;
+
+    /// Totals of the children, updated atomically as threads fill the tree
+    std::atomic<std::int64_t> _total_size{0};
+    std::atomic<std::int64_t> _file_count{0};
+    std::atomic<std::int64_t> _link_count{0};
+    std::atomic<std::int64_t> _unsized_count{0};
+    std::atomic<std::int64_t> _unexpanded_count{0};
+
+    mutable std::atomic<DirectoryExpander*> _expander{nullptr};
+    mutable bool _expanding = false; ///< Set while the expander runs; guarded by the expansion lock
+
+    DirectoryHandle _handle;
+    std::atomic<int> _handle_fd{-1};
+    std::atomic<int> _pins{0};
 };
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+class Directory;
+
+/**
+ * @class DirectoryExpander
+ * @brief Fills a lazily populated Directory with its entries, the first time
+ * they are needed (see Directory::setExpander).
+ */
+class DirectoryExpander {
+public:
+    virtual ~DirectoryExpander() = default;
+
+    /**
+     * @brief Add the entries of dir. Called at most once per directory, with
+     * expansions serialized; lookups in dir made meanwhile do not expand it again.
+     * Errors listing entries are reported and the directory is left with what
+     * could be listed; an exception thrown here reaches the lookup that expanded
+     * dir, which still counts as expanded with the entries added so far.
+     */
+    virtual void expand(Directory& dir) = 0;
+};
@@ -0,0 +1,43 @@
+#include "DirectoryHandle.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+DirectoryHandle::~DirectoryHandle() {
+    close();
+}
+
+DirectoryHandle::DirectoryHandle(DirectoryHandle&& other) noexcept : _fd(other._fd) {
+    other._fd = -1;
+}
+
+DirectoryHandle& DirectoryHandle::operator=(DirectoryHandle&& other) noexcept {
+    if (this != &other) {
+        close();
+        _fd = other._fd;
+        other._fd = -1;
+    }
+    return *this;
+}
+
+DirectoryHandle DirectoryHandle::open(int parent, const std::filesystem::path& path) noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+    int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    return DirectoryHandle(::openat(parent >= 0 ? parent : AT_FDCWD, path.c_str(), flags));
+#else
+    (void)parent;
+    (void)path;
+    return DirectoryHandle();
+#endif
+}
+
+void DirectoryHandle::close() noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+#endif
+    _fd = -1;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <filesystem>
+
+/**
+ * @class DirectoryHandle
+ * @brief Owning wrapper around an open directory file descriptor (POSIX only).
+ *
+ * Lets entries be opened and stat'ed relative to their directory (openat/fstatat),
+ * so the kernel does not resolve the full path again for every entry.
+ * On other platforms a handle is never open and callers fall back to full paths.
+ */
+class DirectoryHandle {
+public:
+    DirectoryHandle() noexcept = default;
+    ~DirectoryHandle();
+
+    DirectoryHandle(DirectoryHandle&& other) noexcept;
+    DirectoryHandle& operator=(DirectoryHandle&& other) noexcept;
+    DirectoryHandle(const DirectoryHandle&) = delete;
+    DirectoryHandle& operator=(const DirectoryHandle&) = delete;
+
+    /**
+     * @brief Open a directory.
+     * @param parent Descriptor the path is relative to; -1 means the working directory.
+     * @param path Directory to open.
+     * @return the handle; not open on failure (errno is preserved).
+     */
+    static DirectoryHandle open(int parent, const std::filesystem::path& path) noexcept;
+
+    /// @return the descriptor, or -1 if not open
+    int fd() const noexcept { return _fd; }
+
+    bool isOpen() const noexcept { return _fd >= 0; }
+
+    void close() noexcept;
+
+private:
+    explicit DirectoryHandle(int fd) noexcept : _fd(fd) {}
+
+    int _fd = -1;
+};
@@ -5,8 +5,131 @@
 #include "File.hpp"
 #include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#endif
+
+namespace {
+    constexpr std::size_t READ_CHUNK = 256 * 1024;
+
+#if defined(__unix__) || defined(__APPLE__)
+    /// Closes the descriptor even if a chunk consumer throws
+    struct FileDescriptor {
+        int fd;
+        ~FileDescriptor() { if (fd >= 0) ::close(fd); }
+    };
+
+    /**
+     * @brief Run op with the descriptor of the owning directory if it is pinned,
+     * or with -1 (meaning: use the full path) otherwise. A path too long to be
+     * resolved has its owner pinned for the call instead.
+     */
+    template <class Op>
+    auto withOwnerHandle(FileObject* owner, bool relative_to_owner, const std::filesystem::path& path, Op op) {
+        auto* dir = relative_to_owner ? dynamic_cast<Directory*>(owner) : nullptr;
+        if (dir && dir->tryPin()) {
+            int dir_fd = dir->handle();
+            auto result = op(dir_fd);
+            dir->unpin();
+            return result;
+        }
+#ifdef PATH_MAX
+        if (dir && path.native().size() >= PATH_MAX) {
+            Directory::Pin pin(*dir);
+            return op(dir->handle());
+        }
+#endif
+        return op(-1);
+    }
+
+    /**
+     * @brief Read from the current offset up to end (or EOF when end is -1).
+     * @return offset reached
+     */
+    off_t readRange(int fd, off_t pos, off_t end, std::vector<char>& buffer,
+                    const File::ChunkConsumer& consumer, const std::filesystem::path& path) {
+        while (end < 0 || pos < end) {
+            std::size_t want = buffer.size();
+            if (end >= 0) {
+                want = static_cast<std::size_t>(std::min<off_t>(end - pos, static_cast<off_t>(want)));
+            }
+            ssize_t got = ::read(fd, buffer.data(), want);
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                throw std::ios_base::failure("Error: Failed to read data from file: " + path.string());
+            }
+            if (got == 0) break;
+            consumer(buffer.data(), static_cast<std::size_t>(got));
+            pos += got;
+        }
+        return pos;
+    }
+
+    /// Feed a hole to the consumer without touching the filesystem
+    void feedZeros(off_t length, const File::ChunkConsumer& consumer) {
+        static const char zero_page[READ_CHUNK] = {};
+        while (length > 0) {
+            std::size_t take = static_cast<std::size_t>(std::min<off_t>(length, static_cast<off_t>(READ_CHUNK)));
+            consumer(zero_page, take);
+            length -= static_cast<off_t>(take);
+        }
+    }
+
+    /**
+     * @brief Read a sparse file range by range: data ranges are read, holes
+     * are fed as zeros, so the consumer sees exactly what a dense read returns.
+     * @return offset reached; the rest (if the file grew meanwhile) is read densely
+     */
+    off_t readSparse(int fd, off_t size, std::vector<char>& buffer,
+                     const File::ChunkConsumer& consumer, const std::filesystem::path& path) {
+        off_t pos = 0;
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+        while (pos < size) {
+            off_t data = ::lseek(fd, pos, SEEK_DATA);
+            if (data < 0) {
+                if (errno != ENXIO) {
+                    // The filesystem cannot report holes; read the rest densely
+                    break;
+                }
+                // No data past pos: the file ends in a hole
+                data = size;
+            }
+            data = std::min(data, size);
+            feedZeros(data - pos, consumer);
+            pos = data;
+            if (pos >= size) {
+                break;
+            }
+
+            off_t hole = ::lseek(fd, data, SEEK_HOLE);
+            if (hole < 0 || hole > size) {
+                hole = size;
+            }
+            if (::lseek(fd, data, SEEK_SET) < 0) {
+                throw std::ios_base::failure("Error: Failed to read data from file: " + path.string());
+            }
+            pos = readRange(fd, data, hole, buffer, consumer, path);
+            if (pos < hole) {
+                // Truncated while reading
+                return pos;
+            }
+        }
+        ::lseek(fd, pos, SEEK_SET);
+#else
+        (void)fd; (void)size; (void)buffer; (void)consumer; (void)path;
+#endif
+        return pos;
+    }
+#endif
+}
+
 File::File(const std::filesystem::path& name, FileObject* owner)
-    : FileObject(name, owner)
+    : FileObject(name, owner), _relative_to_owner(!name.has_parent_path())
 {
     if (!owner) {
         throw std::logic_error("File without owning directory is invalid");
@@ -21,56 +144,125 @@ std::string File::getName() const {
 }
 
 size_t File::getSize() {
-    if (_size != 0) {
+    if (_size_known) {
+        return _size;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat st {};
+    bool found = withOwnerHandle(_owner, _relative_to_owner, _filepath, [&](int dir_fd) {
+        return dir_fd >= 0
+            ? ::fstatat(dir_fd, getName().c_str(), &st, 0) == 0
+            : ::stat(_filepath.c_str(), &st) == 0;
+    });
+    if (found && S_ISREG(st.st_mode)) {
+        setInode(FileId{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)},
+                 static_cast<std::uint64_t>(st.st_nlink));
+        setSize(static_cast<size_t>(st.st_size));
         return _size;
     }
+#else
     std::error_code ec;
     if (std::filesystem::exists(_filepath, ec) && std::filesystem::is_regular_file(_filepath, ec)) {
         auto sz = std::filesystem::file_size(_filepath, ec);
         if (!ec) {
-            _size = static_cast<size_t>(sz);
+            setSize(static_cast<size_t>(sz));
             return _size;
         }
     }
+#endif
     return 0;
 }
 
 bool File::setSize(size_t size) {
+    TreeTotals delta;
+    delta.size = static_cast<std::int64_t>(size) - (_size_known ? static_cast<std::int64_t>(_size) : 0);
+    delta.unsized = _size_known ? 0 : -1;
     _size = size;
+    _size_known = true;
+    propagateTotals(delta);
     return true;
 }
 
+void File::setInode(const FileId& id, std::uint64_t links) {
+    if (links > 1) {
+        _inode = id;
+    }
+}
+
+std::optional<FileId> File::getSharedInode() const {
+    if (_inode == FileId()) {
+        return std::nullopt;
+    }
+    return _inode;
+}
+
+TreeTotals File::getTotals() const {
+    TreeTotals totals;
+    totals.size = _size_known ? static_cast<std::int64_t>(_size) : 0;
+    totals.files = 1;
+    totals.unsized = _size_known ? 0 : 1;
+    return totals;
+}
+
 std::vector<char> File::read() const {
+    std::vector<char> contents;
+    contents.reserve(_size);
+    read([&contents](const char* data, std::size_t size) {
+        contents.insert(contents.end(), data, data + size);
+    });
+    return contents;
+}
+
+void File::read(const ChunkConsumer& consumer) const {
+    std::vector<char> buffer(READ_CHUNK);
+    read(consumer, buffer);
+}
+
+void File::read(const ChunkConsumer& consumer, std::vector<char>& buffer) const {
+    if (buffer.size() < READ_CHUNK) {
+        buffer.resize(READ_CHUNK);
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    FileDescriptor file{openForReading()};
+    if (file.fd < 0) {
+        throw std::ios_base::failure("Error: Failed to open file for reading: " + _filepath.string());
+    }
+
+    off_t pos = 0;
+    struct stat st {};
+    // Fewer allocated blocks than the size means the file has holes
+    if (::fstat(file.fd, &st) == 0 && S_ISREG(st.st_mode)
+        && static_cast<off_t>(st.st_blocks) * 512 < st.st_size) {
+        pos = readSparse(file.fd, st.st_size, buffer, consumer, _filepath);
+    }
+    readRange(file.fd, pos, -1, buffer, consumer, _filepath);
+#else
     std::ifstream file_stream(_filepath, std::ios::in | std::ios::binary);
     if (!file_stream.is_open()) {
         throw std::ios_base::failure("Error: Failed to open file for reading: " + _filepath.string());
     }
-
-    std::error_code ec;
-    size_t file_size = 0;
-    if (std::filesystem::exists(_filepath, ec) && std::filesystem::is_regular_file(_filepath, ec)) {
-        auto sz = std::filesystem::file_size(_filepath, ec);
-        if (ec) {
-            file_stream.close();
-            throw std::ios_base::failure("Error: Failed to get file size: " + _filepath.string());
-        }
-        file_size = static_cast<size_t>(sz);
-    } else {
-        file_stream.close();
-        throw std::ios_base::failure("Error: File does not exist: " + _filepath.string());
-    }
-
-    std::vector<char> contents(file_size);
-    if (file_size > 0) {
-        file_stream.read(contents.data(), static_cast<std::streamsize>(file_size));
-        if (file_stream.fail() && !file_stream.eof()) {
-            file_stream.close();
-            throw std::ios_base::failure("Error: Failed to read data from file: " + _filepath.string());
-        }
+    while (file_stream) {
+        file_stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize got = file_stream.gcount();
+        if (got <= 0) break;
+        consumer(buffer.data(), static_cast<std::size_t>(got));
+    }
+    if (file_stream.bad()) {
+        throw std::ios_base::failure("Error: Failed to read data from file: " + _filepath.string());
     }
+#endif
+}
 
-    file_stream.close();
-    return contents;
+int File::openForReading() const {
+#if defined(__unix__) || defined(__APPLE__)
+    return withOwnerHandle(_owner, _relative_to_owner, _filepath, [&](int dir_fd) {
+        return dir_fd >= 0
+            ? ::openat(dir_fd, getName().c_str(), O_RDONLY | O_CLOEXEC)
+            : ::open(_filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    });
+#else
+    return -1;
+#endif
 }
 
 #ifdef DEBUG
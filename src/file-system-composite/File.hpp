@@ -1,9 +1,12 @@
 #pragma once
 #include "FileObject.hpp"
 #include "Directory.hpp"
+#include "FileId.hpp"
 #include <vector>
 #include <fstream>
 #include <filesystem>
+#include <functional>
+#include <optional>
 
 /**
  * @class File
@@ -14,6 +17,9 @@
  */
 class File : public FileObject {
 public:
+    /// Receives consecutive chunks of file data
+    using ChunkConsumer = std::function<void(const char* data, std::size_t size)>;
+
     /**
      * @brief Construct a file object with a name within an owning directory.
      * @param name File name (no path separators expected).
@@ -29,24 +35,63 @@ public:
      * @brief Return the file size.
      *
      * If a size was previously set explicitly via setSize, that cached value
-     * is returned. Otherwise, if the path exists on the filesystem, the size
-     * is fetched via std::filesystem::file_size and cached.
+     * is returned, even if it is 0. Otherwise, if the path exists on the filesystem,
+     * the size is fetched with a single stat (relative to the owning directory when
+     * it is pinned) and cached.
      * If the file does not exist, returns 0.
      */
     size_t getSize() override;
 
     /**
      * @brief Set the cached size (useful for tests/mocks).
+     * The owning directories' totals are updated.
      * @return true (size is always cached successfully).
      */
     bool setSize(size_t) override;
 
+    TreeTotals getTotals() const override;
+
+    /**
+     * @brief Record the inode holding the file's data, so hard links to it can be recognized.
+     * @param links Number of names of the inode (st_nlink); with a single name nothing is recorded.
+     */
+    void setInode(const FileId& id, std::uint64_t links);
+
+    /**
+     * @return the inode if other names (hard links) share it, or nothing if the file
+     * has a single name or its inode is not known
+     */
+    std::optional<FileId> getSharedInode() const;
+
     /**
      * @brief Read the file contents from disk in binary mode.
+     * Opened relative to the owning directory when it is pinned.
      * @throws std::ios_base::failure if the file cannot be opened or read.
      */
     std::vector<char> read() const override;
 
+    /**
+     * @brief Read the file contents from disk in consecutive chunks,
+     * without holding the whole file in memory.
+     * Holes of sparse files are not read; they are passed as zero-filled chunks.
+     * @param consumer Called with each chunk, in file order.
+     * @throws std::ios_base::failure if the file cannot be opened or read.
+     */
+    void read(const ChunkConsumer& consumer) const;
+
+    /**
+     * @brief Same as read(consumer), reading through a buffer the caller reuses
+     * across files instead of allocating one per file; it is grown if too small.
+     */
+    void read(const ChunkConsumer& consumer, std::vector<char>& buffer) const;
+
+    /**
+     * @brief Open the file read-only, relative to the owning directory when it is pinned.
+     * @return a descriptor the caller must close, or -1 if the file cannot be opened
+     * (always on non-POSIX platforms)
+     */
+    int openForReading() const;
+
 #ifdef DEBUG
     /**
      * @brief Read the file contents from a provided input stream (for testing).
@@ -60,4 +105,12 @@ public:
 
 private:
     size_t _size = 0; 
+    bool _size_known = false;
+    FileId _inode; ///< Set only for files with several names
+
+    /**
+     * @brief True when the file name is a plain entry of the owning directory,
+     * so it can be opened relative to that directory's pinned handle
+     */
+    bool _relative_to_owner = false;
 };
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Identity of a file system object: device and inode of what a path resolves to.
+ * The all-zero identity means "unknown".
+ */
+struct FileId {
+    std::uint64_t dev = 0;
+    std::uint64_t ino = 0;
+
+    bool operator==(const FileId& other) const { return dev == other.dev && ino == other.ino; }
+    bool operator!=(const FileId& other) const { return !(*this == other); }
+};
+
+struct FileIdHash {
+    std::size_t operator()(const FileId& id) const noexcept {
+        std::uint64_t h = id.ino * 0x9E3779B97F4A7C15ull ^ (id.dev + 0x632BE59BD9B4E019ull);
+        h ^= h >> 29;
+        return static_cast<std::size_t>(h);
+    }
+};
@@ -1,5 +1,6 @@
 #include "FileObject.hpp"
 #include "File.hpp"
+#include "Link.hpp"
 
 FileObject::FileObject(const std::filesystem::path& name, FileObject* owner) 
     : _owner(owner) {
@@ -26,7 +27,8 @@ void FileObject::buildPath(const std::filesystem::path& name, FileObject* owner)
         // Owner must be a Directory (or Link, but we'll treat it as a generic FileObject)
         // If there is a path already
         if (!owner->_filepath.empty()) {
-            _filepath = owner->_filepath / name;
+            // The resolved target of a link is reached at the link's own path
+            _filepath = dynamic_cast<Link*>(owner) ? owner->_filepath : owner->_filepath / name;
         } else { 
             throw std::logic_error("This should not be reached."
                  "Owning directory has no saved path for some reason, even its own name..");
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <istream>
 #include <fstream>
@@ -9,6 +10,31 @@
 
 class DirectoryIterationVisitor;
 
+/**
+ * @brief Sizes and counts of a subtree. Directories keep them up to date while
+ * children are added, removed or sized, so they can be read without a walk.
+ */
+struct TreeTotals {
+    std::int64_t size = 0;    ///< Bytes of the files whose size is known
+    std::int64_t files = 0;
+    std::int64_t links = 0;
+    std::int64_t unsized = 0; ///< Files whose size has not been fetched yet
+    std::int64_t unexpanded = 0; ///< Directories whose entries have not been listed yet
+
+    TreeTotals& operator+=(const TreeTotals& other) {
+        size += other.size;
+        files += other.files;
+        links += other.links;
+        unsized += other.unsized;
+        unexpanded += other.unexpanded;
+        return *this;
+    }
+
+    TreeTotals operator-() const {
+        return TreeTotals{-size, -files, -links, -unsized, -unexpanded};
+    }
+};
+
 /**
  * @class abstract class, serves as the "Component" class 
  * in the Composite pattern. 
@@ -58,8 +84,8 @@ public:
      * @return pointer to the child FileObject, or nullptr if not found
      * Defaults to nullptr so that it can not be overriden by the Leaf class.
      */
-    virtual FileObject* getChild(const std::filesystem::path& name) noexcept { return nullptr; }
-    virtual const FileObject* getChild(const std::filesystem::path& name) const noexcept { return nullptr; } 
+    virtual FileObject* getChild(const std::filesystem::path& name) { return nullptr; }
+    virtual const FileObject* getChild(const std::filesystem::path& name) const { return nullptr; } 
 
     /**
      * @brief Factory method to create a file and add it to this FileObject
@@ -78,9 +104,10 @@ public:
     virtual class Directory* createSubdirectory(const std::filesystem::path& name) { return nullptr; }
 
     /**
-     * @brief set owner of current object
+     * @brief set owner of current object, once the owner holds it.
+     * From then on, changes of this object's totals are passed on to the owner.
      */
-    void setOwner(FileObject& owner) { _owner = &owner; }
+    void setOwner(FileObject& owner) { _owner = &owner; _held = true; }
     
     /**
      * @return pointer to owner of current object
@@ -102,6 +129,10 @@ public:
 
     virtual FileObject* getResolvedTarget() const { return nullptr; }
 
+    /**
+     * @return sizes and counts of this object and everything below it
+     */
+    virtual TreeTotals getTotals() const { return TreeTotals(); }
 
     /**
      * @brief Visitor methods
@@ -118,6 +149,20 @@ protected:
      */
     FileObject(const std::filesystem::path& name, FileObject* owner);
 
+    /**
+     * @brief Apply a change of a child's totals to this object and its owners
+     */
+    virtual void applyTotals(const TreeTotals& delta) { propagateTotals(delta); }
+
+    /**
+     * @brief Pass a change of this object's totals on to its owner, if the owner holds it
+     */
+    void propagateTotals(const TreeTotals& delta) {
+        if (_held && _owner) {
+            _owner->applyTotals(delta);
+        }
+    }
+
 
     std::filesystem::path _filepath; ///< Whole path to object
 
@@ -126,6 +171,8 @@ protected:
      * Should not be released
      */
     FileObject* _owner = nullptr;
+
+    bool _held = false; ///< Whether _owner holds this object (and counts it in its totals)
 private:
     void buildPath(const std::filesystem::path& name, FileObject* owner);
 };
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "FileTable.hpp"
+#include "Directory.hpp"
+#include "File.hpp"
+#include "Link.hpp"
+#include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace {
+    constexpr std::size_t INITIAL_INDEX_BUCKETS = 1024;
+}
+
+FileTable::FileTable()
+    : _names(std::make_unique<std::string>()),
+      _name_index(INITIAL_INDEX_BUCKETS, NameHash{_names.get()}, NameEqual{_names.get()}) {}
+
+std::size_t FileTable::NameHash::operator()(std::uint32_t offset) const {
+    return std::hash<std::string_view>()(std::string_view(names->c_str() + offset));
+}
+
+bool FileTable::NameEqual::operator()(std::uint32_t a, std::uint32_t b) const {
+    return std::string_view(names->c_str() + a) == std::string_view(names->c_str() + b);
+}
+
+std::uint32_t FileTable::intern(std::string_view name) {
+    std::string& names = *_names;
+    if (names.size() + name.size() + 1 > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error("File table name arena is full");
+    }
+    if (_name_index.empty() && !names.empty()) {
+        // Dropped by shrink(); rebuild it before adding more names
+        for (std::size_t offset = 0; offset < names.size(); offset += nameAt(static_cast<std::uint32_t>(offset)).size() + 1) {
+            _name_index.insert(static_cast<std::uint32_t>(offset));
+        }
+    }
+
+    // Append tentatively, so the index can compare against it; take it back if it is known
+    auto offset = static_cast<std::uint32_t>(names.size());
+    names.append(name);
+    names.push_back('\0');
+    auto [it, inserted] = _name_index.insert(offset);
+    if (!inserted) {
+        names.resize(offset);
+        return *it;
+    }
+    return offset;
+}
+
+FileTable::Index FileTable::append(Index parent, std::uint32_t name, Type type, std::uint64_t size, std::int64_t mtime) {
+    if (_parent.size() >= NO_PARENT) {
+        throw std::length_error("File table is full");
+    }
+    _parent.push_back(parent);
+    _name.push_back(name);
+    _type.push_back(static_cast<std::uint8_t>(type));
+    _size.push_back(size);
+    _mtime.push_back(mtime);
+    _first_child.push_back(0);
+    _child_count.push_back(0);
+    return static_cast<Index>(_parent.size() - 1);
+}
+
+FileTable::Index FileTable::addRoot(const std::filesystem::path& path, std::int64_t mtime) {
+    if (!empty()) {
+        throw std::logic_error("File table already has a root");
+    }
+    return append(NO_PARENT, intern(path.string()), Type::Directory, 0, mtime);
+}
+
+FileTable::Index FileTable::addChildren(Index dir, std::vector<Entry>& children) {
+    if (dir >= size() || type(dir) != Type::Directory) {
+        throw std::logic_error("Children can only be added to a directory");
+    }
+    if (_child_count[dir] != 0) {
+        throw std::logic_error("Directory children were already added");
+    }
+
+    // The same order in which a Directory iterates its children
+    std::sort(children.begin(), children.end(), [](const Entry& a, const Entry& b) {
+        return std::filesystem::path(a.name) < std::filesystem::path(b.name);
+    });
+
+    auto first = static_cast<Index>(size());
+    for (const auto& child : children) {
+        Index i = append(dir, intern(child.name), child.type, child.size, child.mtime);
+        if (child.type == Type::Link) {
+            _link_targets[i] = intern(child.link_target);
+        }
+    }
+    _first_child[dir] = first;
+    _child_count[dir] = static_cast<Index>(children.size());
+    return first;
+}
+
+void FileTable::shrink() {
+    _name_index = decltype(_name_index)(0, NameHash{_names.get()}, NameEqual{_names.get()});
+    _parent.shrink_to_fit();
+    _name.shrink_to_fit();
+    _type.shrink_to_fit();
+    _size.shrink_to_fit();
+    _mtime.shrink_to_fit();
+    _first_child.shrink_to_fit();
+    _child_count.shrink_to_fit();
+    _names->shrink_to_fit();
+}
+
+std::string FileTable::linkTarget(Index i) const {
+    auto it = _link_targets.find(i);
+    return it != _link_targets.end() ? std::string(nameAt(it->second)) : std::string();
+}
+
+std::filesystem::path FileTable::path(Index i) const {
+    std::vector<Index> chain;
+    for (Index at = i; at != NO_PARENT; at = _parent[at]) {
+        chain.push_back(at);
+    }
+    std::filesystem::path result;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        result /= std::filesystem::path(std::string(name(*it)));
+    }
+    return result;
+}
+
+std::uint64_t FileTable::totalSize() const {
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < size(); ++i) {
+        if (_type[i] == static_cast<std::uint8_t>(Type::File)) {
+            total += _size[i];
+        }
+    }
+    return total;
+}
+
+std::size_t FileTable::memoryUsage() const {
+    std::size_t bytes = _parent.capacity() * sizeof(Index)
+                      + _name.capacity() * sizeof(std::uint32_t)
+                      + _type.capacity() * sizeof(std::uint8_t)
+                      + _size.capacity() * sizeof(std::uint64_t)
+                      + _mtime.capacity() * sizeof(std::int64_t)
+                      + _first_child.capacity() * sizeof(Index)
+                      + _child_count.capacity() * sizeof(Index)
+                      + _names->capacity();
+    // Hash containers: buckets plus one node per element
+    bytes += _name_index.bucket_count() * sizeof(void*) + _name_index.size() * (sizeof(void*) + 2 * sizeof(std::size_t));
+    bytes += _link_targets.bucket_count() * sizeof(void*) + _link_targets.size() * (sizeof(void*) + 3 * sizeof(std::size_t));
+    return bytes;
+}
+
+void FileTable::accept(DirectoryIterationVisitor& visitor) const {
+    if (empty()) {
+        return;
+    }
+    Directory root(std::string(name(0)));
+    acceptDirectory(0, root, visitor);
+}
+
+void FileTable::acceptDirectory(Index i, Directory& dir, DirectoryIterationVisitor& visitor) const {
+    visitor.visitDirectory(dir);
+
+    // Visitors that only look at names and sizes would open a descriptor per directory for nothing
+    std::optional<Directory::Pin> pin;
+    if (visitor.readsFiles()) {
+        pin.emplace(dir);
+    }
+    Index end = _first_child[i] + _child_count[i];
+    for (Index child = _first_child[i]; child < end; ++child) {
+        std::string child_name(name(child));
+        switch (type(child)) {
+            case Type::File: {
+                File file(child_name, &dir);
+                file.setSize(static_cast<size_t>(_size[child]));
+                visitor.visitFile(file);
+                break;
+            }
+            case Type::Directory: {
+                Directory subdir(child_name, &dir);
+                acceptDirectory(child, subdir, visitor);
+                break;
+            }
+            case Type::Link: {
+                Link link(child_name, linkTarget(child), &dir);
+                visitor.visitLink(link);
+                break;
+            }
+        }
+    }
+}
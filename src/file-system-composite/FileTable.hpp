@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Directory;
+class DirectoryIterationVisitor;
+
+/**
+ * @class FileTable
+ * @brief Compact alternative to the Directory/File/Link composite for large trees.
+ *
+ * Entries are stored column by column (struct of arrays) and refer to each other
+ * by index: every entry has its parent's index, and the children of a directory
+ * are one contiguous range, sorted by name. Names live once each in a shared
+ * arena, so repeated names (index.js, README.md, ...) are stored a single time.
+ * An entry costs about 33 bytes plus its name, instead of a heap object with a
+ * vtable, a full path and, for directories, a map of children.
+ *
+ * Entry 0 is the root directory; its name is the root path.
+ */
+class FileTable {
+public:
+    using Index = std::uint32_t;
+    static constexpr Index NO_PARENT = static_cast<Index>(-1);
+
+    enum class Type : std::uint8_t { File, Directory, Link };
+
+    /**
+     * @brief Data of one entry, used when adding children.
+     */
+    struct Entry {
+        std::string name;
+        Type type = Type::File;
+        std::uint64_t size = 0;
+        std::int64_t mtime = 0;
+        std::string link_target; ///< Target of links
+    };
+
+    FileTable();
+
+    FileTable(FileTable&&) noexcept = default;
+    FileTable& operator=(FileTable&&) noexcept = default;
+    FileTable(const FileTable&) = delete;
+    FileTable& operator=(const FileTable&) = delete;
+
+    /**
+     * @brief Start the table with its root directory.
+     * @throws std::logic_error if the table already has a root.
+     */
+    Index addRoot(const std::filesystem::path& path, std::int64_t mtime = 0);
+
+    /**
+     * @brief Add all children of a directory at once; they are sorted by name.
+     * @return index of the first child; the others follow it.
+     * @throws std::logic_error if dir is not a directory or already has children.
+     */
+    Index addChildren(Index dir, std::vector<Entry>& children);
+
+    /**
+     * @brief Release memory only needed while adding entries.
+     * Entries can still be added afterwards, at the cost of rebuilding the name index.
+     */
+    void shrink();
+
+    std::size_t size() const noexcept { return _parent.size(); }
+    bool empty() const noexcept { return _parent.empty(); }
+
+    Index parent(Index i) const { return _parent[i]; }
+    std::string_view name(Index i) const { return nameAt(_name[i]); }
+    Type type(Index i) const { return static_cast<Type>(_type[i]); }
+    std::uint64_t fileSize(Index i) const { return _size[i]; }
+    std::int64_t mtime(Index i) const { return _mtime[i]; }
+
+    /// @return first child and number of children of a directory
+    Index firstChild(Index i) const { return _first_child[i]; }
+    Index childCount(Index i) const { return _child_count[i]; }
+
+    /// @return target of a link, empty for other entries
+    std::string linkTarget(Index i) const;
+
+    /// @return full path of an entry, built from its ancestors' names
+    std::filesystem::path path(Index i) const;
+
+    /// @return sum of the sizes of all files
+    std::uint64_t totalSize() const;
+
+    /// @return bytes held by the table
+    std::size_t memoryUsage() const;
+
+    /**
+     * @brief Let a visitor iterate the table as if it were a composite.
+     * Directory, File and Link nodes are created only for the current path and
+     * released right after they are visited; links are not resolved.
+     */
+    void accept(DirectoryIterationVisitor& visitor) const;
+
+private:
+    /// Hashes and compares arena offsets by the names they point to
+    struct NameHash {
+        const std::string* names;
+        std::size_t operator()(std::uint32_t offset) const;
+    };
+    struct NameEqual {
+        const std::string* names;
+        bool operator()(std::uint32_t a, std::uint32_t b) const;
+    };
+
+    std::uint32_t intern(std::string_view name);
+    std::string_view nameAt(std::uint32_t offset) const { return std::string_view(_names->c_str() + offset); }
+    Index append(Index parent, std::uint32_t name, Type type, std::uint64_t size, std::int64_t mtime);
+    void acceptDirectory(Index i, Directory& dir, DirectoryIterationVisitor& visitor) const;
+
+    // Columns, one element per entry
+    std::vector<Index> _parent;
+    std::vector<std::uint32_t> _name;   ///< Offset of the name in _names
+    std::vector<std::uint8_t> _type;
+    std::vector<std::uint64_t> _size;
+    std::vector<std::int64_t> _mtime;
+    std::vector<Index> _first_child;
+    std::vector<Index> _child_count;
+
+    /// Arena of NUL-terminated names; on the heap, so the name index stays valid when the table is moved
+    std::unique_ptr<std::string> _names;
+    std::unordered_set<std::uint32_t, NameHash, NameEqual> _name_index;
+    std::unordered_map<Index, std::uint32_t> _link_targets; ///< Links are rare, so they are kept aside
+};
@@ -12,8 +12,8 @@ std::string Link::getName() const {
 }
 
 size_t Link::getSize() {
-    if (_resolved_target) {
-        return _resolved_target->getSize();
+    if (auto* target = getResolvedTarget()) {
+        return target->getSize();
     }
     return 0; 
 }
@@ -24,13 +24,49 @@ std::filesystem::path Link::getTarget() const {
 
 bool Link::setResolveTarget(std::unique_ptr<FileObject> t) {
     if(!t) return false;
+    TreeTotals delta = t->getTotals();
+    if (_resolved_target) {
+        delta += -_resolved_target->getTotals();
+    }
+    t->setOwner(*this);
+    if (_resolved_target) {
+        // Links sharing the old target must not reach it once it is gone
+        _lifetime = std::make_shared<int>(0);
+    }
     _resolved_target = std::move(t);
+    _shared_target = nullptr;
+    _shared_lifetime.reset();
     _target_name = _resolved_target->getName();
+    propagateTotals(delta);
+    return true;
+}
+
+bool Link::shareResolvedTarget(Link& other) {
+    FileObject* target = other.getResolvedTarget();
+    if (!target || target == getResolvedTarget()) return false;
+    if (_resolved_target) {
+        propagateTotals(-_resolved_target->getTotals());
+        _resolved_target.reset();
+    }
+    _shared_target = target;
+    _shared_lifetime = other._resolved_target ? other.lifetime() : other._shared_lifetime;
+    _target_shared = true;
+    other._target_shared = true;
     return true;
 }
 
+TreeTotals Link::getTotals() const {
+    // A shared target's data is counted once, under the link owning it
+    TreeTotals totals = _resolved_target ? _resolved_target->getTotals() : TreeTotals();
+    totals.links += 1;
+    return totals;
+}
+
 FileObject* Link::getResolvedTarget() const {
-    return _resolved_target.get();
+    if (_resolved_target) {
+        return _resolved_target.get();
+    }
+    return _shared_lifetime.expired() ? nullptr : _shared_target;
 }
 
 void Link::accept(DirectoryIterationVisitor& visitor) {
@@ -1,5 +1,6 @@
 #pragma once
 #include "FileObject.hpp"
+#include <memory>
 
 class Link : public FileObject {
 public:
@@ -14,6 +15,35 @@ public:
     bool setResolveTarget(std::unique_ptr<FileObject> t) override;
     FileObject* getResolvedTarget() const override;
 
+    /**
+     * @brief Resolve to the target already owned by other, without taking ownership.
+     * Both links then report isTargetShared(); the target lives as long as other does,
+     * and once other is destroyed or resolved anew this link is unresolved.
+     * @return false if other has no resolved target
+     */
+    bool shareResolvedTarget(Link& other);
+
+    /**
+     * @return token expiring when this link is destroyed or its resolved target is
+     * replaced, for those keeping a pointer to it (or to its target) without owning it
+     */
+    std::weak_ptr<const void> lifetime() const { return _lifetime; }
+
+    /**
+     * @return true if the resolved target is owned by this link, false if it is unresolved or shared from another link
+     */
+    bool ownsResolvedTarget() const { return _resolved_target != nullptr; }
+
+    /**
+     * @return true if more than one link resolves to the same target object
+     */
+    bool isTargetShared() const { return _target_shared; }
+
+    /**
+     * @return one link, plus the totals of the resolved target if this link owns it
+     */
+    TreeTotals getTotals() const override;
+
     void accept(DirectoryIterationVisitor& visitor);
 private:
     /**
@@ -24,4 +54,11 @@ private:
      * @brief the real target the link resolves to
      */
     std::unique_ptr<FileObject> _resolved_target;
+    /**
+     * @brief target owned by another link, counted in that link's totals only
+     */
+    FileObject* _shared_target = nullptr;
+    std::weak_ptr<const void> _shared_lifetime; ///< Of the link owning _shared_target
+    bool _target_shared = false;
+    std::shared_ptr<const void> _lifetime = std::make_shared<int>(0);
 };
\ No newline at end of file
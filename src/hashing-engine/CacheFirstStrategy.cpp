@@ -0,0 +1,8 @@
+#include "CacheFirstStrategy.hpp"
+
+void CacheFirstStrategy::plan(std::vector<HashJob>& jobs) {
+    // Probing every file here would delay the first hash by a pass over the whole tree
+    for (auto& job : jobs) {
+        job.stage = HashJob::Stage::Probe;
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "SchedulingStrategy.hpp"
+
+/**
+ * @class CacheFirstStrategy
+ * @brief Hashes files that are fully in the page cache first, on the CPU workers,
+ * while cold files wait for the I/O stage.
+ *
+ * On trees that are partly in memory this keeps every worker busy from the start
+ * instead of following name order into the disk. The page cache is not probed
+ * here: jobs are left to the CPU workers, which probe a few at a time as they
+ * run out of cached files, while the I/O worker already reads the rest.
+ */
+class CacheFirstStrategy : public SchedulingStrategy {
+public:
+    void plan(std::vector<HashJob>& jobs) override;
+    std::string getName() const noexcept override { return "cache-first"; }
+};
@@ -0,0 +1,288 @@
+#include "HashEngine.hpp"
+#include "NameOrderStrategy.hpp"
+#include "PageCacheProbe.hpp"
+#include "file-system-composite/File.hpp"
+#include "progress-indicator-observers/Message.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    /// Files up to this size are hashed in batches
+    constexpr std::size_t SMALL_FILE_SIZE = 64 * 1024;
+
+    /// Limits of one batch of small files
+    constexpr std::size_t BATCH_FILES = 64;
+    constexpr std::size_t BATCH_BYTES = 1024 * 1024;
+
+    /// Jobs a CPU worker probes at a time, so cached files ahead are found without a pass over all of them
+    constexpr std::size_t PROBE_BATCH = 32;
+}
+
+HashEngine::HashEngine(CalculatorMaker make_calculator, std::ostream& os, std::size_t workers,
+                       std::unique_ptr<SchedulingStrategy> strategy)
+    : _make_calculator(std::move(make_calculator)),
+      _workers(workers > 0 ? workers : 1),
+      _strategy(strategy ? std::move(strategy) : std::make_unique<NameOrderStrategy>()),
+      _output(os),
+      _writer(_make_calculator ? _make_calculator() : nullptr, os) {}
+
+void HashEngine::hash(FileObject& root) {
+    hash(std::vector<FileObject*>{&root});
+}
+
+void HashEngine::hash(const std::vector<FileObject*>& roots) {
+    FileCollector collector;
+    for (FileObject* root : roots) {
+        root->accept(collector);
+    }
+    hash(collector.getFiles(), collector.getReachedPaths());
+}
+
+void HashEngine::hash(const std::vector<File*>& files) {
+    hash(files, {});
+}
+
+void HashEngine::hash(const std::vector<File*>& files, const FileCollector::ReachedPaths& reached) {
+    std::vector<HashJob> jobs;
+    jobs.reserve(files.size());
+    _sources.resize(files.size());
+    std::unordered_map<FileId, std::size_t, FileIdHash> first_names;
+    // Only shared link targets list a file more than once, and those are always reached by another path
+    std::unordered_map<const File*, std::size_t> first_visits;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        _sources[i] = i;
+        if (!reached.empty()) {
+            auto [first, inserted] = first_visits.emplace(files[i], i);
+            if (!inserted) {
+                _sources[i] = first->second;
+                continue;
+            }
+        }
+        if (auto inode = files[i]->getSharedInode()) {
+            auto [first, inserted] = first_names.emplace(*inode, i);
+            if (!inserted) {
+                _sources[i] = first->second;
+                continue;
+            }
+        }
+        jobs.push_back(HashJob{files[i], i, HashJob::Stage::Io});
+    }
+    _last_uses.assign(files.size(), 0);
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        _last_uses[_sources[i]] = i;
+    }
+    _strategy->plan(jobs);
+    // Only sizes already known are looked at; files are not stat'ed for batching
+    for (auto& job : jobs) {
+        TreeTotals totals = job.file->getTotals();
+        job.small = totals.unsized == 0 && static_cast<std::size_t>(totals.size) <= SMALL_FILE_SIZE;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cpu_queue.clear();
+        _io_queue.clear();
+        _probe_queue.clear();
+        for (const auto& job : jobs) {
+            switch (job.stage) {
+                case HashJob::Stage::Cpu: _cpu_queue.push_back(job); break;
+                case HashJob::Stage::Io: _io_queue.push_back(job); break;
+                case HashJob::Stage::Probe: _probe_queue.push_back(job); break;
+            }
+        }
+        _results.assign(files.size(), Result());
+        _stop = false;
+    }
+
+    // With more than one worker, one of them is the I/O stage: it starts on cold
+    // files right away while the others hash what is already in memory
+    std::vector<std::thread> threads;
+    threads.reserve(_workers);
+    for (std::size_t i = 0; i < _workers; ++i) {
+        bool prefers_io = _workers > 1 && i == 0;
+        threads.emplace_back(&HashEngine::work, this, prefers_io);
+    }
+
+    auto stop_workers = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    };
+
+    try {
+        emit(files, reached);
+    } catch (...) {
+        stop_workers();
+        throw;
+    }
+    stop_workers();
+}
+
+bool HashEngine::takeJobs(bool prefers_io, std::vector<HashJob>& batch) {
+    std::deque<HashJob>* queues[] = {
+        prefers_io ? &_io_queue : &_cpu_queue,
+        &_probe_queue,
+        prefers_io ? &_cpu_queue : &_io_queue,
+    };
+    auto found = std::find_if(std::begin(queues), std::end(queues), [](const std::deque<HashJob>* queue) {
+        return !queue->empty();
+    });
+    if (found == std::end(queues)) {
+        return false;
+    }
+    auto& queue = **found;
+    batch.push_back(queue.front());
+    queue.pop_front();
+    if (!batch.front().small) {
+        return true;
+    }
+
+    // Leave some of the last jobs to the other workers
+    std::size_t limit = std::min(BATCH_FILES, std::max<std::size_t>(1, queue.size() / _workers));
+    auto bytes = static_cast<std::size_t>(batch.front().file->getTotals().size);
+    while (batch.size() < limit && !queue.empty() && queue.front().small) {
+        bytes += static_cast<std::size_t>(queue.front().file->getTotals().size);
+        if (bytes > BATCH_BYTES) {
+            break;
+        }
+        batch.push_back(queue.front());
+        queue.pop_front();
+    }
+    return true;
+}
+
+void HashEngine::dispatchProbed(const std::vector<HashJob>& probed) {
+    for (const auto& job : probed) {
+        (job.stage == HashJob::Stage::Cpu ? _cpu_queue : _io_queue).push_back(job);
+    }
+}
+
+void HashEngine::work(bool prefers_io) {
+    std::unique_ptr<ChecksumCalculator> calculator = _make_calculator();
+    std::vector<char> buffer; // Reused by every file this worker reads
+    std::vector<HashJob> batch;
+    std::vector<Result> results;
+
+    // Jobs of one directory tend to be adjacent; keeping it pinned lets them be opened with openat
+    Directory* pinned = nullptr;
+    auto pinOwner = [&pinned](File& file) {
+        auto* owner = dynamic_cast<Directory*>(file.getOwner());
+        if (owner != pinned) {
+            if (pinned) pinned->unpin();
+            if (owner) owner->pin();
+            pinned = owner;
+        }
+    };
+
+    while (true) {
+        batch.clear();
+        bool probing = false;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stop) {
+                break;
+            }
+            // With nothing cached left to hash, find out which of the next jobs are
+            if (!prefers_io && _cpu_queue.empty() && !_probe_queue.empty()) {
+                std::size_t count = std::min(PROBE_BATCH, _probe_queue.size());
+                batch.assign(_probe_queue.begin(), _probe_queue.begin() + static_cast<std::ptrdiff_t>(count));
+                _probe_queue.erase(_probe_queue.begin(), _probe_queue.begin() + static_cast<std::ptrdiff_t>(count));
+                probing = true;
+            } else if (!takeJobs(prefers_io, batch)) {
+                break;
+            }
+        }
+
+        if (probing) {
+            for (auto& job : batch) {
+                pinOwner(*job.file);
+                job.stage = PageCacheProbe::isCached(*job.file) ? HashJob::Stage::Cpu : HashJob::Stage::Io;
+            }
+            std::lock_guard<std::mutex> lock(_mutex);
+            dispatchProbed(batch);
+            continue;
+        }
+
+        results.assign(batch.size(), Result());
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            File& file = *batch[i].file;
+            pinOwner(file);
+
+            Result& result = results[i];
+            try {
+                calculator->reset();
+                file.read([&calculator](const char* data, std::size_t size) {
+                    calculator->update(data, size);
+                }, buffer);
+                result.checksum = calculator->digest();
+            } catch (...) {
+                result.error = std::current_exception();
+            }
+            result.ready = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                _results[batch[i].index] = std::move(results[i]);
+            }
+        }
+        _result_ready.notify_all();
+    }
+
+    if (pinned) {
+        pinned->unpin();
+    }
+}
+
+void HashEngine::emit(const std::vector<File*>& files, const FileCollector::ReachedPaths& reached) {
+    std::vector<Result> ready;
+    std::string lines;
+    std::size_t i = 0;
+    while (i < files.size()) {
+        // Lines whose results are already in are taken under one lock, a batch at a time,
+        // so a slow early file does not leave the whole rest of the manifest to one write
+        ready.clear();
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _result_ready.wait(lock, [&]() { return _results[_sources[i]].ready; });
+            for (std::size_t j = i; j < files.size() && ready.size() < BATCH_FILES
+                                    && _results[_sources[j]].ready; ++j) {
+                // Copied while later hard links of the same inode still need it
+                Result& result = _results[_sources[j]];
+                ready.push_back(_last_uses[_sources[j]] == j ? std::move(result) : result);
+            }
+        }
+
+        lines.clear();
+        for (const Result& result : ready) {
+            File& file = *files[i];
+            auto path = reached.find(i);
+            const std::filesystem::path& name = path != reached.end() ? path->second : file.getPath();
+            if (observed()) {
+                notify(*this, NewFileMessage(name.string()));
+            }
+            if (result.error) {
+                _output << lines;
+                std::rethrow_exception(result.error);
+            }
+            // A file listed again through a shared link target has its data counted once
+            if (observed() && (_sources[i] == i || files[_sources[i]] != files[i])) {
+                notify(*this, BytesReadMessage(static_cast<std::uint64_t>(file.getSize())));
+            }
+            _writer.appendDigest(lines, name, result.checksum);
+            ++i;
+            if (lines.size() >= BATCH_BYTES) {
+                _output << lines;
+                lines.clear();
+            }
+        }
+        _output << lines;
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "HashJob.hpp"
+#include "SchedulingStrategy.hpp"
+#include "calculators/ChecksumCalculator.hpp"
+#include "directory-iteration-visitors/FileCollector.hpp"
+#include "directory-iteration-visitors/HashStreamWriter.hpp"
+#include "progress-indicator-observers/Observable.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class File;
+class FileObject;
+
+/**
+ * @class HashEngine
+ * @brief Hashes files on a pool of worker threads and writes the same manifest as HashStreamWriter.
+ *
+ * A SchedulingStrategy decides the dispatch order and splits jobs between two stages:
+ * CPU workers prefer jobs whose data is already in memory, the I/O worker prefers jobs
+ * that must be read from the device; either falls back to the other queue when its own
+ * is empty. Jobs the strategy leaves to be probed are checked against the page cache by
+ * CPU workers that have nothing cached left, a batch at a time, while the I/O worker
+ * takes them unprobed. Lines are still written in the original traversal order.
+ *
+ * Files known to share an inode (hard links) are hashed once, by the job of the
+ * first of their names; every name still gets its line. Files reached through
+ * several links sharing one target are hashed once as well.
+ *
+ * Small files are handed to workers in batches of adjacent jobs, hashed through
+ * one reused buffer and published together. Lines whose results are in are
+ * written to the stream in batches of up to 64 lines as well, so their rate is
+ * bound by system calls rather than by per-file locking and formatting.
+ *
+ * Observers are notified from the calling thread as each line is formatted,
+ * shortly before the batch holding it is written.
+ */
+class HashEngine : public Observable {
+public:
+    using CalculatorMaker = std::function<std::unique_ptr<ChecksumCalculator>()>;
+
+    /**
+     * @param make_calculator Creates the calculator of each worker.
+     * @param os Output stream for the manifest.
+     * @param workers Number of worker threads (at least one is used).
+     * @param strategy Scheduling strategy; name order if nullptr.
+     * @throws std::runtime_error if make_calculator does not produce a calculator.
+     */
+    HashEngine(CalculatorMaker make_calculator, std::ostream& os, std::size_t workers,
+               std::unique_ptr<SchedulingStrategy> strategy = nullptr);
+
+    /**
+     * @brief Hash every file reachable from root, following resolved links.
+     * @throws std::ios_base::failure if a file cannot be read; lines before it are written.
+     */
+    void hash(FileObject& root);
+
+    /**
+     * @brief Hash every file reachable from each root on the same pool; the manifest
+     * lists the files of each root together, in the order of the roots.
+     */
+    void hash(const std::vector<FileObject*>& roots);
+
+    /**
+     * @brief Hash the given files; the manifest keeps their order.
+     */
+    void hash(const std::vector<File*>& files);
+
+private:
+    struct Result {
+        bool ready = false;
+        std::string checksum;
+        std::exception_ptr error;
+    };
+
+    /**
+     * @param reached Paths written instead of the files' own, by index
+     */
+    void hash(const std::vector<File*>& files, const FileCollector::ReachedPaths& reached);
+
+    void work(bool prefers_io);
+
+    /**
+     * @brief Take the next job, with the small jobs following it in the same queue
+     * if it is small itself. The preferred queue comes first, then jobs not probed
+     * yet, then the other queue. Called with _mutex held.
+     * @return false if every queue is empty
+     */
+    bool takeJobs(bool prefers_io, std::vector<HashJob>& batch);
+
+    /**
+     * @brief Sort probed jobs into the CPU or I/O queue. Called with _mutex held.
+     */
+    void dispatchProbed(const std::vector<HashJob>& probed);
+    void emit(const std::vector<File*>& files, const FileCollector::ReachedPaths& reached);
+
+    CalculatorMaker _make_calculator;
+    std::size_t _workers;
+    std::unique_ptr<SchedulingStrategy> _strategy;
+    std::ostream& _output;
+    HashStreamWriter _writer; ///< Formats the manifest lines
+
+    std::mutex _mutex;
+    std::condition_variable _result_ready;
+    std::deque<HashJob> _cpu_queue;
+    std::deque<HashJob> _io_queue;
+    std::deque<HashJob> _probe_queue; ///< Jobs whose stage is found out by the workers
+    std::vector<Result> _results;
+    std::vector<std::size_t> _sources; ///< Index of the job that hashes each file's data
+    std::vector<std::size_t> _last_uses; ///< Last index whose line needs each job's result
+    bool _stop = false;
+};
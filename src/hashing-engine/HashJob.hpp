@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+class File;
+
+/**
+ * @brief A single file waiting to be hashed by the HashEngine.
+ */
+struct HashJob {
+    /**
+     * @brief Which stage of the engine should handle the job
+     */
+    enum class Stage {
+        Cpu,  ///< Data is already in memory, hashing is CPU-bound
+        Io,   ///< Data has to come from the device first
+        Probe ///< Not known yet; a CPU worker checks the page cache before the job is dispatched
+    };
+
+    File* file = nullptr;
+    std::size_t index = 0; ///< Position of the file in the manifest
+    Stage stage = Stage::Io;
+    bool small = false; ///< Known to be small enough to be hashed in a batch with others
+};
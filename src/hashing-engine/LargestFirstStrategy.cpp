@@ -0,0 +1,21 @@
+#include "LargestFirstStrategy.hpp"
+#include "file-system-composite/File.hpp"
+#include <algorithm>
+#include <utility>
+
+void LargestFirstStrategy::plan(std::vector<HashJob>& jobs) {
+    // Sized once up front, since sizes not known yet cost a stat each
+    std::vector<std::pair<std::size_t, HashJob>> sized;
+    sized.reserve(jobs.size());
+    for (auto& job : jobs) {
+        job.stage = HashJob::Stage::Io;
+        sized.emplace_back(job.file->getSize(), job);
+    }
+    // Stable, so files of equal size keep their order
+    std::stable_sort(sized.begin(), sized.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        jobs[i] = sized[i].second;
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "SchedulingStrategy.hpp"
+
+/**
+ * @class LargestFirstStrategy
+ * @brief Dispatches the largest files first (longest processing time first).
+ *
+ * All jobs go through one queue, so each worker that becomes idle takes the
+ * largest file left: a huge file found last no longer keeps one worker busy
+ * after the others have finished, and small files fill the gaps at the end.
+ * Sizes come from the tree; files whose size is not known yet are stat'ed.
+ */
+class LargestFirstStrategy : public SchedulingStrategy {
+public:
+    void plan(std::vector<HashJob>& jobs) override;
+    std::string getName() const noexcept override { return "largest-first"; }
+};
@@ -0,0 +1,7 @@
+#include "NameOrderStrategy.hpp"
+
+void NameOrderStrategy::plan(std::vector<HashJob>& jobs) {
+    for (auto& job : jobs) {
+        job.stage = HashJob::Stage::Io;
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "SchedulingStrategy.hpp"
+
+/**
+ * @class NameOrderStrategy
+ * @brief Dispatches files in traversal (name) order, all through the I/O stage.
+ */
+class NameOrderStrategy : public SchedulingStrategy {
+public:
+    void plan(std::vector<HashJob>& jobs) override;
+    std::string getName() const noexcept override { return "name"; }
+};
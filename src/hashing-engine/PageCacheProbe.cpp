@@ -0,0 +1,108 @@
+#include "PageCacheProbe.hpp"
+#include "file-system-composite/File.hpp"
+#include <algorithm>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#if defined(__unix__) || defined(__APPLE__)
+    /// Largest range mapped at once
+    constexpr std::size_t PROBE_WINDOW = 64 * 1024 * 1024;
+
+    /**
+     * @brief Probe the open file fd, window by window, and close it.
+     * @param stop_at_miss Stop at the first page that is not resident
+     * @return fraction of resident pages; 0 if the file cannot be probed
+     */
+    double probe(int fd, bool stop_at_miss) noexcept {
+        if (fd < 0) {
+            return 0.0;
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return 0.0;
+        }
+        if (st.st_size == 0) {
+            ::close(fd);
+            return 1.0;
+        }
+
+        const auto length = static_cast<std::size_t>(st.st_size);
+        const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const std::size_t pages = (length + page - 1) / page;
+        std::size_t count = 0;
+        try {
+#ifdef __APPLE__
+            std::vector<char> resident;
+#else
+            std::vector<unsigned char> resident;
+#endif
+            for (std::size_t offset = 0; offset < length; offset += PROBE_WINDOW) {
+                std::size_t window = std::min(PROBE_WINDOW, length - offset);
+                void* mapping = ::mmap(nullptr, window, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(offset));
+                if (mapping == MAP_FAILED) {
+                    count = 0;
+                    break;
+                }
+                resident.assign((window + page - 1) / page, 0);
+                bool probed = ::mincore(mapping, window, resident.data()) == 0;
+                ::munmap(mapping, window);
+                if (!probed) {
+                    count = 0;
+                    break;
+                }
+                std::size_t in_window = 0;
+                for (auto flag : resident) {
+                    in_window += (flag & 1) ? 1 : 0;
+                }
+                count += in_window;
+                if (stop_at_miss && in_window < resident.size()) {
+                    break;
+                }
+            }
+        } catch (...) {
+            count = 0;
+        }
+        ::close(fd);
+        return static_cast<double>(count) / static_cast<double>(pages);
+    }
+#endif
+}
+
+double PageCacheProbe::residency(const std::filesystem::path& path) noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+    return probe(::open(path.c_str(), O_RDONLY | O_CLOEXEC), false);
+#else
+    (void)path;
+    return 0.0;
+#endif
+}
+
+bool PageCacheProbe::isCached(const std::filesystem::path& path) noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+    return probe(::open(path.c_str(), O_RDONLY | O_CLOEXEC), true) >= 1.0;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+bool PageCacheProbe::isCached(const File& file) noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+    try {
+        return probe(file.openForReading(), true) >= 1.0;
+    } catch (...) {
+        return false;
+    }
+#else
+    (void)file;
+    return false;
+#endif
+}
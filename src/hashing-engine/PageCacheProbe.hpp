@@ -0,0 +1,32 @@
+#pragma once
+#include <filesystem>
+
+class File;
+
+/**
+ * @class PageCacheProbe
+ * @brief Checks how much of a file is already held in the page cache.
+ *
+ * Uses mmap + mincore, which inspects residency without reading any data.
+ * Files are mapped a bounded window at a time, so large files do not need
+ * large mappings. Where that is unavailable every file is reported as not cached.
+ */
+class PageCacheProbe {
+public:
+    /**
+     * @return fraction of the file's pages that are resident, in [0, 1].
+     * Empty files count as fully cached; files that cannot be probed as not cached.
+     */
+    static double residency(const std::filesystem::path& path) noexcept;
+
+    /**
+     * @return true if every page of the file is resident.
+     */
+    static bool isCached(const std::filesystem::path& path) noexcept;
+
+    /**
+     * @brief Same as isCached(path), opening the file relative to its pinned
+     * owner when there is one. Stops at the first page that is not resident.
+     */
+    static bool isCached(const File& file) noexcept;
+};
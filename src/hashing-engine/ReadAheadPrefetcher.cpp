@@ -0,0 +1,133 @@
+#include "ReadAheadPrefetcher.hpp"
+#include "file-system-composite/File.hpp"
+#include "progress-indicator-observers/Message.hpp"
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    /// Only the head of a file is prefetched; sequential readahead takes over once reading starts
+    constexpr std::uint64_t HEAD_BYTES = 4 * 1024 * 1024;
+
+    /// How far ahead, in hashing time, data should already be requested
+    constexpr double LOOKAHEAD_SECONDS = 0.5;
+
+    constexpr std::uint64_t MIN_BUDGET = 8 * 1024 * 1024;
+    constexpr std::uint64_t MAX_BUDGET = 256 * 1024 * 1024;
+
+    /// Weight of the newest sample in the hash rate average
+    constexpr double RATE_SMOOTHING = 0.25;
+}
+
+ReadAheadPrefetcher::ReadAheadPrefetcher(std::vector<File*> files, std::size_t max_window,
+                                         FileCollector::ReachedPaths reached_paths)
+    : _files(std::move(files)), _reached_paths(std::move(reached_paths)), _max_window(max_window) {}
+
+void ReadAheadPrefetcher::start() {
+    _current = 0;
+    _next_fetch = 0;
+    _started = false;
+    _bytes_per_second = 0.0;
+    _in_flight.clear();
+    _in_flight_bytes = 0;
+    fillWindow();
+}
+
+void ReadAheadPrefetcher::update(Observable&, const Message& m) {
+    if (m.type == Message::Type::NewFile) {
+        const auto& msg = static_cast<const NewFileMessage&>(m);
+        recordRate();
+        advanceTo(msg.path);
+        fillWindow();
+    } else if (m.type == Message::Type::BytesRead) {
+        const auto& msg = static_cast<const BytesReadMessage&>(m);
+        _current_bytes = msg.bytesRead;
+    }
+}
+
+std::size_t ReadAheadPrefetcher::window() const {
+    std::size_t first_ahead = _started ? _current + 1 : _current;
+    return _next_fetch > first_ahead ? _next_fetch - first_ahead : 0;
+}
+
+void ReadAheadPrefetcher::advanceTo(const std::string& path) {
+    std::size_t from = _started ? _current : 0;
+    for (std::size_t i = from; i < _files.size(); ++i) {
+        auto reached = _reached_paths.find(i);
+        const std::filesystem::path& name = reached != _reached_paths.end() ? reached->second : _files[i]->getPath();
+        if (name.string() == path) {
+            _current = i;
+            _next_fetch = std::max(_next_fetch, i + 1);
+            break;
+        }
+    }
+    _started = true;
+    _current_bytes = 0;
+    _current_start = std::chrono::steady_clock::now();
+}
+
+void ReadAheadPrefetcher::recordRate() {
+    if (!_started || _current_bytes == 0) {
+        return;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _current_start;
+    if (elapsed.count() <= 0.0) {
+        return;
+    }
+    double sample = static_cast<double>(_current_bytes) / elapsed.count();
+    _bytes_per_second = _bytes_per_second > 0.0
+        ? (1.0 - RATE_SMOOTHING) * _bytes_per_second + RATE_SMOOTHING * sample
+        : sample;
+}
+
+void ReadAheadPrefetcher::fillWindow() {
+    if (_max_window == 0) {
+        return;
+    }
+
+    // Bytes worth requesting ahead: what hashing consumes during the lookahead time
+    std::uint64_t budget = MIN_BUDGET;
+    if (_bytes_per_second > 0.0) {
+        budget = static_cast<std::uint64_t>(_bytes_per_second * LOOKAHEAD_SECONDS);
+        budget = std::clamp(budget, MIN_BUDGET, MAX_BUDGET);
+    }
+
+    // Files reached by hashing no longer count as in flight
+    std::size_t first_ahead = _started ? _current + 1 : _current;
+    while (!_in_flight.empty() && _in_flight.front().first < first_ahead) {
+        _in_flight_bytes -= _in_flight.front().second;
+        _in_flight.pop_front();
+    }
+
+    while (_next_fetch < _files.size()
+           && _next_fetch < first_ahead + _max_window
+           && (_in_flight_bytes < budget || _next_fetch == first_ahead)) {
+        std::uint64_t bytes = prefetchBytes(*_files[_next_fetch]);
+        prefetch(*_files[_next_fetch], bytes);
+        _in_flight.emplace_back(_next_fetch, bytes);
+        _in_flight_bytes += bytes;
+        ++_next_fetch;
+    }
+}
+
+std::uint64_t ReadAheadPrefetcher::prefetchBytes(File& file) {
+    return std::min<std::uint64_t>(file.getSize(), HEAD_BYTES);
+}
+
+void ReadAheadPrefetcher::prefetch(File& file, std::uint64_t bytes) {
+#if (defined(__unix__) || defined(__APPLE__)) && defined(POSIX_FADV_WILLNEED)
+    int fd = ::open(file.getPath().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    // The hint only queues the reads; closing the descriptor does not cancel them
+    ::posix_fadvise(fd, 0, static_cast<off_t>(bytes), POSIX_FADV_WILLNEED);
+    ::close(fd);
+#else
+    (void)file;
+    (void)bytes;
+#endif
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "directory-iteration-visitors/FileCollector.hpp"
+#include "progress-indicator-observers/Observer.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+class File;
+
+/**
+ * @class ReadAheadPrefetcher
+ * @brief Observer that asks the kernel to start reading the next files before they are hashed.
+ *
+ * Knows the files in hashing order. Whenever the observed writer starts a new file,
+ * the head of each of the following files is handed to posix_fadvise(WILLNEED), so the
+ * device keeps working while the current file is hashed.
+ *
+ * The number of files kept in flight adapts to the observed hash rate: enough to cover
+ * a short lookahead time, bounded by a maximum file count and a byte budget.
+ * On platforms without posix_fadvise the prefetch itself is a no-op.
+ */
+class ReadAheadPrefetcher : public Observer {
+public:
+    /**
+     * @param files Files in the order they will be hashed (non-owning).
+     * @param max_window Maximum number of files prefetched ahead of the current one.
+     * @param reached_paths Paths files are announced by instead of their own, by index.
+     */
+    explicit ReadAheadPrefetcher(std::vector<File*> files, std::size_t max_window = 16,
+                                 FileCollector::ReachedPaths reached_paths = {});
+
+    /**
+     * @brief Prefetch the first window, before hashing starts.
+     */
+    void start();
+
+    void update(Observable& sender, const Message& m) override;
+
+    /// @return number of files currently prefetched ahead of the one being hashed
+    std::size_t window() const;
+
+    /// @return current estimate of the hash rate in bytes per second (0 until measured)
+    double hashRate() const { return _bytes_per_second; }
+
+private:
+    void advanceTo(const std::string& path);
+    void recordRate();
+    void fillWindow();
+
+    /**
+     * @return bytes that prefetching the given file asks the kernel to read
+     */
+    static std::uint64_t prefetchBytes(File& file);
+    static void prefetch(File& file, std::uint64_t bytes);
+
+    std::vector<File*> _files;
+    FileCollector::ReachedPaths _reached_paths;
+    std::size_t _max_window;
+
+    std::size_t _current = 0;     ///< Index of the file being hashed
+    std::size_t _next_fetch = 0;  ///< Index of the first file not prefetched yet
+    bool _started = false;
+
+    std::deque<std::pair<std::size_t, std::uint64_t>> _in_flight; ///< Index and prefetched bytes of the files ahead
+    std::uint64_t _in_flight_bytes = 0; ///< Sum of the bytes in _in_flight
+
+    std::uint64_t _current_bytes = 0;
+    std::chrono::steady_clock::time_point _current_start;
+    double _bytes_per_second = 0.0;
+};
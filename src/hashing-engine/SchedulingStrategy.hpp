@@ -0,0 +1,23 @@
+#pragma once
+#include "HashJob.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @interface SchedulingStrategy
+ * @brief Strategy deciding in which order, and by which stage, files are hashed.
+ *
+ * Only the dispatch order is affected; the manifest is always written in the
+ * original order.
+ */
+class SchedulingStrategy {
+public:
+    virtual ~SchedulingStrategy() = default;
+
+    /**
+     * @brief Reorder the jobs into dispatch order and assign each one a stage.
+     */
+    virtual void plan(std::vector<HashJob>& jobs) = 0;
+
+    virtual std::string getName() const noexcept = 0;
+};
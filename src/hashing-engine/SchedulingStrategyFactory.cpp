@@ -0,0 +1,15 @@
+#include "SchedulingStrategyFactory.hpp"
+#include "NameOrderStrategy.hpp"
+#include "CacheFirstStrategy.hpp"
+#include "LargestFirstStrategy.hpp"
+
+std::unique_ptr<SchedulingStrategy> SchedulingStrategyFactory::create(const std::string& type) {
+    if (type == "name") {
+        return std::make_unique<NameOrderStrategy>();
+    } else if (type == "cache-first") {
+        return std::make_unique<CacheFirstStrategy>();
+    } else if (type == "largest-first") {
+        return std::make_unique<LargestFirstStrategy>();
+    }
+    return nullptr;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "SchedulingStrategy.hpp"
+#include <memory>
+#include <string>
+
+class SchedulingStrategyFactory {
+public:
+    /**
+     * @param type - "name", "cache-first" or "largest-first"
+     * @return the strategy, or nullptr for an unknown type
+     */
+    static std::unique_ptr<SchedulingStrategy> create(const std::string& type);
+};
@@ -0,0 +1,281 @@
+#include "StreamingHasher.hpp"
+#include "directory-tree-builders/DirectoryScanner.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include "progress-indicator-observers/Message.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+StreamingHasher::StreamingHasher(CalculatorMaker make_calculator, std::ostream& os,
+                                 std::size_t workers, std::size_t window)
+    : _make_calculator(std::move(make_calculator)),
+      _workers(workers > 0 ? workers : 1),
+      _window(window > 0 ? window : 1),
+      _writer(_make_calculator ? _make_calculator() : nullptr, os) {}
+
+void StreamingHasher::hash(const std::filesystem::path& root) {
+    run([this, &root]() { traverse(root); });
+}
+
+void StreamingHasher::hashList(std::istream& list) {
+    run([this, &list]() { readList(list); });
+}
+
+void StreamingHasher::run(const std::function<void()>& produce) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.clear();
+        _results.clear();
+        _found = _written = 0;
+        _traversal_done = _stop = false;
+        _traversal_error = nullptr;
+    }
+
+    std::thread traversal([this, &produce]() {
+        try {
+            produce();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _traversal_error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _traversal_done = true;
+        }
+        _changed.notify_all();
+    });
+    std::vector<std::thread> threads;
+    threads.reserve(_workers);
+    for (std::size_t i = 0; i < _workers; ++i) {
+        threads.emplace_back(&StreamingHasher::work, this);
+    }
+
+    auto stop_pipeline = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _changed.notify_all();
+        traversal.join();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        _queue.clear();
+        _results.clear();
+    };
+
+    try {
+        emit();
+    } catch (...) {
+        stop_pipeline();
+        throw;
+    }
+    stop_pipeline();
+
+    if (_traversal_error) {
+        std::rethrow_exception(_traversal_error);
+    }
+}
+
+void StreamingHasher::traverse(const std::filesystem::path& root) {
+    std::error_code ec;
+    auto status = std::filesystem::symlink_status(root, ec);
+    if (ec || !std::filesystem::exists(status)) {
+        std::cerr << "Warning: Path does not exist, skipping: " << root << '\n';
+    } else if (std::filesystem::is_directory(status)) {
+        auto level = std::make_shared<Level>();
+        level->dir = std::make_unique<Directory>(root);
+        walk(level);
+    } else if (std::filesystem::is_regular_file(status)) {
+        auto parent_path = root.parent_path();
+        auto level = std::make_shared<Level>();
+        level->dir = std::make_unique<Directory>(parent_path.empty() ? "." : parent_path);
+        enqueue(level, level->dir->createFile(root.filename()));
+    }
+}
+
+void StreamingHasher::readList(std::istream& list) {
+    // The first separator found decides which one the list uses
+    char separator = '\n';
+    std::string entry;
+    for (char c; list.get(c);) {
+        if (c == '\0' || c == '\n') {
+            separator = c;
+            break;
+        }
+        entry.push_back(c);
+    }
+
+    // Consecutive files of one directory share its Directory, up to a window's worth;
+    // a path listed again gets a Directory of its own, since names are unique in one
+    std::shared_ptr<Level> level;
+    do {
+        if (entry.empty()) {
+            continue;
+        }
+
+        std::filesystem::path path(entry);
+        std::error_code ec;
+        auto status = std::filesystem::status(path, ec);
+        if (ec || !std::filesystem::is_regular_file(status)) {
+            std::cerr << "Warning: Not a regular file, skipping: " << path << '\n';
+            continue;
+        }
+
+        auto parent_path = path.parent_path();
+        if (parent_path.empty()) {
+            parent_path = ".";
+        }
+        if (!level || level->dir->getPath() != parent_path || level->dir->getChildCount() >= _window
+            || level->dir->getChild(path.filename())) {
+            level = std::make_shared<Level>();
+            level->dir = std::make_unique<Directory>(parent_path);
+        }
+
+        File* file = level->dir->createFile(path.filename());
+        if (!enqueue(level, file)) {
+            return;
+        }
+    } while (std::getline(list, entry, separator));
+}
+
+void StreamingHasher::walk(const std::shared_ptr<Level>& level) {
+    Directory& dir = *level->dir;
+    // Pinned while walked: children are listed, and files opened by the workers, relative to it
+    Directory::Pin pin(dir);
+
+    std::vector<ScannedEntry> entries;
+    DirectoryHandle listing = DirectoryHandle::open(dir.handle(), dir.handle() >= 0 ? "." : dir.getPath());
+    bool listed = DirectoryScanner::scan(listing, dir.getPath(), [&entries](const ScannedEntry& entry) {
+        if (entry.type != ScannedEntry::Type::Symlink) {
+            entries.push_back(entry);
+        }
+    });
+    if (!listed) {
+        std::cerr << "Error accessing directory: " << dir.getPath()
+                  << ". Reason: " << std::strerror(errno) << '\n';
+        return;
+    }
+    listing.close();
+
+    // The same order as a built Directory iterates its children
+    std::sort(entries.begin(), entries.end(), [](const ScannedEntry& a, const ScannedEntry& b) {
+        return std::filesystem::path(a.name) < std::filesystem::path(b.name);
+    });
+
+    for (const auto& entry : entries) {
+        if (entry.type == ScannedEntry::Type::Directory) {
+            auto child = std::make_shared<Level>();
+            child->parent = level;
+            child->dir = std::make_unique<Directory>(entry.name, &dir);
+            walk(child);
+        } else {
+            File* file = dir.createFile(entry.name);
+            if (entry.size) {
+                file->setSize(static_cast<size_t>(*entry.size));
+            }
+            if (!enqueue(level, file)) {
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stop) {
+            return;
+        }
+    }
+}
+
+bool StreamingHasher::enqueue(const std::shared_ptr<Level>& level, File* file) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock, [this]() { return _stop || _found - _written < _window; });
+        if (_stop) {
+            return false;
+        }
+        _queue.push_back(Job{level, file, _found});
+        _results[_found].level = level;
+        _results[_found].file = file;
+        ++_found;
+    }
+    _changed.notify_all();
+    return true;
+}
+
+void StreamingHasher::work() {
+    std::unique_ptr<ChecksumCalculator> calculator = _make_calculator();
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _changed.wait(lock, [this]() { return _stop || !_queue.empty() || _traversal_done; });
+            if (_stop || _queue.empty()) {
+                return;
+            }
+            job = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        std::string checksum;
+        std::exception_ptr error;
+        try {
+            calculator->reset();
+            job.file->read([&calculator](const char* data, std::size_t size) {
+                calculator->update(data, size);
+            });
+            checksum = calculator->digest();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Result& result = _results[job.index];
+            result.checksum = std::move(checksum);
+            result.error = error;
+            result.ready = true;
+        }
+        _changed.notify_all();
+    }
+}
+
+void StreamingHasher::emit() {
+    while (true) {
+        Result result;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _changed.wait(lock, [this]() {
+                auto it = _results.find(_written);
+                return (it != _results.end() && it->second.ready) || (_traversal_done && _written == _found);
+            });
+            auto it = _results.find(_written);
+            if (it == _results.end()) {
+                return;
+            }
+            result = std::move(it->second);
+            _results.erase(it);
+        }
+
+        File& file = *result.file;
+        notify(*this, NewFileMessage(file.getPath().string()));
+        if (result.error) {
+            std::rethrow_exception(result.error);
+        }
+        notify(*this, BytesReadMessage(static_cast<std::uint64_t>(file.getSize())));
+        _writer.writeDigest(file, result.checksum);
+        // Written files are not needed any more; only the level's listing remembers them
+        result.level->dir->remove(file.getName());
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_written;
+        }
+        _changed.notify_all();
+    }
+}
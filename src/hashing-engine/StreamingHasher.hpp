@@ -0,0 +1,129 @@
+#pragma once
+#include "calculators/ChecksumCalculator.hpp"
+#include "directory-iteration-visitors/HashStreamWriter.hpp"
+#include "progress-indicator-observers/Observable.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+class Directory;
+class File;
+
+/**
+ * @class StreamingHasher
+ * @brief Traverses and hashes in one pipeline, without building the whole composite first.
+ *
+ * A traversal thread walks the tree depth first, in name order, and queues every
+ * file as soon as it is found; worker threads hash the queued files; the calling
+ * thread writes the lines in traversal order, so the manifest is the same as the
+ * one written for a fully built tree.
+ *
+ * At most window files are in flight between the stages. Only the directories on
+ * the traversal path and those with files in flight are kept in memory, and a
+ * file is dropped from its directory once its line is written. Since entries are
+ * walked in name order, the listing of each directory on the traversal path is
+ * held while it is walked: memory grows with tree depth, window and the size of
+ * the directories being walked, not with the total number of files.
+ *
+ * Symbolic links are not followed and get no line, as with NonFollowLinkBuilder.
+ * Observers are notified from the calling thread, as each line is written.
+ *
+ * A list of files can be hashed instead of a tree (hashList): paths are read
+ * from the list as the window allows and queued without any directory walk.
+ */
+class StreamingHasher : public Observable {
+public:
+    using CalculatorMaker = std::function<std::unique_ptr<ChecksumCalculator>()>;
+
+    /**
+     * @param make_calculator Creates the calculator of each worker.
+     * @param os Output stream for the manifest.
+     * @param workers Number of hashing threads (at least one is used).
+     * @param window Maximum number of files found but not yet written (at least one).
+     * @throws std::runtime_error if make_calculator does not produce a calculator.
+     */
+    StreamingHasher(CalculatorMaker make_calculator, std::ostream& os,
+                    std::size_t workers = 1, std::size_t window = 1024);
+
+    /**
+     * @brief Hash every file below root (or root itself, if it is a file).
+     * @throws std::ios_base::failure if a file cannot be read; lines before it are written.
+     */
+    void hash(const std::filesystem::path& root);
+
+    /**
+     * @brief Hash the files listed in list, in list order.
+     *
+     * Paths are separated by NUL or by newline characters, whichever comes first
+     * in the list; empty entries are ignored. Listed paths that are not regular
+     * files (after following links) are skipped with a warning.
+     * @throws std::ios_base::failure if a file cannot be read; lines before it are written.
+     */
+    void hashList(std::istream& list);
+
+private:
+    /**
+     * @brief A directory on the traversal path; kept alive by its subdirectories
+     * and by its files that are still in flight.
+     */
+    struct Level {
+        std::shared_ptr<Level> parent;
+        std::unique_ptr<Directory> dir;
+    };
+
+    struct Job {
+        std::shared_ptr<Level> level;
+        File* file = nullptr;
+        std::size_t index = 0;
+    };
+
+    struct Result {
+        bool ready = false;
+        std::shared_ptr<Level> level;
+        File* file = nullptr;
+        std::string checksum;
+        std::exception_ptr error;
+    };
+
+    /**
+     * @brief Run the pipeline, with produce queueing the files on its own thread.
+     */
+    void run(const std::function<void()>& produce);
+
+    void traverse(const std::filesystem::path& root);
+    void walk(const std::shared_ptr<Level>& level);
+    void readList(std::istream& list);
+
+    /**
+     * @brief Queue a file, waiting while the window is full.
+     * @return false if the pipeline is stopping.
+     */
+    bool enqueue(const std::shared_ptr<Level>& level, File* file);
+
+    void work();
+    void emit();
+
+    CalculatorMaker _make_calculator;
+    std::size_t _workers;
+    std::size_t _window;
+    HashStreamWriter _writer; ///< Formats the manifest lines
+
+    std::mutex _mutex;
+    std::condition_variable _changed;
+    std::deque<Job> _queue;
+    std::map<std::size_t, Result> _results; ///< In flight, by manifest position
+    std::size_t _found = 0;
+    std::size_t _written = 0;
+    bool _traversal_done = false;
+    bool _stop = false;
+    std::exception_ptr _traversal_error;
+};
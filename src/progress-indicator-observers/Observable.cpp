@@ -3,6 +3,9 @@
 #include "Message.hpp"
 
 void Observable::notify(Observable& sender, const Message& m) {
+    if (_observers.empty()) {
+        return;
+    }
     auto copy = _observers;
     for (auto* obs : copy) {
         if (obs) obs->update(sender, m);
@@ -20,6 +20,11 @@ public:
 protected:
     void notify(Observable& sender, const Message& m);
 
+    /**
+     * @return true if any observer is attached, so messages nobody receives need not be built
+     */
+    bool observed() const noexcept { return !_observers.empty(); }
+
 private:
     std::vector<Observer*> _observers;
 };
\ No newline at end of file
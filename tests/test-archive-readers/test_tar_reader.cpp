@@ -0,0 +1,201 @@
+#include "archive-readers/TarReader.hpp"
+#include "archive-readers/TarConstructor.hpp"
+#include "directory-tree-builders/NonFollowLinkBuilder.hpp"
+#include "directory-iteration-visitors/HashStreamWriter.hpp"
+#include "calculators/ChecksumCalculator.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include "file-system-composite/Link.hpp"
+#include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    class MockCalculator : public ChecksumCalculator {
+    public:
+        std::string calculate(const std::string& data) noexcept override {
+            return "mock_hash_" + data;
+        }
+
+        std::string getAlgorithmName() const noexcept override { return "mock"; }
+    };
+
+    /**
+     * @brief Builds ustar archives in memory, so tests do not depend on a tar binary
+     */
+    class TarArchiveMockup {
+    public:
+        void add(const std::string& name, char type, const std::string& data = "", const std::string& link = "") {
+            char header[512] = {};
+            std::memcpy(header, name.data(), std::min<std::size_t>(name.size(), 100));
+            std::snprintf(header + 100, 8, "%07o", 0644);
+            std::snprintf(header + 108, 8, "%07o", 0);
+            std::snprintf(header + 116, 8, "%07o", 0);
+            std::snprintf(header + 124, 12, "%011o", static_cast<unsigned>(data.size()));
+            std::snprintf(header + 136, 12, "%011o", 1700000000u);
+            header[156] = type;
+            std::memcpy(header + 157, link.data(), std::min<std::size_t>(link.size(), 100));
+            std::memcpy(header + 257, "ustar", 6);
+            std::memcpy(header + 263, "00", 2);
+
+            std::memset(header + 148, ' ', 8);
+            unsigned sum = 0;
+            for (unsigned char c : header) sum += c;
+            std::snprintf(header + 148, 8, "%06o", sum);
+
+            _bytes.append(header, sizeof(header));
+            _bytes.append(data);
+            _bytes.append((512 - data.size() % 512) % 512, '\0');
+        }
+
+        void addPax(const std::string& key, const std::string& value) {
+            std::string body = " " + key + "=" + value + "\n";
+            std::size_t length = body.size() + 1;
+            while (std::to_string(length).size() + body.size() != length) ++length;
+            add("PaxHeader", 'x', std::to_string(length) + body);
+        }
+
+        std::filesystem::path write(const std::string& file_name) {
+            auto path = std::filesystem::temp_directory_path() / file_name;
+            std::ofstream out(path, std::ios::binary);
+            out << _bytes << std::string(1024, '\0');
+            return path;
+        }
+
+    private:
+        std::string _bytes;
+    };
+}
+
+TEST_CASE("TarReader - Reading members", "[TarReader]") {
+    TarArchiveMockup archive;
+    archive.add("data/", '5');
+    archive.add("data/hello.txt", '0', "Hello World");
+    archive.add("data/link", '2', "", "hello.txt");
+    auto path = archive.write("tar_reader_members.tar");
+
+    TarReader reader(path);
+    TarEntry entry;
+
+    SECTION("Headers are read in archive order") {
+        REQUIRE(reader.next(entry));
+        REQUIRE(entry.path == "data/");
+        REQUIRE(entry.type == TarEntry::Type::Directory);
+
+        REQUIRE(reader.next(entry));
+        REQUIRE(entry.path == "data/hello.txt");
+        REQUIRE(entry.type == TarEntry::Type::File);
+        REQUIRE(entry.size == 11);
+        REQUIRE(entry.mtime == 1700000000);
+
+        REQUIRE(reader.next(entry));
+        REQUIRE(entry.type == TarEntry::Type::Symlink);
+        REQUIRE(entry.link_target == "hello.txt");
+
+        REQUIRE_FALSE(reader.next(entry));
+    }
+
+    SECTION("Member data is available through contents()") {
+        reader.next(entry);
+        reader.next(entry);
+        std::stringstream content;
+        content << reader.contents().rdbuf();
+        REQUIRE(content.str() == "Hello World");
+    }
+
+    SECTION("Unread data is skipped") {
+        reader.next(entry);
+        reader.next(entry);
+        char first[5] = {};
+        REQUIRE(reader.read(first, sizeof(first)) == 5);
+        REQUIRE(reader.next(entry));
+        REQUIRE(entry.path == "data/link");
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("TarReader - Extended headers", "[TarReader]") {
+    std::string long_name = std::string(150, 'a') + "/file.txt";
+
+    TarArchiveMockup archive;
+    archive.addPax("path", long_name);
+    archive.add("truncated", '0', "content");
+    auto path = archive.write("tar_reader_pax.tar");
+
+    TarReader reader(path);
+    TarEntry entry;
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.path == long_name);
+    REQUIRE(entry.size == 7);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("TarReader - Invalid input", "[TarReader]") {
+    SECTION("Missing archive throws") {
+        REQUIRE_THROWS_AS(TarReader(std::filesystem::temp_directory_path() / "tar_reader_missing.tar"),
+                          std::runtime_error);
+    }
+
+    SECTION("Corrupt header throws") {
+        auto path = std::filesystem::temp_directory_path() / "tar_reader_corrupt.tar";
+        std::ofstream(path, std::ios::binary) << std::string(512, 'x');
+
+        TarReader reader(path);
+        TarEntry entry;
+        REQUIRE_THROWS_AS(reader.next(entry), std::runtime_error);
+        std::filesystem::remove(path);
+    }
+}
+
+TEST_CASE("TarConstructor - Building and hashing", "[TarConstructor]") {
+    TarArchiveMockup archive;
+    archive.add("./project/", '5');
+    archive.add("./project/a.txt", '0', "aaa");
+    archive.add("./project/sub/b.txt", '0', "bb");
+    archive.add("./project/c.txt", '1', "", "./project/a.txt");
+    archive.add("./project/link", '2', "", "a.txt");
+    archive.add("../escape.txt", '0', "evil");
+    auto path = archive.write("tar_constructor.tar");
+
+    SECTION("Composite mirrors the archive") {
+        NonFollowLinkBuilder builder;
+        TarConstructor constructor(builder);
+        constructor.construct(path);
+
+        Directory* root = builder.getTree();
+        REQUIRE(root != nullptr);
+        REQUIRE(root->getName() == ".");
+
+        auto project = root->getChild("project");
+        REQUIRE(project != nullptr);
+        REQUIRE(project->getChild("a.txt") != nullptr);
+        REQUIRE(project->getChild("a.txt")->getSize() == 3);
+        REQUIRE(project->getChild("sub") != nullptr);
+        REQUIRE(project->getChild("sub")->getChild("b.txt") != nullptr);
+        REQUIRE(project->getChild("link") != nullptr);
+        REQUIRE(project->getChild("link")->getTarget() == "a.txt");
+        REQUIRE(root->getChild("escape.txt") == nullptr);
+    }
+
+    SECTION("Members are hashed in one pass, in the extracted tree's format") {
+        std::ostringstream output;
+        HashStreamWriter writer(std::make_unique<MockCalculator>(), output);
+        NonFollowLinkBuilder builder;
+        TarConstructor constructor(builder, &writer);
+        constructor.construct(path);
+
+        std::string expected =
+            "mock mock_hash_aaa ./project/a.txt\n"
+            "mock mock_hash_bb ./project/sub/b.txt\n"
+            "mock mock_hash_aaa ./project/c.txt\n";
+        REQUIRE(output.str() == expected);
+    }
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include "file-system-composite/Link.hpp"
+#include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
+#include <iostream>
+#include <set>
+#include <string>
+
+/**
+ * @brief Records every object of a tree, following resolved links, so trees
+ * built in different ways can be compared.
+ */
+class TreeRecorder : public DirectoryIterationVisitor {
+public:
+    TreeRecorder() : DirectoryIterationVisitor(std::cerr) {}
+
+    void visitFile(File& file) override {
+        entries.insert("F " + file.getPath().string() + " " + std::to_string(file.getSize()));
+    }
+    void visitDirectory(Directory& dir) override { entries.insert("D " + dir.getPath().string()); }
+    void visitLink(Link& link) override {
+        entries.insert("L " + link.getPath().string() + " -> " + link.getTarget().string());
+        if (link.getResolvedTarget()) {
+            link.getResolvedTarget()->accept(*this);
+        }
+    }
+
+    std::set<std::string> entries;
+};
+
+/**
+ * @return The entries of the tree, empty if there is none.
+ */
+inline std::set<std::string> recordTree(Directory* tree) {
+    TreeRecorder recorder;
+    if (tree) {
+        tree->accept(recorder);
+    }
+    return recorder.entries;
+}
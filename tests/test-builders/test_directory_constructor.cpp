@@ -5,10 +5,25 @@
 #include "file-system-composite/Directory.hpp"
 #include "file-system-composite/File.hpp"
 #include "file-system-composite/Link.hpp"
+#include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
+#include "TreeRecorder.hpp"
 #include <catch2/catch_all.hpp>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <climits>
+#endif
 
 namespace {
     class DirectoryConstructorTestMockup {
@@ -305,6 +320,27 @@ TEST_CASE("DirectoryConstructor - Multiple root paths with NonFollowLinkBuilder"
     }
 }
 
+TEST_CASE("DirectoryConstructor - Root paths known at runtime", "[DirectoryConstructor]") {
+    std::vector<std::filesystem::path> roots{test_mockup.sub_dir1, test_mockup.sub_dir2};
+
+    // One builder per root gives one tree per root
+    std::vector<std::unique_ptr<NonFollowLinkBuilder>> builders;
+    for (const auto& root : roots) {
+        builders.push_back(std::make_unique<NonFollowLinkBuilder>());
+        DirectoryConstructor(*builders.back()).construct({root});
+    }
+
+    REQUIRE(builders[0]->getTree()->getName() == "subdir1");
+    REQUIRE(builders[0]->getTree()->getChild("file2.txt") != nullptr);
+    REQUIRE(builders[1]->getTree()->getName() == "subdir2");
+
+    SECTION("The whole list at once goes into one builder") {
+        NonFollowLinkBuilder builder;
+        DirectoryConstructor(builder).construct(roots);
+        REQUIRE(builder.getTree()->getName() == "subdir1");
+    }
+}
+
 TEST_CASE("DirectoryConstructor - Multiple root paths with LinkFollowBuilder", "[DirectoryConstructor]") {
     SECTION("Construct multiple directories and files") {
         auto detector = std::make_unique<CycleDetector>();
@@ -596,4 +632,236 @@ TEST_CASE("DirectoryConstructor - Builder state consistency", "[DirectoryConstru
         REQUIRE(tree2->getName() == "empty");
         REQUIRE(tree2->getChild("standalone.txt") == nullptr);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("DirectoryConstructor - Parallel traversal", "[DirectoryConstructor]") {
+    auto wide_root = test_mockup.base_path / "wide";
+    for (int i = 0; i < 20; ++i) {
+        auto dir = wide_root / ("dir" + std::to_string(i)) / "inner";
+        std::filesystem::create_directories(dir);
+        for (int j = 0; j < 5; ++j) {
+            std::ofstream(dir / ("file" + std::to_string(j) + ".txt")) << std::string(i * j, 'x');
+        }
+    }
+
+    SECTION("Same tree as the serial traversal") {
+        NonFollowLinkBuilder serial_builder;
+        DirectoryConstructor(serial_builder).construct({wide_root});
+
+        NonFollowLinkBuilder parallel_builder;
+        DirectoryConstructor(parallel_builder, 4).construct({wide_root});
+
+        auto serial = recordTree(serial_builder.getTree());
+        REQUIRE(serial.size() == 1 + 20 * 2 + 20 * 5);
+        REQUIRE(recordTree(parallel_builder.getTree()) == serial);
+    }
+
+    SECTION("Symlinks are built through the builder") {
+        NonFollowLinkBuilder serial_builder;
+        DirectoryConstructor(serial_builder).construct({test_mockup.root_dir});
+
+        NonFollowLinkBuilder parallel_builder;
+        DirectoryConstructor(parallel_builder, 3).construct({test_mockup.root_dir});
+
+        REQUIRE(recordTree(parallel_builder.getTree()) == recordTree(serial_builder.getTree()));
+    }
+
+    SECTION("Followed links with LinkFollowBuilder") {
+        LinkFollowBuilder serial_builder(std::make_unique<CycleDetector>());
+        DirectoryConstructor(serial_builder).construct({test_mockup.root_dir});
+
+        LinkFollowBuilder parallel_builder(std::make_unique<CycleDetector>());
+        DirectoryConstructor(parallel_builder, 3).construct({test_mockup.root_dir});
+
+        REQUIRE(recordTree(parallel_builder.getTree()) == recordTree(serial_builder.getTree()));
+    }
+
+    std::filesystem::remove_all(wide_root);
+}
+
+TEST_CASE("DirectoryConstructor - Filtering", "[DirectoryConstructor]") {
+    auto filtered_root = test_mockup.base_path / "filtered";
+    std::filesystem::create_directories(filtered_root / "node_modules" / "pkg");
+    std::filesystem::create_directories(filtered_root / "src" / "build");
+    std::ofstream(filtered_root / "node_modules" / "pkg" / "index.js") << "js";
+    std::ofstream(filtered_root / "src" / "main.cpp") << "int main() {}";
+    std::ofstream(filtered_root / "src" / "scratch.tmp") << "tmp";
+    std::ofstream(filtered_root / "src" / "build" / "main.o") << "object";
+    std::ofstream(filtered_root / "big.bin") << std::string(4096, 'x');
+
+    EntryFilter filter;
+    filter.exclude("node_modules");
+    filter.exclude("*.tmp");
+    filter.exclude("src/build");
+    filter.maxSize(1024);
+
+    auto expected = std::set<std::string>{
+        "D " + filtered_root.string(),
+        "D " + (filtered_root / "src").string(),
+        "F " + (filtered_root / "src" / "main.cpp").string() + " 13",
+    };
+
+    SECTION("Serial traversal") {
+        NonFollowLinkBuilder builder;
+        DirectoryConstructor constructor(builder);
+        constructor.setFilter(filter);
+        constructor.construct({filtered_root});
+        REQUIRE(recordTree(builder.getTree()) == expected);
+    }
+
+    SECTION("Parallel traversal") {
+        NonFollowLinkBuilder builder;
+        DirectoryConstructor constructor(builder, 3);
+        constructor.setFilter(filter);
+        constructor.construct({filtered_root});
+        REQUIRE(recordTree(builder.getTree()) == expected);
+    }
+
+    SECTION("Excluded directories are not opened") {
+        std::filesystem::permissions(filtered_root / "node_modules", std::filesystem::perms::none);
+        std::ostringstream errors;
+        auto* previous = std::cerr.rdbuf(errors.rdbuf());
+
+        NonFollowLinkBuilder builder;
+        DirectoryConstructor constructor(builder);
+        constructor.setFilter(filter);
+        constructor.construct({filtered_root});
+
+        std::cerr.rdbuf(previous);
+        std::filesystem::permissions(filtered_root / "node_modules", std::filesystem::perms::owner_all);
+        REQUIRE(errors.str().empty());
+    }
+
+    SECTION("Followed links to files are filtered as the files") {
+        std::filesystem::create_symlink(filtered_root / "big.bin", filtered_root / "big_link");
+        std::filesystem::create_symlink(filtered_root / "src" / "main.cpp", filtered_root / "small_link");
+        expected.insert("F " + (filtered_root / "small_link").string() + " 13");
+
+        std::size_t threads = GENERATE(1, 3);
+        LinkFollowBuilder builder(std::make_unique<CycleDetector>());
+        DirectoryConstructor constructor(builder, threads);
+        constructor.setFilter(filter);
+        constructor.construct({filtered_root});
+
+        // Only the kept link is listed
+        auto entries = recordTree(builder.getTree());
+        auto link = std::find_if(entries.begin(), entries.end(), [](const std::string& entry) {
+            return entry.rfind("L ", 0) == 0;
+        });
+        REQUIRE(link != entries.end());
+        entries.erase(link);
+        REQUIRE(entries == expected);
+        REQUIRE(builder.getTree()->getChild("big_link") == nullptr);
+        REQUIRE(builder.getTree()->getChild("small_link") != nullptr);
+    }
+
+    SECTION("Roots are never filtered") {
+        EntryFilter everything;
+        everything.exclude("*");
+
+        NonFollowLinkBuilder builder;
+        DirectoryConstructor constructor(builder);
+        constructor.setFilter(everything);
+        constructor.construct({filtered_root / "src" / "main.cpp"});
+        REQUIRE(builder.getTree()->getChild("main.cpp") != nullptr);
+    }
+
+    std::filesystem::remove_all(filtered_root);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+namespace {
+    /**
+     * @brief Trees too deep to be reached by path; made and removed one name at a time
+     */
+    int makeDirectoryAt(int parent, const std::string& name) {
+        ::mkdirat(parent, name.c_str(), 0755);
+        int dir = ::openat(parent, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        ::close(parent);
+        return dir;
+    }
+
+    void writeFileAt(int dir, const std::string& name, const std::string& content) {
+        int fd = ::openat(dir, name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        REQUIRE(::write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+        ::close(fd);
+    }
+
+    void removeTreeAt(int parent, const std::string& name) {
+        int fd = ::openat(parent, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (DIR* dir = fd >= 0 ? ::fdopendir(fd) : nullptr) {
+            std::vector<std::pair<std::string, bool>> entries;
+            while (dirent* entry = ::readdir(dir)) {
+                std::string child = entry->d_name;
+                if (child != "." && child != "..") {
+                    struct stat st {};
+                    ::fstatat(fd, child.c_str(), &st, AT_SYMLINK_NOFOLLOW);
+                    entries.emplace_back(child, S_ISDIR(st.st_mode));
+                }
+            }
+            for (const auto& [child, is_dir] : entries) {
+                is_dir ? removeTreeAt(fd, child) : static_cast<void>(::unlinkat(fd, child.c_str(), 0));
+            }
+            ::closedir(dir);
+        }
+        ::unlinkat(parent, name.c_str(), AT_REMOVEDIR);
+    }
+
+    struct DeepTree {
+        const std::filesystem::path root = test_mockup.base_path / "deep";
+        static constexpr int depth = 2500;
+
+        DeepTree() {
+            std::filesystem::create_directories(root);
+            int dir = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            for (int i = 0; i < depth; ++i) {
+                dir = makeDirectoryAt(dir, "d");
+            }
+            // Siblings below the bottom; whichever deep branch is filled first,
+            // the others are reached after their parent's handle was closed
+            int middle = makeDirectoryAt(::dup(dir), "m");
+            writeFileAt(middle, "late.txt", "late");
+            ::close(middle);
+            for (const char* branch : {"a", "z"}) {
+                int below = makeDirectoryAt(::dup(dir), branch);
+                for (int i = 0; i < 99; ++i) {
+                    below = makeDirectoryAt(below, "d");
+                }
+                writeFileAt(below, "bottom.txt", "bottom");
+                ::close(below);
+            }
+            ::close(dir);
+        }
+
+        ~DeepTree() {
+            removeTreeAt(AT_FDCWD, root.string());
+        }
+
+        DeepTree(const DeepTree&) = delete;
+        DeepTree& operator=(const DeepTree&) = delete;
+    };
+}
+
+TEST_CASE("DirectoryConstructor - Trees deeper than PATH_MAX", "[DirectoryConstructor]") {
+    DeepTree tree;
+    auto bottom = tree.root;
+    for (int i = 0; i < DeepTree::depth; ++i) {
+        bottom /= "d";
+    }
+    REQUIRE(bottom.string().size() > PATH_MAX);
+
+    bool collect_sizes = GENERATE(false, true);
+    std::size_t threads = GENERATE(1, 3);
+    NonFollowLinkBuilder builder;
+    DirectoryConstructor constructor(builder, threads);
+    constructor.collectSizes(collect_sizes);
+    constructor.construct({tree.root});
+
+    // Files are stat'ed during the visit, relative to pinned directories
+    auto entries = recordTree(builder.getTree());
+    REQUIRE(entries.size() == 1 + DeepTree::depth + 1 + 2 * 100 + 3);
+    REQUIRE(entries.count("F " + (bottom / "m" / "late.txt").string() + " 4") == 1);
+    REQUIRE(builder.getTree()->getTotals().files == 3);
+    REQUIRE(builder.getTree()->getSize() == 4 + 2 * 6);
+}
+#endif
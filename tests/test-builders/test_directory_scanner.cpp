@@ -0,0 +1,92 @@
+#include "directory-tree-builders/DirectoryScanner.hpp"
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+
+TEST_CASE("DirectoryScanner - Classifying entries", "[DirectoryScanner]") {
+    auto base = std::filesystem::temp_directory_path() / "directory_scanner_test";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base / "sub");
+    std::ofstream(base / "file.txt") << "12345";
+    std::filesystem::create_symlink("file.txt", base / "link");
+
+    std::map<std::string, ScannedEntry> entries;
+    auto handle = DirectoryHandle::open(-1, base);
+    bool listed = DirectoryScanner::scan(handle, base, [&entries](const ScannedEntry& entry) {
+        entries[entry.name] = entry;
+    });
+
+    REQUIRE(listed);
+    REQUIRE(entries.size() == 3);
+    REQUIRE(entries["file.txt"].type == ScannedEntry::Type::File);
+    REQUIRE(entries["sub"].type == ScannedEntry::Type::Directory);
+    REQUIRE(entries["link"].type == ScannedEntry::Type::Symlink);
+    REQUIRE(entries["link"].link_target == "file.txt");
+
+    // Only reported when the scan had to stat the entry anyway
+    if (entries["file.txt"].size) {
+        REQUIRE(*entries["file.txt"].size == 5);
+    }
+
+    // Inode numbers come with the listing, so entries can be ordered without a stat
+    struct stat st {};
+    REQUIRE(::lstat((base / "sub").c_str(), &st) == 0);
+    REQUIRE(entries["sub"].ino == static_cast<std::uint64_t>(st.st_ino));
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("DirectoryScanner - Large directories", "[DirectoryScanner]") {
+    auto base = std::filesystem::temp_directory_path() / "directory_scanner_large";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base);
+
+    // Names long enough that the listing needs several batches
+    const int count = 3000;
+    for (int i = 0; i < count; ++i) {
+        std::ofstream(base / (std::string(80, 'n') + std::to_string(i)));
+    }
+
+    int seen = 0;
+    auto handle = DirectoryHandle::open(-1, base);
+    REQUIRE(DirectoryScanner::scan(handle, base, [&seen](const ScannedEntry& entry) {
+        if (entry.type == ScannedEntry::Type::File) ++seen;
+    }));
+    REQUIRE(seen == count);
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("DirectoryScanner - Listing by path", "[DirectoryScanner]") {
+    auto base = std::filesystem::temp_directory_path() / "directory_scanner_path";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base / "sub");
+    std::ofstream(base / "file.txt") << "12345";
+    std::filesystem::create_symlink("file.txt", base / "link");
+
+    std::map<std::string, ScannedEntry> entries;
+    REQUIRE(DirectoryScanner::scanPath(base, [&entries](const ScannedEntry& entry) {
+        entries[entry.name] = entry;
+    }));
+    REQUIRE(entries.size() == 3);
+    REQUIRE(entries["file.txt"].type == ScannedEntry::Type::File);
+    REQUIRE(entries["sub"].type == ScannedEntry::Type::Directory);
+    REQUIRE(entries["link"].type == ScannedEntry::Type::Symlink);
+    REQUIRE(entries["link"].link_target == "file.txt");
+
+    REQUIRE_FALSE(DirectoryScanner::scanPath(base / "missing", [](const ScannedEntry&) {}));
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("DirectoryScanner - Invalid handle", "[DirectoryScanner]") {
+    DirectoryHandle closed;
+    REQUIRE_FALSE(DirectoryScanner::scan(closed, "missing", [](const ScannedEntry&) {}));
+}
+
+#endif
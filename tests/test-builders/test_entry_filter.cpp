@@ -0,0 +1,158 @@
+#include "directory-tree-builders/EntryFilter.hpp"
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <regex>
+#include <string>
+
+TEST_CASE("EntryFilter - Name globs", "[EntryFilter]") {
+    EntryFilter filter;
+    REQUIRE(filter.empty());
+
+    filter.exclude(".git");
+    filter.exclude("*.tmp");
+    filter.exclude("cache*");
+    filter.exclude("log[0-9].txt");
+    filter.exclude("?.o");
+    REQUIRE_FALSE(filter.empty());
+    REQUIRE_FALSE(filter.needsPath());
+
+    SECTION("Literal names") {
+        REQUIRE(filter.excludes(".git", {}));
+        REQUIRE_FALSE(filter.excludes(".github", {}));
+    }
+
+    SECTION("Suffixes and prefixes") {
+        REQUIRE(filter.excludesFile("scratch.tmp", {}, nullptr));
+        REQUIRE_FALSE(filter.excludesFile("scratch.tmp.keep", {}, nullptr));
+        REQUIRE(filter.excludes("cache", {}));
+        REQUIRE(filter.excludes("cache-v2", {}));
+        REQUIRE_FALSE(filter.excludes("my-cache", {}));
+    }
+
+    SECTION("Wildcards") {
+        REQUIRE(filter.excludesFile("log3.txt", {}, nullptr));
+        REQUIRE_FALSE(filter.excludesFile("logx.txt", {}, nullptr));
+        REQUIRE(filter.excludesFile("a.o", {}, nullptr));
+        REQUIRE_FALSE(filter.excludesFile("ab.o", {}, nullptr));
+    }
+}
+
+TEST_CASE("EntryFilter - Path globs and regular expressions", "[EntryFilter]") {
+    EntryFilter filter;
+    filter.exclude("/src/build/");
+    filter.exclude("docs/*.pdf");
+    filter.exclude("**/generated/**");
+    REQUIRE(filter.needsPath());
+
+    SECTION("Globs with '/' match paths relative to the root") {
+        REQUIRE(filter.excludes("build", "src/build"));
+        REQUIRE_FALSE(filter.excludes("build", "lib/src/build"));
+    }
+
+    SECTION("A single '*' stays within one component") {
+        REQUIRE(filter.excludesFile("manual.pdf", "docs/manual.pdf", nullptr));
+        REQUIRE_FALSE(filter.excludesFile("manual.pdf", "docs/old/manual.pdf", nullptr));
+    }
+
+    SECTION("'**' crosses components") {
+        REQUIRE(filter.excludesFile("a.cpp", "lib/deep/generated/a.cpp", nullptr));
+        REQUIRE_FALSE(filter.excludesFile("a.cpp", "lib/deep/a.cpp", nullptr));
+    }
+
+    SECTION("Regular expressions") {
+        filter.excludeRegex(R"(\.(bak|swp)$)");
+        REQUIRE(filter.excludesFile("notes.swp", "notes.swp", nullptr));
+        REQUIRE_FALSE(filter.excludesFile("notes.txt", "notes.txt", nullptr));
+        REQUIRE_THROWS_AS(filter.excludeRegex("(unclosed"), std::regex_error);
+    }
+}
+
+TEST_CASE("EntryFilter - Inclusions", "[EntryFilter]") {
+    EntryFilter filter;
+    filter.include("*.cpp");
+    filter.include("include/*.hpp");
+
+    REQUIRE_FALSE(filter.excludesFile("main.cpp", "src/main.cpp", nullptr));
+    REQUIRE_FALSE(filter.excludesFile("a.hpp", "include/a.hpp", nullptr));
+    REQUIRE(filter.excludesFile("a.hpp", "src/a.hpp", nullptr));
+
+    // Directories may hold included files, whatever their names
+    REQUIRE_FALSE(filter.excludes("src", "src"));
+}
+
+TEST_CASE("EntryFilter - Size and time limits", "[EntryFilter]") {
+    EntryFilter filter;
+    filter.maxSize(100);
+    filter.modifiedSince(1000);
+    REQUIRE(filter.needsAttributes());
+
+    EntryFilter::Attributes attributes;
+    attributes.size = 100;
+    attributes.mtime = 1000;
+    REQUIRE_FALSE(filter.excludesFile("f", {}, &attributes));
+
+    attributes.size = 101;
+    REQUIRE(filter.excludesFile("f", {}, &attributes));
+
+    attributes.size = 1;
+    attributes.mtime = 999;
+    REQUIRE(filter.excludesFile("f", {}, &attributes));
+
+    SECTION("Files are stat'ed only when needed") {
+        auto path = std::filesystem::temp_directory_path() / "entry_filter_test.txt";
+        std::ofstream(path) << std::string(200, 'x');
+
+        std::optional<EntryFilter::Attributes> read;
+        REQUIRE(filter.excludesFileAt(-1, path, path.filename().string(), {}, read));
+        REQUIRE(read);
+        REQUIRE(read->size == 200);
+
+        EntryFilter names_only;
+        names_only.exclude("*.tmp");
+        REQUIRE_FALSE(names_only.excludesFileAt(-1, path, path.filename().string(), {}, read));
+        REQUIRE_FALSE(read);
+
+        // Names are checked before the stat
+        filter.exclude("entry_filter_*");
+        REQUIRE(filter.excludesFileAt(-1, path, path.filename().string(), {}, read));
+        REQUIRE_FALSE(read);
+
+        std::filesystem::remove(path);
+    }
+
+    SECTION("Links to files are checked with their target's attributes") {
+        auto target = std::filesystem::temp_directory_path() / "entry_filter_target.txt";
+        auto link = std::filesystem::temp_directory_path() / "entry_filter_link";
+        auto dir_link = std::filesystem::temp_directory_path() / "entry_filter_dir_link";
+        std::filesystem::remove(link);
+        std::filesystem::remove(dir_link);
+        std::ofstream(target) << std::string(200, 'x');
+        std::filesystem::create_symlink(target, link);
+        std::filesystem::create_symlink(std::filesystem::temp_directory_path(), dir_link);
+
+        REQUIRE(filter.excludesLinkTarget(-1, link, "entry_filter_link", {}));
+        REQUIRE_FALSE(filter.excludesLinkTarget(-1, dir_link, "entry_filter_dir_link", {}));
+        REQUIRE_FALSE(EntryFilter().excludesLinkTarget(-1, link, "entry_filter_link", {}));
+
+        std::filesystem::remove(link);
+        std::filesystem::remove(dir_link);
+        std::filesystem::remove(target);
+    }
+}
+
+TEST_CASE("EntryFilter - Parsing limits", "[EntryFilter]") {
+    REQUIRE(EntryFilter::parseSize("1048576") == 1048576u);
+    REQUIRE(EntryFilter::parseSize("512K") == 512u * 1024);
+    REQUIRE(EntryFilter::parseSize("10GiB") == 10ull << 30);
+    REQUIRE_FALSE(EntryFilter::parseSize("ten"));
+    REQUIRE_FALSE(EntryFilter::parseSize("10X"));
+
+    auto day = EntryFilter::parseTime("2024-01-02");
+    auto later = EntryFilter::parseTime("2024-01-02 00:00:01");
+    REQUIRE(day);
+    REQUIRE(later);
+    REQUIRE(*later - *day == 1);
+    REQUIRE_FALSE(EntryFilter::parseTime("yesterday"));
+}
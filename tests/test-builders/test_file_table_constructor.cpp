@@ -0,0 +1,97 @@
+#include "directory-tree-builders/FileTableConstructor.hpp"
+#include "directory-tree-builders/DirectoryConstructor.hpp"
+#include "directory-tree-builders/NonFollowLinkBuilder.hpp"
+#include "directory-iteration-visitors/ReportWriter.hpp"
+#include "file-system-composite/Directory.hpp"
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    class FileTableConstructorTestMockup {
+    public:
+        const std::filesystem::path base_path;
+
+        FileTableConstructorTestMockup()
+            : base_path(std::filesystem::temp_directory_path() / "file_table_constructor_test")
+        {
+            std::filesystem::remove_all(base_path);
+            for (int d = 0; d < 4; ++d) {
+                auto dir = base_path / ("dir" + std::to_string(d)) / "inner";
+                std::filesystem::create_directories(dir);
+                for (int i = 0; i < 5; ++i) {
+                    std::ofstream(dir / ("file" + std::to_string(i) + ".txt")) << std::string(d + i, 'x');
+                }
+            }
+            std::ofstream(base_path / "top.txt") << "top";
+            std::filesystem::create_symlink("top.txt", base_path / "link");
+            std::filesystem::create_directories(base_path / "empty");
+        }
+
+        ~FileTableConstructorTestMockup() {
+            std::filesystem::remove_all(base_path);
+        }
+
+        FileTableConstructorTestMockup(const FileTableConstructorTestMockup&) = delete;
+        FileTableConstructorTestMockup& operator=(const FileTableConstructorTestMockup&) = delete;
+    };
+
+    static FileTableConstructorTestMockup test_mockup;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+TEST_CASE("FileTableConstructor - Same tree as the composite", "[FileTableConstructor]") {
+    FileTable table = FileTableConstructor().construct(test_mockup.base_path);
+
+    NonFollowLinkBuilder builder;
+    DirectoryConstructor(builder).construct({test_mockup.base_path});
+
+    std::ostringstream from_table;
+    ReportWriter table_report(from_table);
+    table.accept(table_report);
+    table_report.writeSummary();
+
+    std::ostringstream from_composite;
+    ReportWriter composite_report(from_composite);
+    builder.getTree()->accept(composite_report);
+    composite_report.writeSummary();
+
+    REQUIRE(from_table.str() == from_composite.str());
+    REQUIRE(table.size() == 1 + 4 * 2 + 4 * 5 + 3);
+}
+
+TEST_CASE("FileTableConstructor - Entry metadata", "[FileTableConstructor]") {
+    FileTable table = FileTableConstructor().construct(test_mockup.base_path);
+
+    FileTable::Index top = FileTable::NO_PARENT;
+    FileTable::Index link = FileTable::NO_PARENT;
+    for (FileTable::Index i = table.firstChild(0); i < table.firstChild(0) + table.childCount(0); ++i) {
+        if (table.name(i) == "top.txt") top = i;
+        if (table.name(i) == "link") link = i;
+    }
+
+    REQUIRE(top != FileTable::NO_PARENT);
+    REQUIRE(table.fileSize(top) == 3);
+    REQUIRE(table.mtime(top) > 0);
+    REQUIRE(link != FileTable::NO_PARENT);
+    REQUIRE(table.type(link) == FileTable::Type::Link);
+    REQUIRE(table.linkTarget(link) == "top.txt");
+}
+
+TEST_CASE("FileTableConstructor - Roots", "[FileTableConstructor]") {
+    SECTION("A file root is the only child of its parent") {
+        FileTable table = FileTableConstructor().construct(test_mockup.base_path / "top.txt");
+        REQUIRE(table.size() == 2);
+        REQUIRE(table.path(1) == test_mockup.base_path / "top.txt");
+        REQUIRE(table.fileSize(1) == 3);
+    }
+
+    SECTION("A missing root gives an empty table") {
+        REQUIRE(FileTableConstructor().construct(test_mockup.base_path / "missing").empty());
+    }
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include "directory-tree-builders/CycleDetector.hpp"
 #include "file-system-composite/Directory.hpp"
 #include "file-system-composite/File.hpp"
+#include "file-system-composite/Link.hpp"
 #include <catch2/catch_all.hpp>
 #include <filesystem>
 #include <fstream>
@@ -160,7 +161,7 @@ TEST_CASE("LinkFollowBuilder - Following directory links", "[LinkFollowBuilder]"
 }
 
 TEST_CASE("LinkFollowBuilder - Cycle detection integration", "[LinkFollowBuilder]") {
-    SECTION("Same path visited twice - should detect cycle on second visit") {
+    SECTION("Same file visited twice - not a cycle") {
         auto detector = std::make_unique<CycleDetector>();
         LinkFollowBuilder builder(std::move(detector));
         
@@ -176,7 +177,50 @@ TEST_CASE("LinkFollowBuilder - Cycle detection integration", "[LinkFollowBuilder
         REQUIRE(result2 == nullptr);
         
         auto second_file = tree->getChild("second_visit");
-        REQUIRE(second_file == nullptr);
+        REQUIRE(second_file != nullptr);
+        builder.endBuildDirectory();
+    }
+
+    SECTION("Same directory reached along two branches - not a cycle") {
+        auto detector = std::make_unique<CycleDetector>();
+        LinkFollowBuilder builder(std::move(detector));
+        builder.startBuildDirectory(test_mockup.base_path);
+
+        builder.startBuildDirectory("left");
+        REQUIRE(builder.buildLink("shared", test_mockup.target_dir) != nullptr);
+        builder.endBuildDirectory();
+        builder.endBuildDirectory();
+
+        // Reached again, the target is shared instead of being built twice
+        builder.startBuildDirectory("right");
+        REQUIRE(builder.buildLink("shared", test_mockup.link_to_dir) == nullptr);
+        REQUIRE(builder.getTree()->getChild("right")->getChild("shared") != nullptr);
+        builder.endBuildDirectory();
+
+        builder.endBuildDirectory();
+    }
+
+    SECTION("Link back to an ancestor - cycle") {
+        auto detector = std::make_unique<CycleDetector>();
+        LinkFollowBuilder builder(std::move(detector));
+        builder.startBuildDirectory(test_mockup.base_path);
+        builder.startBuildDirectory("target");
+        builder.startBuildDirectory("nested");
+
+        REQUIRE(builder.buildLink("up", test_mockup.target_dir) == nullptr);
+        REQUIRE(builder.buildLink("top", test_mockup.base_path) == nullptr);
+        REQUIRE(builder.getTree()->getChild("target")->getChild("nested")->getChild("up") == nullptr);
+
+        // Below a followed link, its target is an ancestor too
+        builder.endBuildDirectory();
+        builder.endBuildDirectory();
+        Directory* linked = builder.buildLink("linked", test_mockup.nested_dir);
+        REQUIRE(linked != nullptr);
+        REQUIRE(builder.buildLink("again", test_mockup.link_to_nested) == nullptr);
+        builder.endBuildDirectory();
+        REQUIRE(builder.buildLink("sibling", test_mockup.link_to_nested) == nullptr);
+        REQUIRE(builder.getTree()->getChild("sibling") != nullptr);
+
         builder.endBuildDirectory();
     }
     
@@ -293,7 +337,7 @@ TEST_CASE("LinkFollowBuilder - Multiple links in same tree", "[LinkFollowBuilder
         builder.endBuildDirectory();
     }
     
-    SECTION("Build multiple links to same target - only first should succeed") {
+    SECTION("Build multiple links to same file - all succeed") {
         auto detector = std::make_unique<CycleDetector>();
         LinkFollowBuilder builder(std::move(detector));
         builder.startBuildDirectory("root");
@@ -314,8 +358,8 @@ TEST_CASE("LinkFollowBuilder - Multiple links in same tree", "[LinkFollowBuilder
         auto third_link = tree->getChild("third_link");
         
         REQUIRE(first_link != nullptr);
-        REQUIRE(second_link == nullptr);
-        REQUIRE(third_link == nullptr);
+        REQUIRE(second_link != nullptr);
+        REQUIRE(third_link != nullptr);
         
         REQUIRE(first_link->getName() == "first_link");
         builder.endBuildDirectory();
@@ -341,3 +385,67 @@ TEST_CASE("LinkFollowBuilder - Directory building behavior", "[LinkFollowBuilder
         builder.endBuildDirectory();
     }
 }
+
+TEST_CASE("LinkFollowBuilder - Shared link targets", "[LinkFollowBuilder]") {
+    auto detector = std::make_unique<CycleDetector>();
+    LinkFollowBuilder builder(std::move(detector));
+    builder.startBuildDirectory("root");
+
+    SECTION("Links to the same directory share one subtree") {
+        Directory* first = builder.buildLink("first", test_mockup.target_dir);
+        REQUIRE(first != nullptr);
+        REQUIRE(first->getPath() == std::filesystem::path("root") / "first");
+        builder.buildFile("test_file.txt");
+        builder.endBuildDirectory();
+
+        REQUIRE(builder.buildLink("second", test_mockup.link_to_dir) == nullptr);
+
+        auto* first_link = dynamic_cast<Link*>(builder.getTree()->getChild("first"));
+        auto* second_link = dynamic_cast<Link*>(builder.getTree()->getChild("second"));
+        REQUIRE(first_link != nullptr);
+        REQUIRE(second_link != nullptr);
+        REQUIRE(second_link->getResolvedTarget() == first);
+        REQUIRE(first_link->ownsResolvedTarget());
+        REQUIRE_FALSE(second_link->ownsResolvedTarget());
+        REQUIRE(first_link->isTargetShared());
+        REQUIRE(second_link->isTargetShared());
+
+        // The shared data is counted once
+        auto totals = builder.getTree()->getTotals();
+        REQUIRE(totals.files == 1);
+        REQUIRE(totals.links == 2);
+    }
+
+    SECTION("Links to the same file share one target") {
+        builder.buildLink("first", test_mockup.test_file);
+        builder.buildLink("second", test_mockup.link_to_file);
+        builder.buildLink("other", test_mockup.nested_file);
+
+        auto* first_link = dynamic_cast<Link*>(builder.getTree()->getChild("first"));
+        auto* second_link = dynamic_cast<Link*>(builder.getTree()->getChild("second"));
+        auto* other_link = dynamic_cast<Link*>(builder.getTree()->getChild("other"));
+        REQUIRE(second_link->getResolvedTarget() == first_link->getResolvedTarget());
+        REQUIRE(first_link->getResolvedTarget()->getPath() == std::filesystem::path("root") / "first");
+        REQUIRE_FALSE(other_link->isTargetShared());
+        REQUIRE(builder.getTree()->getTotals().files == 2);
+    }
+
+    SECTION("Removing the owning link unresolves the links sharing its target") {
+        builder.buildLink("first", test_mockup.test_file);
+        builder.buildLink("second", test_mockup.link_to_file);
+        auto* second_link = dynamic_cast<Link*>(builder.getTree()->getChild("second"));
+        REQUIRE(second_link->getResolvedTarget() != nullptr);
+
+        REQUIRE(builder.getTree()->remove("first"));
+        REQUIRE(second_link->getResolvedTarget() == nullptr);
+        REQUIRE(second_link->getSize() == 0);
+
+        // The builder no longer hands out the removed subtree
+        builder.buildLink("third", test_mockup.test_file);
+        auto* third_link = dynamic_cast<Link*>(builder.getTree()->getChild("third"));
+        REQUIRE(third_link->ownsResolvedTarget());
+        REQUIRE(third_link->getResolvedTarget()->getPath() == std::filesystem::path("root") / "third");
+    }
+
+    builder.endBuildDirectory();
+}
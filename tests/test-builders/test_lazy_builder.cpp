@@ -0,0 +1,89 @@
+#include "directory-tree-builders/LazyBuilder.hpp"
+#include "directory-tree-builders/DirectoryConstructor.hpp"
+#include "directory-tree-builders/LinkFollowBuilder.hpp"
+#include "directory-tree-builders/NonFollowLinkBuilder.hpp"
+#include "directory-tree-builders/CycleDetector.hpp"
+#include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
+#include "TreeRecorder.hpp"
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace {
+    struct LazyFixture {
+        const std::filesystem::path root = std::filesystem::temp_directory_path() / "lazy_builder_test";
+
+        LazyFixture() {
+            std::filesystem::remove_all(root);
+            std::filesystem::create_directories(root / "left" / "deep");
+            std::filesystem::create_directories(root / "right");
+            std::ofstream(root / "top.txt") << "top";
+            std::ofstream(root / "left" / "deep" / "leaf.txt") << "leaf!";
+            std::ofstream(root / "right" / "r.txt") << "r";
+            std::filesystem::create_symlink(root / "left", root / "to_left");
+        }
+
+        ~LazyFixture() {
+            std::filesystem::remove_all(root);
+        }
+    };
+}
+
+TEST_CASE("LazyBuilder - Directories are listed on demand", "[LazyBuilder]") {
+    LazyFixture fixture;
+    LazyBuilder builder(std::make_unique<NonFollowLinkBuilder>());
+    builder.startBuildDirectory(fixture.root);
+    builder.endBuildDirectory();
+
+    Directory* root = builder.getTree();
+    REQUIRE(root != nullptr);
+    REQUIRE_FALSE(root->isExpanded());
+    REQUIRE(root->getTotals().unexpanded == 1);
+
+    SECTION("A lookup lists only the directory looked into") {
+        auto* left = dynamic_cast<Directory*>(root->getChild("left"));
+        REQUIRE(left != nullptr);
+        REQUIRE(root->isExpanded());
+        REQUIRE_FALSE(left->isExpanded());
+        REQUIRE(root->getTotals().unexpanded == 2);
+        REQUIRE(root->getTotals().files == 1);
+
+        REQUIRE(left->getChild("deep") != nullptr);
+        REQUIRE(root->getTotals().unexpanded == 2);
+    }
+
+    SECTION("Visiting lists the whole tree") {
+        NonFollowLinkBuilder eager;
+        DirectoryConstructor(eager).construct({fixture.root});
+
+        REQUIRE(recordTree(root) == recordTree(eager.getTree()));
+        REQUIRE(root->getTotals().unexpanded == 0);
+        REQUIRE(root->getTotals().files == 3);
+    }
+
+    SECTION("Sizing lists the whole tree") {
+        REQUIRE(root->getSize() == std::string("top" "leaf!" "r").size());
+        REQUIRE(root->getTotals().unexpanded == 0);
+    }
+}
+
+TEST_CASE("LazyBuilder - Followed links", "[LazyBuilder]") {
+    LazyFixture fixture;
+    LazyBuilder builder(std::make_unique<LinkFollowBuilder>(std::make_unique<CycleDetector>()));
+    builder.startBuildDirectory(fixture.root);
+    builder.endBuildDirectory();
+
+    auto* link = builder.getTree()->getChild("to_left");
+    REQUIRE(link != nullptr);
+    auto* target = dynamic_cast<Directory*>(link->getResolvedTarget());
+    REQUIRE(target != nullptr);
+    REQUIRE_FALSE(target->isExpanded());
+
+    auto* deep = target->getChild("deep");
+    REQUIRE(deep != nullptr);
+    REQUIRE(deep->getChild("leaf.txt") != nullptr);
+    REQUIRE(deep->getChild("leaf.txt")->getPath() == fixture.root / "to_left" / "deep" / "leaf.txt");
+}
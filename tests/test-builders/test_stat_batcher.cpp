@@ -0,0 +1,103 @@
+#include "directory-tree-builders/StatBatcher.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/DirectoryHandle.hpp"
+#include "file-system-composite/File.hpp"
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    class StatBatcherTestMockup {
+    public:
+        const std::filesystem::path base = std::filesystem::temp_directory_path() / "stat_batcher_test";
+        Directory root{base};
+        std::vector<File*> files;
+
+        explicit StatBatcherTestMockup(int count) {
+            std::filesystem::remove_all(base);
+            std::filesystem::create_directories(base);
+            for (int i = 0; i < count; ++i) {
+                auto name = "file" + std::to_string(i) + ".txt";
+                std::ofstream(base / name) << std::string(i + 1, 'x');
+                files.push_back(root.createFile(name));
+            }
+        }
+
+        ~StatBatcherTestMockup() {
+            std::filesystem::remove_all(base);
+        }
+
+        /// Afterwards only recorded sizes can be right; getSize cannot stat the files anymore
+        void dropFromDisk() const {
+            std::filesystem::remove_all(base);
+        }
+
+        bool sizesMatch() const {
+            for (std::size_t i = 0; i < files.size(); ++i) {
+                if (files[i]->getSize() != i + 1) return false;
+            }
+            return true;
+        }
+    };
+}
+
+TEST_CASE("StatBatcher - Filling sizes", "[StatBatcher]") {
+    // More files than one io_uring submission holds
+    StatBatcherTestMockup mockup(300);
+
+    SECTION("By full path") {
+        StatBatcher batcher;
+        batcher.fillSizes(-1, mockup.files);
+        mockup.dropFromDisk();
+        REQUIRE(mockup.sizesMatch());
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    SECTION("Relative to a directory handle") {
+        auto handle = DirectoryHandle::open(-1, mockup.base);
+        StatBatcher batcher;
+        batcher.fillSizes(handle.fd(), mockup.files);
+        mockup.dropFromDisk();
+        REQUIRE(mockup.sizesMatch());
+    }
+#endif
+
+    SECTION("Thread pool backend") {
+        StatBatcher batcher(4, StatBatcher::Backend::ThreadPool);
+        REQUIRE_FALSE(batcher.usesIoUring());
+        batcher.fillSizes(-1, mockup.files);
+
+        // The pool is reused for the next batch
+        for (File* file : mockup.files) file->setSize(0);
+        batcher.fillSizes(-1, mockup.files);
+        mockup.dropFromDisk();
+        REQUIRE(mockup.sizesMatch());
+    }
+}
+
+TEST_CASE("StatBatcher - Missing files", "[StatBatcher]") {
+    StatBatcherTestMockup mockup(3);
+    File* missing = mockup.root.createFile("missing.txt");
+
+    StatBatcher batcher;
+    batcher.fillSizes(-1, {mockup.files[0], missing});
+    REQUIRE(mockup.files[0]->getSize() == 1);
+    REQUIRE(missing->getSize() == 0);
+}
+
+TEST_CASE("StatBatcher - Hard links", "[StatBatcher]") {
+    StatBatcherTestMockup mockup(2);
+    std::filesystem::create_hard_link(mockup.base / "file0.txt", mockup.base / "copy.txt");
+    File* copy = mockup.root.createFile("copy.txt");
+    std::vector<File*> files{mockup.files[0], copy, mockup.files[1]};
+
+    auto backend = GENERATE(StatBatcher::Backend::Auto, StatBatcher::Backend::ThreadPool);
+    StatBatcher batcher(1, backend);
+    batcher.fillSizes(-1, files);
+
+    REQUIRE(mockup.files[0]->getSharedInode());
+    REQUIRE(mockup.files[0]->getSharedInode() == copy->getSharedInode());
+    REQUIRE_FALSE(mockup.files[1]->getSharedInode());
+}
@@ -0,0 +1,173 @@
+#include "directory-tree-builders/TreeSnapshot.hpp"
+#include "directory-tree-builders/DirectoryConstructor.hpp"
+#include "directory-tree-builders/LinkFollowBuilder.hpp"
+#include "directory-tree-builders/NonFollowLinkBuilder.hpp"
+#include "directory-tree-builders/CycleDetector.hpp"
+#include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
+#include "TreeRecorder.hpp"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace {
+    /**
+     * @brief A listing time later than the fixture's changes; directories changed
+     * shortly before the real listing time are never trusted.
+     */
+    std::chrono::system_clock::time_point settledListing() {
+        return std::chrono::system_clock::now() + std::chrono::seconds(2);
+    }
+
+    struct SnapshotFixture {
+        const std::filesystem::path base = std::filesystem::temp_directory_path() / "tree_snapshot_test";
+        const std::filesystem::path root = base / "root";
+        const std::filesystem::path snapshot = base / "tree.snapshot";
+
+        SnapshotFixture() {
+            std::filesystem::remove_all(base);
+            std::filesystem::create_directories(root / "sub" / "nested");
+            std::ofstream(root / "a.txt") << "alpha";
+            std::ofstream(root / "sub" / "b.txt") << "bravo!";
+            std::ofstream(root / "sub" / "nested" / "c.txt") << "c";
+            std::filesystem::create_symlink(root / "sub" / "nested", root / "to_nested");
+        }
+
+        ~SnapshotFixture() {
+            std::filesystem::remove_all(base);
+        }
+    };
+}
+
+TEST_CASE("TreeSnapshot - Round trip", "[TreeSnapshot]") {
+    SnapshotFixture fixture;
+
+    LinkFollowBuilder built(std::make_unique<CycleDetector>());
+    DirectoryConstructor(built).construct({fixture.root});
+    REQUIRE(TreeSnapshot::save(*built.getTree(), fixture.snapshot, "key", settledListing()));
+    REQUIRE_FALSE(std::filesystem::exists(fixture.snapshot.string() + ".tmp"));
+
+    LinkFollowBuilder loaded(std::make_unique<CycleDetector>());
+    REQUIRE(TreeSnapshot::load(fixture.snapshot, loaded, "key"));
+    REQUIRE(recordTree(loaded.getTree()) == recordTree(built.getTree()));
+    REQUIRE(loaded.getTree()->getSize() == built.getTree()->getSize());
+
+    SECTION("Links are resolved by the loading builder") {
+        NonFollowLinkBuilder not_following;
+        REQUIRE(TreeSnapshot::load(fixture.snapshot, not_following, "key"));
+        auto entries = recordTree(not_following.getTree());
+        REQUIRE(entries.count("L " + (fixture.root / "to_nested").string() + " -> "
+                              + (fixture.root / "sub" / "nested").string()) == 1);
+        REQUIRE(entries.count("F " + (fixture.root / "to_nested" / "c.txt").string() + " 1") == 0);
+    }
+
+    SECTION("Another key is not loaded") {
+        NonFollowLinkBuilder other;
+        REQUIRE_FALSE(TreeSnapshot::load(fixture.snapshot, other, "other key"));
+        REQUIRE(other.getTree() == nullptr);
+    }
+
+    SECTION("Damaged files are not loaded") {
+        std::filesystem::resize_file(fixture.snapshot, std::filesystem::file_size(fixture.snapshot) - 1);
+        NonFollowLinkBuilder damaged;
+        REQUIRE_FALSE(TreeSnapshot::load(fixture.snapshot, damaged, "key"));
+        REQUIRE_FALSE(TreeSnapshot::load(fixture.base / "missing.snapshot", damaged, "key"));
+    }
+}
+
+TEST_CASE("TreeSnapshot - Confirming entries", "[TreeSnapshot]") {
+    SnapshotFixture fixture;
+
+    NonFollowLinkBuilder built;
+    DirectoryConstructor(built).construct({fixture.root});
+    REQUIRE(TreeSnapshot::save(*built.getTree(), fixture.snapshot, "key", settledListing()));
+
+    SECTION("Changed files keep their place with their new size") {
+        std::ofstream(fixture.root / "sub" / "b.txt", std::ios::app) << " and more";
+
+        NonFollowLinkBuilder loaded;
+        REQUIRE(TreeSnapshot::load(fixture.snapshot, loaded, "key"));
+        auto* file = loaded.getTree()->getChild("sub")->getChild("b.txt");
+        REQUIRE(file != nullptr);
+        REQUIRE(file->getSize() == std::string("bravo! and more").size());
+    }
+
+    SECTION("A new entry makes the snapshot stale") {
+        std::ofstream(fixture.root / "sub" / "nested" / "d.txt") << "d";
+
+        NonFollowLinkBuilder loaded;
+        REQUIRE_FALSE(TreeSnapshot::load(fixture.snapshot, loaded, "key"));
+        REQUIRE(loaded.getTree() == nullptr);
+    }
+
+    SECTION("A removed entry makes the snapshot stale") {
+        std::filesystem::remove(fixture.root / "a.txt");
+
+        NonFollowLinkBuilder loaded;
+        REQUIRE_FALSE(TreeSnapshot::load(fixture.snapshot, loaded, "key"));
+    }
+}
+
+TEST_CASE("TreeSnapshot - Directories changed during the listing", "[TreeSnapshot]") {
+    SnapshotFixture fixture;
+
+    NonFollowLinkBuilder built;
+    auto listed = std::chrono::system_clock::now();
+    DirectoryConstructor(built).construct({fixture.root});
+    REQUIRE(TreeSnapshot::save(*built.getTree(), fixture.snapshot, "key", listed));
+
+    NonFollowLinkBuilder loaded;
+    REQUIRE_FALSE(TreeSnapshot::load(fixture.snapshot, loaded, "key"));
+
+    DirectoryListings listings;
+    REQUIRE(TreeSnapshot::loadListings(fixture.snapshot, "key", listings));
+    REQUIRE(listings.empty());
+}
+
+TEST_CASE("TreeSnapshot - Directories changed between listing and saving", "[TreeSnapshot]") {
+    SnapshotFixture fixture;
+
+    NonFollowLinkBuilder built;
+    auto listed = std::chrono::system_clock::now();
+    DirectoryConstructor(built).construct({fixture.root});
+
+    // Saving stats directories again; their new stamps must not vouch for the old listing
+    std::ofstream(fixture.root / "sub" / "late.txt") << "late";
+    REQUIRE(TreeSnapshot::save(*built.getTree(), fixture.snapshot, "key", listed));
+
+    NonFollowLinkBuilder loaded;
+    REQUIRE_FALSE(TreeSnapshot::load(fixture.snapshot, loaded, "key"));
+}
+
+TEST_CASE("TreeSnapshot - Reusing listings of unchanged directories", "[TreeSnapshot]") {
+    SnapshotFixture fixture;
+
+    LinkFollowBuilder built(std::make_unique<CycleDetector>());
+    DirectoryConstructor(built).construct({fixture.root});
+    REQUIRE(TreeSnapshot::save(*built.getTree(), fixture.snapshot, "key", settledListing()));
+
+    std::ofstream(fixture.root / "sub" / "nested" / "d.txt") << "delta";
+    std::ofstream(fixture.root / "a.txt", std::ios::app) << " and more";
+
+    DirectoryListings listings;
+    REQUIRE_FALSE(TreeSnapshot::loadListings(fixture.snapshot, "other key", listings));
+    REQUIRE(TreeSnapshot::loadListings(fixture.snapshot, "key", listings));
+
+    std::size_t threads = GENERATE(1, 4);
+    LinkFollowBuilder incremental(std::make_unique<CycleDetector>());
+    DirectoryConstructor constructor(incremental, threads);
+    constructor.collectSizes(true);
+    constructor.setListings(&listings);
+    constructor.construct({fixture.root});
+
+    LinkFollowBuilder fresh(std::make_unique<CycleDetector>());
+    DirectoryConstructor(fresh).construct({fixture.root});
+    REQUIRE(recordTree(incremental.getTree()) == recordTree(fresh.getTree()));
+
+    // Only sub/nested changed; it is reached both directly and through the link
+    REQUIRE(listings.relisted() == 2);
+    REQUIRE(listings.reused() == 2);
+}
@@ -1,10 +1,53 @@
 #include "file-system-composite/Directory.hpp"
 #include "file-system-composite/File.hpp"
 #include "file-system-composite/FileObject.hpp"
+#include "file-system-composite/Link.hpp"
+
+#include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
 
 #include <catch2/catch_all.hpp>
+#include <algorithm>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    class NameRecorder : public DirectoryIterationVisitor {
+    public:
+        NameRecorder() : DirectoryIterationVisitor(std::cerr) {}
+        void visitFile(File& file) override { names.push_back(file.getName()); }
+        void visitDirectory(Directory& dir) override { names.push_back(dir.getName()); }
+
+        std::vector<std::string> names;
+    };
+
+    /// Fills a directory with one file and, unless it is a stub itself, one stub subdirectory
+    class CountingExpander : public DirectoryExpander {
+    public:
+        void expand(Directory& dir) override {
+            ++expansions;
+            // Looking into the directory being filled does not expand it again
+            REQUIRE(dir.getChild("file.txt") == nullptr);
+            dir.createFile("file.txt")->setSize(10);
+            if (dir.getName() != "stub") {
+                dir.createSubdirectory("stub")->setExpander(this);
+            }
+        }
+
+        int expansions = 0;
+    };
+
+    /// Adds one file, then fails
+    class ThrowingExpander : public DirectoryExpander {
+    public:
+        void expand(Directory& dir) override {
+            dir.createFile("partial.txt")->setSize(5);
+            throw std::runtime_error("listing failed");
+        }
+    };
+}
 
 TEST_CASE("Directory constructor", "[Directory]")
 {
@@ -599,4 +642,198 @@ TEST_CASE("Directory polymorphic behavior", "[Directory]")
         REQUIRE(file_obj->getName() == "file.txt");
         REQUIRE(dir_obj->getName() == "subdir");
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Directory children order and bulk insertion", "[Directory]")
+{
+    SECTION("Children are visited in name order regardless of insertion order")
+    {
+        Directory root("root");
+        root.createFile("b.txt");
+        root.createSubdirectory("c");
+        root.createFile("a.txt");
+        root.createFile("B.txt");
+
+        NameRecorder recorder;
+        root.accept(recorder);
+        REQUIRE(recorder.names == std::vector<std::string>{"root", "B.txt", "a.txt", "b.txt", "c"});
+    }
+
+    SECTION("Appended children are sorted before lookups and visits")
+    {
+        Directory root("root");
+        for (int i = 999; i >= 0; --i) {
+            std::string name = "file" + std::to_string(i);
+            FileObject* appended = root.append(std::make_unique<File>(name, &root));
+            REQUIRE(appended->getOwner() == &root);
+        }
+
+        REQUIRE(root.getChildCount() == 1000);
+        REQUIRE(root.getChild("file0") != nullptr);
+        REQUIRE(root.getChild("file999") != nullptr);
+        REQUIRE(root.getChild("file1000") == nullptr);
+
+        NameRecorder recorder;
+        root.accept(recorder);
+        REQUIRE(recorder.names.size() == 1001);
+        REQUIRE(std::is_sorted(recorder.names.begin() + 1, recorder.names.end()));
+    }
+
+    SECTION("Appending and adding can be mixed")
+    {
+        Directory root("root");
+        root.append(std::make_unique<File>("m.txt", &root));
+        root.append(std::make_unique<File>("d.txt", &root));
+        REQUIRE(root.add(std::make_unique<File>("x.txt", &root)));
+        REQUIRE_FALSE(root.add(std::make_unique<File>("d.txt", &root)));
+        root.append(std::make_unique<File>("a.txt", &root));
+        REQUIRE(root.remove("m.txt"));
+
+        NameRecorder recorder;
+        root.accept(recorder);
+        REQUIRE(recorder.names == std::vector<std::string>{"root", "a.txt", "d.txt", "x.txt"});
+    }
+
+    SECTION("Of appended children with the same name the first one is kept")
+    {
+        Directory root("root");
+        FileObject* first = root.append(std::make_unique<File>("same.txt", &root));
+        root.append(std::make_unique<Directory>("same.txt", &root));
+        root.sortChildren();
+
+        REQUIRE(root.getChildCount() == 1);
+        REQUIRE(root.getChild("same.txt") == first);
+    }
+}
+
+TEST_CASE("Directory totals", "[Directory]")
+{
+    Directory root("root");
+    Directory* sub = root.createSubdirectory("sub");
+    root.createFile("a.txt")->setSize(10);
+    File* b = sub->createFile("b.txt");
+    b->setSize(20);
+
+    SECTION("Sizes and counts are aggregated up the tree")
+    {
+        TreeTotals totals = root.getTotals();
+        REQUIRE(totals.size == 30);
+        REQUIRE(totals.files == 2);
+        REQUIRE(totals.links == 0);
+        REQUIRE(totals.unsized == 0);
+        REQUIRE(root.getSize() == 30);
+        REQUIRE(sub->getTotals().files == 1);
+    }
+
+    SECTION("Resizing a file updates every ancestor")
+    {
+        b->setSize(5);
+        REQUIRE(sub->getSize() == 5);
+        REQUIRE(root.getSize() == 15);
+    }
+
+    SECTION("Removing a subtree subtracts its totals")
+    {
+        REQUIRE(root.remove("sub"));
+        REQUIRE(root.getTotals().files == 1);
+        REQUIRE(root.getSize() == 10);
+    }
+
+    SECTION("Adding a populated subtree adds its totals")
+    {
+        auto other = std::make_unique<Directory>("other", &root);
+        other->createFile("c.txt")->setSize(7);
+        other->createFile("d.txt")->setSize(8);
+        REQUIRE(root.getTotals().files == 2);
+
+        root.add(std::move(other));
+        REQUIRE(root.getTotals().files == 4);
+        REQUIRE(root.getSize() == 45);
+    }
+
+    SECTION("Links and their resolved targets are counted")
+    {
+        auto link = std::make_unique<Link>("link", "a.txt", sub);
+        auto target = std::make_unique<File>("link", link.get());
+        target->setSize(10);
+        link->setResolveTarget(std::move(target));
+        sub->add(std::move(link));
+        sub->add(std::make_unique<Link>("dangling", "missing", sub));
+
+        TreeTotals totals = root.getTotals();
+        REQUIRE(totals.links == 2);
+        REQUIRE(totals.files == 3);
+        REQUIRE(totals.size == 40);
+    }
+
+    SECTION("Files without a size are counted until their size is fetched")
+    {
+        root.createFile("unknown.txt");
+        REQUIRE(root.getTotals().unsized == 1);
+
+        // The file does not exist, so fetching its size finds nothing
+        REQUIRE(root.getSize() == 30);
+        REQUIRE(root.getTotals().unsized == 1);
+
+        root.getChild("unknown.txt")->setSize(3);
+        REQUIRE(root.getTotals().unsized == 0);
+        REQUIRE(root.getSize() == 33);
+    }
+
+    SECTION("Duplicates dropped from appended children are not counted")
+    {
+        root.append(std::make_unique<File>("z.txt", &root))->setSize(1);
+        root.append(std::make_unique<File>("z.txt", &root))->setSize(100);
+        root.sortChildren();
+        REQUIRE(root.getTotals().files == 3);
+        REQUIRE(root.getSize() == 31);
+    }
+}
+
+TEST_CASE("Directory lazy expansion", "[Directory]")
+{
+    CountingExpander expander;
+    Directory root("root");
+    auto* lazy = root.createSubdirectory("lazy");
+    lazy->setExpander(&expander);
+    REQUIRE_FALSE(lazy->isExpanded());
+    REQUIRE(root.getTotals().unexpanded == 1);
+    REQUIRE(expander.expansions == 0);
+
+    SECTION("Lookups expand once")
+    {
+        REQUIRE(lazy->getChild("file.txt") != nullptr);
+        REQUIRE(lazy->getChildCount() == 2);
+        REQUIRE(expander.expansions == 1);
+        REQUIRE(lazy->isExpanded());
+
+        // The new stub replaces the expanded directory in the count
+        REQUIRE(root.getTotals().unexpanded == 1);
+        REQUIRE(root.getTotals().files == 1);
+    }
+
+    SECTION("Visiting expands everything reached")
+    {
+        NameRecorder recorder;
+        root.accept(recorder);
+        REQUIRE(recorder.names == std::vector<std::string>{"root", "lazy", "file.txt", "stub", "file.txt"});
+        REQUIRE(expander.expansions == 2);
+        REQUIRE(root.getTotals().unexpanded == 0);
+    }
+
+    SECTION("Sizing expands everything below")
+    {
+        REQUIRE(root.getSize() == 20);
+        REQUIRE(expander.expansions == 2);
+    }
+    SECTION("An expander that throws leaves the directory expanded with what it added")
+    {
+        ThrowingExpander failing;
+        auto* broken = root.createSubdirectory("broken");
+        broken->setExpander(&failing);
+        REQUIRE_THROWS_AS(broken->getChild("partial.txt"), std::runtime_error);
+        REQUIRE(broken->isExpanded());
+        REQUIRE(broken->getChild("partial.txt") != nullptr);
+        REQUIRE(root.getTotals().unexpanded == 1);
+    }
+}
@@ -0,0 +1,215 @@
+#include "file-system-composite/DirectoryHandle.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include "file-system-composite/FileTable.hpp"
+#include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
+
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    /// Records whether the owner of each file is pinned when the file is visited
+    class PinRecorder : public DirectoryIterationVisitor {
+    public:
+        explicit PinRecorder(bool reads) : DirectoryIterationVisitor(std::cerr), _reads(reads) {}
+
+        void visitFile(File& file) override {
+            pinned.push_back(dynamic_cast<Directory*>(file.getOwner())->handle() >= 0);
+        }
+        bool readsFiles() const override { return _reads; }
+
+        std::vector<bool> pinned;
+    private:
+        bool _reads;
+    };
+}
+
+TEST_CASE("DirectoryHandle open and close", "[DirectoryHandle]")
+{
+    auto base = std::filesystem::temp_directory_path() / "directory_handle_test";
+    std::filesystem::create_directories(base / "sub");
+    std::ofstream(base / "file.txt") << "data";
+
+    SECTION("Open an existing directory")
+    {
+        auto handle = DirectoryHandle::open(-1, base);
+        REQUIRE(handle.isOpen());
+        REQUIRE(handle.fd() >= 0);
+
+        handle.close();
+        REQUIRE_FALSE(handle.isOpen());
+        REQUIRE(handle.fd() == -1);
+    }
+
+    SECTION("Open relative to a parent handle")
+    {
+        auto parent = DirectoryHandle::open(-1, base);
+        auto child = DirectoryHandle::open(parent.fd(), "sub");
+        REQUIRE(child.isOpen());
+    }
+
+    SECTION("Regular files and missing paths are not opened")
+    {
+        REQUIRE_FALSE(DirectoryHandle::open(-1, base / "file.txt").isOpen());
+        REQUIRE_FALSE(DirectoryHandle::open(-1, base / "missing").isOpen());
+    }
+
+    SECTION("Moving transfers the descriptor")
+    {
+        auto first = DirectoryHandle::open(-1, base);
+        int fd = first.fd();
+        DirectoryHandle second(std::move(first));
+        REQUIRE(second.fd() == fd);
+        REQUIRE_FALSE(first.isOpen());
+    }
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("Directory pinning", "[DirectoryHandle]")
+{
+    auto base = std::filesystem::temp_directory_path() / "directory_pin_test";
+    std::filesystem::create_directories(base / "sub");
+    std::ofstream(base / "sub" / "file.txt") << "Hello";
+
+    Directory root(base);
+    Directory* sub = root.createSubdirectory("sub");
+    File* file = sub->createFile("file.txt");
+
+    SECTION("Unpinned directories hold no descriptor")
+    {
+        REQUIRE(sub->handle() == -1);
+        REQUIRE_FALSE(sub->tryPin());
+    }
+
+    SECTION("Pins are counted")
+    {
+        sub->pin();
+        REQUIRE(sub->handle() >= 0);
+        REQUIRE(sub->tryPin());
+        sub->unpin();
+        REQUIRE(sub->handle() >= 0);
+        sub->unpin();
+        REQUIRE(sub->handle() == -1);
+    }
+
+    SECTION("Child directories open relative to a pinned parent")
+    {
+        Directory::Pin root_pin(root);
+        Directory::Pin sub_pin(*sub);
+        REQUIRE(sub->handle() >= 0);
+    }
+
+    SECTION("Files read the same through a pinned owner")
+    {
+        Directory::Pin pin(*sub);
+        auto contents = file->read();
+        REQUIRE(std::string(contents.begin(), contents.end()) == "Hello");
+        REQUIRE(file->getSize() == 5);
+    }
+
+    SECTION("Only visitors that read files pin the directories they walk")
+    {
+        PinRecorder lister(false);
+        root.accept(lister);
+        REQUIRE(lister.pinned == std::vector<bool>{false});
+
+        PinRecorder reader(true);
+        root.accept(reader);
+        REQUIRE(reader.pinned == std::vector<bool>{true});
+        REQUIRE(sub->handle() == -1);
+    }
+
+    SECTION("Compact tables pin only for visitors that read files")
+    {
+        FileTable table;
+        auto table_root = table.addRoot(base);
+        std::vector<FileTable::Entry> top { FileTable::Entry{"sub", FileTable::Type::Directory} };
+        auto table_sub = table.addChildren(table_root, top);
+        std::vector<FileTable::Entry> files { FileTable::Entry{"file.txt", FileTable::Type::File, 5} };
+        table.addChildren(table_sub, files);
+
+        PinRecorder lister(false);
+        table.accept(lister);
+        REQUIRE(lister.pinned == std::vector<bool>{false});
+
+        PinRecorder reader(true);
+        table.accept(reader);
+        REQUIRE(reader.pinned == std::vector<bool>{true});
+    }
+
+    SECTION("Missing directories pin without a descriptor and fall back to paths")
+    {
+        Directory missing(base / "missing");
+        File* orphan = missing.createFile("file.txt");
+        Directory::Pin pin(missing);
+        REQUIRE(missing.handle() == -1);
+        REQUIRE(orphan->getSize() == 0);
+        REQUIRE_THROWS_AS(orphan->read(), std::ios_base::failure);
+    }
+
+    std::filesystem::remove_all(base);
+}
+
+TEST_CASE("Directory pinning from several threads", "[DirectoryHandle]")
+{
+    auto base = std::filesystem::temp_directory_path() / "directory_pin_threads_test";
+    std::filesystem::create_directories(base / "sub");
+    std::filesystem::create_directories(base / "other");
+    struct stat expected {};
+    REQUIRE(::stat((base / "sub").c_str(), &expected) == 0);
+
+    Directory root(base);
+    Directory* sub = root.createSubdirectory("sub");
+
+    // A pinned handle must always be the directory's own, even while other
+    // threads close it and unrelated opens reuse descriptor numbers
+    std::atomic<bool> done{false};
+    std::atomic<int> mismatches{0};
+    std::thread churn([&]() {
+        while (!done) {
+            int fd = ::open((base / "other").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    });
+    std::vector<std::thread> pinners;
+    for (int t = 0; t < 4; ++t) {
+        pinners.emplace_back([&, t]() {
+            for (int i = 0; i < 5000; ++i) {
+                bool pinned = (i + t) % 2 == 0 ? (sub->pin(), true) : sub->tryPin();
+                if (!pinned) {
+                    continue;
+                }
+                struct stat st {};
+                if (::fstat(sub->handle(), &st) != 0 || st.st_ino != expected.st_ino) {
+                    ++mismatches;
+                }
+                sub->unpin();
+            }
+        });
+    }
+    for (auto& thread : pinners) {
+        thread.join();
+    }
+    done = true;
+    churn.join();
+
+    REQUIRE(mismatches == 0);
+    REQUIRE(sub->handle() == -1);
+
+    std::filesystem::remove_all(base);
+}
+
+#endif
@@ -1,4 +1,6 @@
 #include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
 #include <stdexcept>
 #include "file-system-composite/File.hpp"
@@ -62,6 +64,57 @@ TEST_CASE("File getSize and setSize", "[File]") {
         test_file.setSize(200);
         REQUIRE(test_file.getSize() == 200);
     }
+
+    SECTION("A cached size of zero is not fetched again") {
+        auto dir = std::filesystem::temp_directory_path() / "file_size_zero";
+        std::filesystem::create_directories(dir);
+        std::ofstream(dir / "empty.txt").close();
+
+        Directory disk_dir(dir);
+        File* empty = disk_dir.createFile("empty.txt");
+        REQUIRE(empty->getSize() == 0);
+
+        std::ofstream(dir / "empty.txt") << "grown";
+        REQUIRE(empty->getSize() == 0);
+
+        std::filesystem::remove_all(dir);
+    }
+}
+
+TEST_CASE("File shared inodes", "[File]") {
+    Directory root_dir("test_dir");
+    File test_file("test.txt", &root_dir);
+
+    SECTION("Only inodes with several names are recorded") {
+        REQUIRE_FALSE(test_file.getSharedInode());
+        test_file.setInode(FileId{1, 2}, 1);
+        REQUIRE_FALSE(test_file.getSharedInode());
+        test_file.setInode(FileId{1, 2}, 3);
+        REQUIRE(test_file.getSharedInode() == FileId{1, 2});
+    }
+
+    SECTION("Fetching the size records hard links") {
+        auto dir = std::filesystem::temp_directory_path() / "file_shared_inode";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        std::ofstream(dir / "original.txt") << "data";
+        std::filesystem::create_hard_link(dir / "original.txt", dir / "link.txt");
+        std::ofstream(dir / "single.txt") << "data";
+
+        Directory disk_dir(dir);
+        File* original = disk_dir.createFile("original.txt");
+        File* link = disk_dir.createFile("link.txt");
+        File* single = disk_dir.createFile("single.txt");
+        original->getSize();
+        link->getSize();
+        single->getSize();
+
+        REQUIRE(original->getSharedInode());
+        REQUIRE(original->getSharedInode() == link->getSharedInode());
+        REQUIRE_FALSE(single->getSharedInode());
+
+        std::filesystem::remove_all(dir);
+    }
 }
 
 TEST_CASE("File read from stream", "[File]") {
@@ -166,4 +219,46 @@ TEST_CASE("File edge cases", "[File]") {
         
         REQUIRE(test_file.getSize() == 42);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("File chunked read of sparse files", "[File]") {
+    auto base = std::filesystem::temp_directory_path() / "file_sparse_test";
+    std::filesystem::create_directories(base);
+    Directory root_dir(base);
+
+    auto collect = [](const File& file) {
+        std::string contents;
+        file.read([&contents](const char* data, std::size_t size) { contents.append(data, size); });
+        return contents;
+    };
+
+    SECTION("Data between holes is read as a dense read would") {
+        const std::size_t hole = 4 * 1024 * 1024;
+        {
+            std::ofstream out(base / "sparse.img", std::ios::binary);
+            out << "head";
+            out.seekp(static_cast<std::streamoff>(hole));
+            out << "middle";
+        }
+        std::filesystem::resize_file(base / "sparse.img", 2 * hole);
+
+        File sparse("sparse.img", &root_dir);
+        std::string contents = collect(sparse);
+
+        std::string expected(2 * hole, '\0');
+        expected.replace(0, 4, "head");
+        expected.replace(hole, 6, "middle");
+        REQUIRE(contents.size() == expected.size());
+        REQUIRE(contents == expected);
+    }
+
+    SECTION("File made only of a hole") {
+        std::ofstream(base / "empty.img", std::ios::binary).close();
+        std::filesystem::resize_file(base / "empty.img", 1024 * 1024);
+
+        File sparse("empty.img", &root_dir);
+        REQUIRE(collect(sparse) == std::string(1024 * 1024, '\0'));
+    }
+
+    std::filesystem::remove_all(base);
+}
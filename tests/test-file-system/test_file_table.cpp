@@ -0,0 +1,138 @@
+#include "file-system-composite/FileTable.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include "file-system-composite/Link.hpp"
+#include "directory-iteration-visitors/DirectoryIterationVisitor.hpp"
+
+#include <catch2/catch_all.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    class PathRecorder : public DirectoryIterationVisitor {
+    public:
+        PathRecorder() : DirectoryIterationVisitor(std::cerr) {}
+
+        void visitDirectory(Directory& dir) override { visited.push_back("D " + dir.getPath().string()); }
+        void visitFile(File& file) override {
+            visited.push_back("F " + file.getPath().string() + " " + std::to_string(file.getSize()));
+        }
+        void visitLink(Link& link) override {
+            visited.push_back("L " + link.getPath().string() + " -> " + link.getTarget().string());
+        }
+
+        std::vector<std::string> visited;
+    };
+
+    FileTable::Entry entry(const std::string& name, FileTable::Type type, std::uint64_t size = 0) {
+        FileTable::Entry e;
+        e.name = name;
+        e.type = type;
+        e.size = size;
+        return e;
+    }
+
+    /// root/{b.txt, a/{x.txt}, link -> b.txt}
+    FileTable sampleTable() {
+        FileTable table;
+        auto root = table.addRoot("root");
+        std::vector<FileTable::Entry> top {
+            entry("b.txt", FileTable::Type::File, 10),
+            entry("a", FileTable::Type::Directory),
+            entry("link", FileTable::Type::Link),
+        };
+        top[2].link_target = "b.txt";
+        auto first = table.addChildren(root, top);
+
+        std::vector<FileTable::Entry> inner { entry("x.txt", FileTable::Type::File, 5) };
+        table.addChildren(first, inner);
+        return table;
+    }
+}
+
+TEST_CASE("FileTable - Structure", "[FileTable]") {
+    FileTable table = sampleTable();
+
+    SECTION("Entries refer to their parents by index") {
+        REQUIRE(table.size() == 5);
+        REQUIRE(table.name(0) == "root");
+        REQUIRE(table.parent(0) == FileTable::NO_PARENT);
+        REQUIRE(table.childCount(0) == 3);
+    }
+
+    SECTION("Children are sorted by name") {
+        auto first = table.firstChild(0);
+        REQUIRE(table.name(first) == "a");
+        REQUIRE(table.name(first + 1) == "b.txt");
+        REQUIRE(table.name(first + 2) == "link");
+        REQUIRE(table.type(first) == FileTable::Type::Directory);
+        REQUIRE(table.linkTarget(first + 2) == "b.txt");
+    }
+
+    SECTION("Paths and sizes") {
+        auto a = table.firstChild(0);
+        auto x = table.firstChild(a);
+        REQUIRE(table.path(x) == std::filesystem::path("root") / "a" / "x.txt");
+        REQUIRE(table.fileSize(x) == 5);
+        REQUIRE(table.totalSize() == 15);
+    }
+
+    SECTION("Children of a directory are added once") {
+        std::vector<FileTable::Entry> again { entry("y.txt", FileTable::Type::File) };
+        REQUIRE_THROWS_AS(table.addChildren(0, again), std::logic_error);
+        auto b = table.firstChild(0) + 1;
+        REQUIRE_THROWS_AS(table.addChildren(b, again), std::logic_error);
+    }
+
+    SECTION("A table has one root") {
+        REQUIRE_THROWS_AS(table.addRoot("other"), std::logic_error);
+    }
+}
+
+TEST_CASE("FileTable - Name interning", "[FileTable]") {
+    FileTable table;
+    auto root = table.addRoot("root");
+    std::vector<FileTable::Entry> dirs;
+    for (int i = 0; i < 100; ++i) {
+        dirs.push_back(entry("dir" + std::to_string(i), FileTable::Type::Directory));
+    }
+    auto first = table.addChildren(root, dirs);
+    table.shrink();
+    std::size_t before = table.memoryUsage();
+
+    // The same name in every directory but the last is stored once
+    for (FileTable::Index i = 0; i < 99; ++i) {
+        std::vector<FileTable::Entry> files { entry("index.js", FileTable::Type::File, 1) };
+        table.addChildren(first + i, files);
+    }
+    table.shrink();
+
+    REQUIRE(table.size() == 200);
+    REQUIRE(table.name(table.firstChild(first + 42)) == "index.js");
+    REQUIRE(table.name(table.firstChild(first + 42)).data() == table.name(table.firstChild(first)).data());
+    // Far less than one heap object per entry
+    REQUIRE(table.memoryUsage() - before < 99 * 48);
+
+    SECTION("Interning keeps working after shrink and move") {
+        FileTable moved = std::move(table);
+        std::vector<FileTable::Entry> files { entry("index.js", FileTable::Type::File, 1) };
+        auto file = moved.addChildren(first + 99, files);
+        REQUIRE(moved.name(file).data() == moved.name(moved.firstChild(first)).data());
+    }
+}
+
+TEST_CASE("FileTable - Visiting", "[FileTable]") {
+    FileTable table = sampleTable();
+    PathRecorder recorder;
+    table.accept(recorder);
+
+    std::vector<std::string> expected {
+        "D root",
+        "D root/a",
+        "F root/a/x.txt 5",
+        "F root/b.txt 10",
+        "L root/link -> b.txt",
+    };
+    REQUIRE(recorder.visited == expected);
+}
@@ -368,6 +368,22 @@ TEST_CASE("Link memory and resource management", "[Link]") {
         
         REQUIRE(link.getOwner() == root_dir.get());
     }
+
+    SECTION("Shared target outlived by the link sharing it") {
+        Directory root_dir("root");
+        auto owner = std::make_unique<Link>("owner", "target", &root_dir);
+        auto sharer = std::make_unique<Link>("sharer", "target", &root_dir);
+        owner->setResolveTarget(std::make_unique<Directory>("owner", owner.get()));
+        sharer->shareResolvedTarget(*owner);
+        Link* sharer_link = sharer.get();
+        root_dir.add(std::move(owner));
+        root_dir.add(std::move(sharer));
+        REQUIRE(sharer_link->getResolvedTarget() != nullptr);
+
+        REQUIRE(root_dir.remove("owner"));
+        REQUIRE(sharer_link->getResolvedTarget() == nullptr);
+        REQUIRE(sharer_link->getSize() == 0);
+    }
 }
 
 TEST_CASE("Link integration with directory operations", "[Link]") {
@@ -0,0 +1,274 @@
+#include "hashing-engine/HashEngine.hpp"
+#include "hashing-engine/CacheFirstStrategy.hpp"
+#include "hashing-engine/LargestFirstStrategy.hpp"
+#include "calculators/ChecksumCalculator.hpp"
+#include "progress-indicator-observers/Observer.hpp"
+#include "progress-indicator-observers/Message.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include "file-system-composite/Link.hpp"
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    class MockCalculator : public ChecksumCalculator {
+    public:
+        std::string calculate(const std::string& data) noexcept override {
+            return "mock_hash_" + std::to_string(data.length());
+        }
+
+        std::string getAlgorithmName() const noexcept override { return "mock"; }
+    };
+
+    class CountingCalculator : public ChecksumCalculator {
+    public:
+        explicit CountingCalculator(std::atomic<int>& calls) : _calls(calls) {}
+
+        std::string calculate(const std::string& data) noexcept override {
+            ++_calls;
+            return "mock_hash_" + std::to_string(data.length());
+        }
+
+        std::string getAlgorithmName() const noexcept override { return "mock"; }
+    private:
+        std::atomic<int>& _calls;
+    };
+
+    class CountingObserver : public Observer {
+    public:
+        void update(Observable&, const Message& m) override {
+            if (m.type == Message::Type::NewFile) ++new_files;
+        }
+        int new_files = 0;
+    };
+
+    class HashEngineTestMockup {
+    public:
+        const std::filesystem::path base_path;
+
+        HashEngineTestMockup()
+            : base_path(std::filesystem::temp_directory_path() / "hash_engine_test")
+        {
+            std::filesystem::remove_all(base_path);
+            std::filesystem::create_directories(base_path / "sub");
+            for (int i = 0; i < 20; ++i) {
+                std::ofstream(base_path / ("file" + std::to_string(i) + ".txt")) << std::string(i, 'x');
+            }
+            std::ofstream(base_path / "sub" / "nested.txt") << "nested";
+        }
+
+        ~HashEngineTestMockup() {
+            std::filesystem::remove_all(base_path);
+        }
+
+        HashEngineTestMockup(const HashEngineTestMockup&) = delete;
+        HashEngineTestMockup& operator=(const HashEngineTestMockup&) = delete;
+    };
+
+    static HashEngineTestMockup test_mockup;
+
+    HashEngine::CalculatorMaker mockMaker() {
+        return []() { return std::make_unique<MockCalculator>(); };
+    }
+
+    std::unique_ptr<Directory> buildTree() {
+        auto root = std::make_unique<Directory>(test_mockup.base_path);
+        for (int i = 0; i < 20; ++i) {
+            root->createFile("file" + std::to_string(i) + ".txt");
+        }
+        root->createSubdirectory("sub")->createFile("nested.txt");
+        return root;
+    }
+
+    std::string sequentialManifest(Directory& root) {
+        std::ostringstream output;
+        HashStreamWriter writer(std::make_unique<MockCalculator>(), output);
+        root.accept(writer);
+        return output.str();
+    }
+}
+
+TEST_CASE("HashEngine - Constructor", "[HashEngine]") {
+    std::ostringstream output;
+
+    SECTION("Null calculator maker result throws") {
+        REQUIRE_THROWS_AS(HashEngine([]() { return std::unique_ptr<ChecksumCalculator>(); }, output, 2),
+                          std::runtime_error);
+    }
+}
+
+TEST_CASE("HashEngine - Manifest matches sequential hashing", "[HashEngine]") {
+    auto root = buildTree();
+    std::string expected = sequentialManifest(*root);
+
+    SECTION("Single worker") {
+        std::ostringstream output;
+        HashEngine engine(mockMaker(), output, 1);
+        engine.hash(*root);
+        REQUIRE(output.str() == expected);
+    }
+
+    SECTION("Several workers keep the original order") {
+        std::ostringstream output;
+        HashEngine engine(mockMaker(), output, 4);
+        engine.hash(*root);
+        REQUIRE(output.str() == expected);
+    }
+
+    SECTION("Cache-first dispatch keeps the original order") {
+        std::ostringstream output;
+        HashEngine engine(mockMaker(), output, 3, std::make_unique<CacheFirstStrategy>());
+        engine.hash(*root);
+        REQUIRE(output.str() == expected);
+    }
+
+    SECTION("Largest-first dispatch keeps the original order") {
+        std::ostringstream output;
+        HashEngine engine(mockMaker(), output, 3, std::make_unique<LargestFirstStrategy>());
+        engine.hash(*root);
+        REQUIRE(output.str() == expected);
+    }
+
+    SECTION("Small files of known size are hashed in batches, in the original order") {
+        root->getSize();
+        std::ostringstream output;
+        CountingObserver observer;
+        HashEngine engine(mockMaker(), output, 2);
+        engine.attach(&observer);
+        engine.hash(*root);
+        REQUIRE(output.str() == expected);
+        REQUIRE(observer.new_files == 21);
+    }
+
+    SECTION("Observers are notified once per file") {
+        std::ostringstream output;
+        CountingObserver observer;
+        HashEngine engine(mockMaker(), output, 4);
+        engine.attach(&observer);
+        engine.hash(*root);
+        REQUIRE(observer.new_files == 21);
+    }
+}
+
+TEST_CASE("HashEngine - Read errors", "[HashEngine]") {
+    Directory root(test_mockup.base_path);
+    root.createFile("file1.txt");
+    root.createFile("file2_missing.txt");
+    root.createFile("file3.txt");
+    // With known sizes the readable files are small enough to be batched
+    if (GENERATE(false, true)) {
+        root.getSize();
+    }
+
+    std::ostringstream output;
+    HashEngine engine(mockMaker(), output, 2);
+
+    REQUIRE_THROWS_AS(engine.hash(root), std::ios_base::failure);
+    // Lines before the failing file are still written
+    REQUIRE(output.str().find("file1.txt") != std::string::npos);
+    REQUIRE(output.str().find("file3.txt") == std::string::npos);
+}
+
+TEST_CASE("HashEngine - Several roots", "[HashEngine]") {
+    auto first = buildTree();
+    auto second = std::make_unique<Directory>(test_mockup.base_path / "sub");
+    second->createFile("nested.txt");
+    std::string expected = sequentialManifest(*first) + sequentialManifest(*second);
+
+    std::ostringstream output;
+    HashEngine engine(mockMaker(), output, 4);
+    engine.hash(std::vector<FileObject*>{first.get(), second.get()});
+
+    // One pool for all roots, lines grouped by root
+    REQUIRE(output.str() == expected);
+}
+
+TEST_CASE("HashEngine - Hard links", "[HashEngine]") {
+    auto dir = test_mockup.base_path / "hard_links";
+    std::filesystem::create_directories(dir);
+    for (int i = 0; i < 4; ++i) {
+        std::string name = "data" + std::to_string(i) + ".txt";
+        std::ofstream(dir / name) << std::string(i + 1, 'x');
+        for (int copy = 0; copy < 3; ++copy) {
+            std::filesystem::create_hard_link(dir / name, dir / ("copy" + std::to_string(copy) + "_" + name));
+        }
+    }
+
+    Directory root(dir);
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        root.createFile(entry.path().filename())->getSize();
+    }
+    std::string expected = sequentialManifest(root);
+
+    std::atomic<int> calls{0};
+    std::ostringstream output;
+    HashEngine engine([&calls]() { return std::make_unique<CountingCalculator>(calls); }, output, 3);
+    engine.hash(root);
+
+    REQUIRE(calls == 4);
+    REQUIRE(output.str() == expected);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("HashEngine - Hard links further apart than a write batch", "[HashEngine]") {
+    auto dir = test_mockup.base_path / "distant_links";
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "a.txt") << "shared";
+    for (int i = 0; i < 150; ++i) {
+        std::ofstream(dir / ("f" + std::to_string(100 + i) + ".txt")) << std::string(i % 7, 'x');
+    }
+    std::filesystem::create_hard_link(dir / "a.txt", dir / "z.txt");
+
+    Directory root(dir);
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        root.createFile(entry.path().filename())->getSize();
+    }
+    std::string expected = sequentialManifest(root);
+
+    std::atomic<int> calls{0};
+    std::ostringstream output;
+    HashEngine engine([&calls]() { return std::make_unique<CountingCalculator>(calls); }, output, 3);
+    engine.hash(root);
+
+    // The last name of the inode still gets the checksum hashed for the first
+    REQUIRE(calls == 151);
+    REQUIRE(output.str() == expected);
+    REQUIRE(expected.find("mock_hash_6 " + (dir / "z.txt").string()) != std::string::npos);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("HashEngine - Shared link targets", "[HashEngine]") {
+    auto dir = test_mockup.base_path / "shared_links";
+    std::filesystem::create_directories(dir / "data");
+    std::ofstream(dir / "data" / "x.txt") << "x";
+    std::filesystem::create_directory_symlink(dir / "data", dir / "l1");
+    std::filesystem::create_directory_symlink(dir / "data", dir / "l2");
+
+    Directory root(dir);
+    auto owner = std::make_unique<Link>("l1", dir / "data", &root);
+    auto target = std::make_unique<Directory>("data", owner.get());
+    target->createFile("x.txt");
+    owner->setResolveTarget(std::move(target));
+    auto sharer = std::make_unique<Link>("l2", dir / "data", &root);
+    sharer->shareResolvedTarget(*owner);
+    root.add(std::move(owner));
+    root.add(std::move(sharer));
+    std::string expected = sequentialManifest(root);
+
+    std::atomic<int> calls{0};
+    std::ostringstream output;
+    HashEngine engine([&calls]() { return std::make_unique<CountingCalculator>(calls); }, output, 2);
+    engine.hash(root);
+
+    REQUIRE(calls == 1);
+    REQUIRE(output.str() == expected);
+    REQUIRE(expected.find((dir / "l2" / "x.txt").string()) != std::string::npos);
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,87 @@
+#include "hashing-engine/ReadAheadPrefetcher.hpp"
+#include "progress-indicator-observers/Message.hpp"
+#include "progress-indicator-observers/Observable.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+    class PrefetcherTestMockup {
+    public:
+        const std::filesystem::path base_path;
+
+        PrefetcherTestMockup()
+            : base_path(std::filesystem::temp_directory_path() / "read_ahead_prefetcher_test")
+        {
+            std::filesystem::remove_all(base_path);
+            std::filesystem::create_directories(base_path);
+            for (int i = 0; i < 10; ++i) {
+                std::ofstream(base_path / ("file" + std::to_string(i) + ".txt")) << "content " << i;
+            }
+        }
+
+        ~PrefetcherTestMockup() {
+            std::filesystem::remove_all(base_path);
+        }
+
+        PrefetcherTestMockup(const PrefetcherTestMockup&) = delete;
+        PrefetcherTestMockup& operator=(const PrefetcherTestMockup&) = delete;
+    };
+
+    static PrefetcherTestMockup test_mockup;
+
+    class DummySender : public Observable {};
+}
+
+TEST_CASE("ReadAheadPrefetcher - Window follows the hashing order", "[ReadAheadPrefetcher]") {
+    Directory root(test_mockup.base_path);
+    std::vector<File*> files;
+    for (int i = 0; i < 10; ++i) {
+        files.push_back(root.createFile("file" + std::to_string(i) + ".txt"));
+    }
+    DummySender sender;
+
+    SECTION("Start prefetches up to the maximum window") {
+        ReadAheadPrefetcher prefetcher(files, 4);
+        prefetcher.start();
+        REQUIRE(prefetcher.window() == 4);
+    }
+
+    SECTION("Window moves with each new file") {
+        ReadAheadPrefetcher prefetcher(files, 3);
+        prefetcher.start();
+
+        prefetcher.update(sender, NewFileMessage(files[0]->getPath().string()));
+        REQUIRE(prefetcher.window() == 3);
+
+        prefetcher.update(sender, BytesReadMessage(9));
+        prefetcher.update(sender, NewFileMessage(files[5]->getPath().string()));
+        REQUIRE(prefetcher.window() == 3);
+        REQUIRE(prefetcher.hashRate() >= 0.0);
+    }
+
+    SECTION("Window shrinks at the end of the list") {
+        ReadAheadPrefetcher prefetcher(files, 4);
+        prefetcher.start();
+        prefetcher.update(sender, NewFileMessage(files[8]->getPath().string()));
+        REQUIRE(prefetcher.window() == 1);
+        prefetcher.update(sender, NewFileMessage(files[9]->getPath().string()));
+        REQUIRE(prefetcher.window() == 0);
+    }
+
+    SECTION("Zero window disables prefetching") {
+        ReadAheadPrefetcher prefetcher(files, 0);
+        prefetcher.start();
+        prefetcher.update(sender, NewFileMessage(files[0]->getPath().string()));
+        REQUIRE(prefetcher.window() == 0);
+    }
+
+    SECTION("Unknown paths are ignored") {
+        ReadAheadPrefetcher prefetcher(files, 2);
+        prefetcher.start();
+        REQUIRE_NOTHROW(prefetcher.update(sender, NewFileMessage("not/in/the/list")));
+    }
+}
@@ -0,0 +1,108 @@
+#include "hashing-engine/SchedulingStrategyFactory.hpp"
+#include "hashing-engine/NameOrderStrategy.hpp"
+#include "hashing-engine/CacheFirstStrategy.hpp"
+#include "hashing-engine/LargestFirstStrategy.hpp"
+#include "hashing-engine/PageCacheProbe.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    class StrategyTestMockup {
+    public:
+        const std::filesystem::path base_path;
+        const std::filesystem::path empty_file;
+        const std::filesystem::path data_file;
+
+        StrategyTestMockup()
+            : base_path(std::filesystem::temp_directory_path() / "scheduling_strategy_test")
+            , empty_file(base_path / "empty.txt")
+            , data_file(base_path / "data.txt")
+        {
+            std::filesystem::remove_all(base_path);
+            std::filesystem::create_directories(base_path);
+            std::ofstream empty(empty_file);
+            std::ofstream(data_file) << std::string(10000, 'd');
+        }
+
+        ~StrategyTestMockup() {
+            std::filesystem::remove_all(base_path);
+        }
+
+        StrategyTestMockup(const StrategyTestMockup&) = delete;
+        StrategyTestMockup& operator=(const StrategyTestMockup&) = delete;
+    };
+
+    static StrategyTestMockup test_mockup;
+}
+
+TEST_CASE("SchedulingStrategyFactory - create", "[SchedulingStrategy]") {
+    REQUIRE(SchedulingStrategyFactory::create("name")->getName() == "name");
+    REQUIRE(SchedulingStrategyFactory::create("cache-first")->getName() == "cache-first");
+    REQUIRE(SchedulingStrategyFactory::create("largest-first")->getName() == "largest-first");
+    REQUIRE(SchedulingStrategyFactory::create("unknown") == nullptr);
+}
+
+TEST_CASE("PageCacheProbe - residency", "[PageCacheProbe]") {
+    REQUIRE(PageCacheProbe::residency(test_mockup.empty_file) == 1.0);
+    REQUIRE(PageCacheProbe::residency(test_mockup.base_path / "missing.txt") == 0.0);
+
+    double fraction = PageCacheProbe::residency(test_mockup.data_file);
+    REQUIRE(fraction >= 0.0);
+    REQUIRE(fraction <= 1.0);
+
+    // Files are probed through their pinned owner the same as by path
+    Directory root(test_mockup.base_path);
+    File* empty = root.createFile("empty.txt");
+    File* missing = root.createFile("missing.txt");
+    File* data = root.createFile("data.txt");
+    Directory::Pin pin(root);
+    REQUIRE(PageCacheProbe::isCached(*empty));
+    REQUIRE_FALSE(PageCacheProbe::isCached(*missing));
+    REQUIRE(PageCacheProbe::isCached(*data) == (PageCacheProbe::residency(test_mockup.data_file) >= 1.0));
+}
+
+TEST_CASE("Scheduling strategies - plan", "[SchedulingStrategy]") {
+    Directory root(test_mockup.base_path);
+    File* missing = root.createFile("missing.txt");
+    File* empty = root.createFile("empty.txt");
+
+    std::vector<HashJob> jobs = {
+        HashJob{missing, 0, HashJob::Stage::Cpu},
+        HashJob{empty, 1, HashJob::Stage::Cpu},
+    };
+
+    SECTION("Name order keeps the order and uses the I/O stage") {
+        NameOrderStrategy strategy;
+        strategy.plan(jobs);
+        REQUIRE(jobs[0].index == 0);
+        REQUIRE(jobs[1].index == 1);
+        REQUIRE(jobs[0].stage == HashJob::Stage::Io);
+        REQUIRE(jobs[1].stage == HashJob::Stage::Io);
+    }
+
+    SECTION("Cache-first leaves the probing to the workers, in order") {
+        CacheFirstStrategy strategy;
+        strategy.plan(jobs);
+        REQUIRE(jobs[0].file == missing);
+        REQUIRE(jobs[1].file == empty);
+        REQUIRE(jobs[0].stage == HashJob::Stage::Probe);
+        REQUIRE(jobs[1].stage == HashJob::Stage::Probe);
+    }
+
+    SECTION("Largest-first moves large files to the front, keeping the order of equal sizes") {
+        File* data = root.createFile("data.txt");
+        jobs.push_back(HashJob{data, 2, HashJob::Stage::Cpu});
+
+        LargestFirstStrategy strategy;
+        strategy.plan(jobs);
+        REQUIRE(jobs[0].file == data);
+        REQUIRE(jobs[1].file == missing);
+        REQUIRE(jobs[2].file == empty);
+        for (const auto& job : jobs) {
+            REQUIRE(job.stage == HashJob::Stage::Io);
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#include "hashing-engine/StreamingHasher.hpp"
+#include "directory-tree-builders/DirectoryConstructor.hpp"
+#include "directory-tree-builders/NonFollowLinkBuilder.hpp"
+#include "calculators/ChecksumCalculator.hpp"
+#include "progress-indicator-observers/Observer.hpp"
+#include "progress-indicator-observers/Message.hpp"
+#include "file-system-composite/Directory.hpp"
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    class MockCalculator : public ChecksumCalculator {
+    public:
+        std::string calculate(const std::string& data) noexcept override {
+            return "mock_hash_" + std::to_string(data.length());
+        }
+
+        std::string getAlgorithmName() const noexcept override { return "mock"; }
+    };
+
+    class CountingObserver : public Observer {
+    public:
+        void update(Observable&, const Message& m) override {
+            if (m.type == Message::Type::NewFile) ++new_files;
+        }
+        int new_files = 0;
+    };
+
+    class StreamingHasherTestMockup {
+    public:
+        const std::filesystem::path base_path;
+
+        StreamingHasherTestMockup()
+            : base_path(std::filesystem::temp_directory_path() / "streaming_hasher_test")
+        {
+            std::filesystem::remove_all(base_path);
+            for (int d = 0; d < 5; ++d) {
+                auto dir = base_path / ("dir" + std::to_string(d)) / "inner";
+                std::filesystem::create_directories(dir);
+                for (int i = 0; i < 10; ++i) {
+                    std::ofstream(dir / ("file" + std::to_string(i) + ".txt")) << std::string(d * i, 'x');
+                }
+            }
+            std::ofstream(base_path / "top.txt") << "top";
+            std::filesystem::create_symlink("top.txt", base_path / "link");
+        }
+
+        ~StreamingHasherTestMockup() {
+            std::filesystem::remove_all(base_path);
+        }
+
+        StreamingHasherTestMockup(const StreamingHasherTestMockup&) = delete;
+        StreamingHasherTestMockup& operator=(const StreamingHasherTestMockup&) = delete;
+    };
+
+    static StreamingHasherTestMockup test_mockup;
+
+    StreamingHasher::CalculatorMaker mockMaker() {
+        return []() { return std::make_unique<MockCalculator>(); };
+    }
+
+    std::string builtTreeManifest(const std::filesystem::path& root) {
+        NonFollowLinkBuilder builder;
+        DirectoryConstructor constructor(builder);
+        constructor.construct({root});
+
+        std::ostringstream output;
+        HashStreamWriter writer(std::make_unique<MockCalculator>(), output);
+        builder.getTree()->accept(writer);
+        return output.str();
+    }
+}
+
+TEST_CASE("StreamingHasher - Constructor", "[StreamingHasher]") {
+    std::ostringstream output;
+
+    SECTION("Null calculator maker result throws") {
+        REQUIRE_THROWS_AS(StreamingHasher([]() { return std::unique_ptr<ChecksumCalculator>(); }, output),
+                          std::runtime_error);
+    }
+}
+
+TEST_CASE("StreamingHasher - Manifest matches hashing a built tree", "[StreamingHasher]") {
+    std::string expected = builtTreeManifest(test_mockup.base_path);
+    REQUIRE_FALSE(expected.empty());
+
+    SECTION("Single worker") {
+        std::ostringstream output;
+        StreamingHasher hasher(mockMaker(), output);
+        hasher.hash(test_mockup.base_path);
+        REQUIRE(output.str() == expected);
+    }
+
+    SECTION("Several workers and a small window") {
+        std::ostringstream output;
+        StreamingHasher hasher(mockMaker(), output, 4, 3);
+        hasher.hash(test_mockup.base_path);
+        REQUIRE(output.str() == expected);
+    }
+
+    SECTION("Observers are notified once per file") {
+        std::ostringstream output;
+        CountingObserver observer;
+        StreamingHasher hasher(mockMaker(), output, 2);
+        hasher.attach(&observer);
+        hasher.hash(test_mockup.base_path);
+        REQUIRE(observer.new_files == 51);
+    }
+}
+
+TEST_CASE("StreamingHasher - Single file and missing paths", "[StreamingHasher]") {
+    std::ostringstream output;
+    StreamingHasher hasher(mockMaker(), output);
+
+    SECTION("A file root is hashed alone") {
+        hasher.hash(test_mockup.base_path / "top.txt");
+        REQUIRE(output.str() == "mock mock_hash_3 " + (test_mockup.base_path / "top.txt").string() + "\n");
+    }
+
+    SECTION("A missing root writes nothing") {
+        hasher.hash(test_mockup.base_path / "missing");
+        REQUIRE(output.str().empty());
+    }
+}
+
+TEST_CASE("StreamingHasher - File lists", "[StreamingHasher]") {
+    auto inner = test_mockup.base_path / "dir2" / "inner";
+    auto a = inner / "file1.txt";
+    auto b = inner / "file3.txt";
+    auto c = test_mockup.base_path / "top.txt";
+    std::string expected =
+        "mock mock_hash_2 " + a.string() + "\n" +
+        "mock mock_hash_6 " + b.string() + "\n" +
+        "mock mock_hash_3 " + c.string() + "\n";
+
+    SECTION("Newline separated, in list order") {
+        std::istringstream list(a.string() + "\n" + b.string() + "\n\n" + c.string() + "\n");
+        std::ostringstream output;
+        StreamingHasher hasher(mockMaker(), output, 3, 2);
+        hasher.hashList(list);
+        REQUIRE(output.str() == expected);
+    }
+
+    SECTION("NUL separated, without a final separator") {
+        std::string entries = a.string() + '\0' + b.string() + '\0' + c.string();
+        std::istringstream list(entries);
+        std::ostringstream output;
+        StreamingHasher hasher(mockMaker(), output, 2);
+        hasher.hashList(list);
+        REQUIRE(output.str() == expected);
+    }
+
+    SECTION("Paths listed more than once get a line each time") {
+        std::istringstream list(a.string() + "\n" + b.string() + "\n" + a.string() + "\n" + a.string() + "\n");
+        std::ostringstream output;
+        StreamingHasher hasher(mockMaker(), output, 2);
+        hasher.hashList(list);
+        std::string line_a = "mock mock_hash_2 " + a.string() + "\n";
+        REQUIRE(output.str() == line_a + "mock mock_hash_6 " + b.string() + "\n" + line_a + line_a);
+    }
+
+    SECTION("Entries that are not regular files are skipped") {
+        std::istringstream list((test_mockup.base_path / "missing.txt").string() + "\n" +
+                                inner.string() + "\n" + a.string() + "\n");
+        std::ostringstream output;
+        StreamingHasher hasher(mockMaker(), output);
+        hasher.hashList(list);
+        REQUIRE(output.str() == "mock mock_hash_2 " + a.string() + "\n");
+    }
+
+    SECTION("Empty list") {
+        std::istringstream list;
+        std::ostringstream output;
+        StreamingHasher hasher(mockMaker(), output);
+        hasher.hashList(list);
+        REQUIRE(output.str().empty());
+    }
+}
@@ -2,6 +2,7 @@
 #include <catch2/catch_all.hpp>
 #include <filesystem>
 #include <fstream>
+#include <vector>
 
 namespace {
     /**
@@ -203,4 +204,47 @@ TEST_CASE("CycleDetector - Independent detector instances", "[CycleDetector]") {
         REQUIRE_FALSE(detector2.check(testPath)); // First visit for detector2
         REQUIRE(detector2.check(testPath)); // Second visit for detector2 should detect cycle
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("CycleDetector - Identity set", "[CycleDetector]") {
+    CycleDetector detector;
+
+    SECTION("Identities are device and inode of the resolved target") {
+        auto dir = CycleDetector::identify(testMockup.dir2);
+        auto through_link = CycleDetector::identify(testMockup.linkToDir2);
+        REQUIRE(dir);
+        REQUIRE(through_link);
+        REQUIRE(*dir == *through_link);
+        REQUIRE(*CycleDetector::identify(testMockup.dir1) != *dir);
+        REQUIRE_FALSE(CycleDetector::identify(testMockup.basePath / "non_existent_path_12345"));
+    }
+
+    SECTION("Entered identities can be left again") {
+        FileId id{1, 42};
+        REQUIRE(detector.enter(id));
+        REQUIRE_FALSE(detector.enter(id));
+        REQUIRE(detector.contains(id));
+
+        detector.leave(id);
+        REQUIRE_FALSE(detector.contains(id));
+        REQUIRE(detector.size() == 0);
+        REQUIRE(detector.enter(id));
+    }
+
+    SECTION("Lookups stay correct while the set grows and shrinks") {
+        std::vector<FileId> ids;
+        for (std::uint64_t i = 1; i <= 1000; ++i) {
+            ids.push_back(FileId{i % 3, i * 7});
+            REQUIRE(detector.enter(ids.back()));
+        }
+        REQUIRE(detector.size() == 1000);
+
+        for (std::size_t i = 0; i < ids.size(); i += 2) {
+            detector.leave(ids[i]);
+        }
+        REQUIRE(detector.size() == 500);
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            REQUIRE(detector.contains(ids[i]) == (i % 2 == 1));
+        }
+    }
+}
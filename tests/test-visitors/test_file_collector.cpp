@@ -0,0 +1,39 @@
+#include "directory-iteration-visitors/FileCollector.hpp"
+#include "file-system-composite/Directory.hpp"
+#include "file-system-composite/File.hpp"
+#include "file-system-composite/Link.hpp"
+#include <catch2/catch_all.hpp>
+#include <memory>
+
+TEST_CASE("FileCollector - Collects files in visiting order", "[FileCollector]") {
+    Directory root("root");
+    File* a = root.createFile("a.txt");
+    Directory* sub = root.createSubdirectory("sub");
+    File* b = sub->createFile("b.txt");
+    File* c = root.createFile("c.txt");
+
+    FileCollector collector;
+    root.accept(collector);
+
+    const auto& files = collector.getFiles();
+    REQUIRE(files.size() == 3);
+    REQUIRE(files[0] == a);
+    REQUIRE(files[1] == c);
+    REQUIRE(files[2] == b);
+}
+
+TEST_CASE("FileCollector - Follows resolved links", "[FileCollector]") {
+    Directory root("root");
+    auto link = std::make_unique<Link>("link", "target.txt", &root);
+    auto target = std::make_unique<File>("target.txt", link.get());
+    File* target_ptr = target.get();
+    link->setResolveTarget(std::move(target));
+    root.add(std::move(link));
+    root.add(std::make_unique<Link>("broken", "missing.txt", &root));
+
+    FileCollector collector;
+    root.accept(collector);
+
+    REQUIRE(collector.getFiles().size() == 1);
+    REQUIRE(collector.getFiles()[0] == target_ptr);
+}
@@ -1,5 +1,6 @@
 #include "directory-iteration-visitors/HashStreamWriter.hpp"
 #include "calculators/ChecksumCalculator.hpp"
+#include "calculators/SHA256Calculator.hpp"
 #include "file-system-composite/Directory.hpp"
 #include "file-system-composite/File.hpp"
 #include "file-system-composite/Link.hpp"
@@ -22,6 +23,20 @@ namespace {
         std::string getAlgorithmName() const noexcept override { return "mock"; }
     };
 
+    class CountingCalculator : public ChecksumCalculator {
+    public:
+        explicit CountingCalculator(int& calls) : _calls(calls) {}
+
+        std::string calculate(const std::string& data) noexcept override {
+            ++_calls;
+            return "hash_of_" + data;
+        }
+
+        std::string getAlgorithmName() const noexcept override { return "mock"; }
+    private:
+        int& _calls;
+    };
+
     class HashWriterTestMockup {
     public:
         const std::filesystem::path base_path;
@@ -253,3 +268,107 @@ TEST_CASE("HashStreamWriter - Integration with real-like calculator", "[HashStre
         REQUIRE(line.find(test_mockup.test_file2.string()) != std::string::npos);
     }
 }
+
+TEST_CASE("HashStreamWriter - Hard links", "[HashStreamWriter]") {
+    auto dir = test_mockup.base_path / "hard_links";
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "a.txt") << "shared";
+    std::filesystem::create_hard_link(dir / "a.txt", dir / "b.txt");
+    std::filesystem::create_hard_link(dir / "a.txt", dir / "c.txt");
+    std::ofstream(dir / "d.txt") << "shared";
+
+    Directory root(dir);
+    for (const char* name : {"a.txt", "b.txt", "c.txt", "d.txt"}) {
+        root.createFile(name)->getSize();
+    }
+
+    int calls = 0;
+    std::ostringstream output;
+    HashStreamWriter writer(std::make_unique<CountingCalculator>(calls), output);
+    root.accept(writer);
+
+    SECTION("Each inode is hashed once") {
+        // a, b and c share an inode; d only has the same contents
+        REQUIRE(calls == 2);
+    }
+
+    SECTION("Every name still gets its line") {
+        std::string expected =
+            "mock hash_of_shared " + (dir / "a.txt").string() + "\n" +
+            "mock hash_of_shared " + (dir / "b.txt").string() + "\n" +
+            "mock hash_of_shared " + (dir / "c.txt").string() + "\n" +
+            "mock hash_of_shared " + (dir / "d.txt").string() + "\n";
+        REQUIRE(output.str() == expected);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("HashStreamWriter - Shared link targets", "[HashStreamWriter]") {
+    auto dir = test_mockup.base_path / "shared_links";
+    std::filesystem::create_directories(dir / "data");
+    std::ofstream(dir / "data" / "x.txt") << "x";
+    std::ofstream(dir / "data" / "y.txt") << "y";
+    std::filesystem::create_directory_symlink(dir / "data", dir / "l1");
+    std::filesystem::create_directory_symlink(dir / "data", dir / "l2");
+
+    // l2 owns the subtree, l1 shares it and is walked first
+    Directory root(dir);
+    auto owner = std::make_unique<Link>("l2", dir / "data", &root);
+    auto target = std::make_unique<Directory>("data", owner.get());
+    target->createFile("x.txt");
+    target->createFile("y.txt");
+    owner->setResolveTarget(std::move(target));
+    auto sharer = std::make_unique<Link>("l1", dir / "data", &root);
+    REQUIRE(sharer->shareResolvedTarget(*owner));
+    root.add(std::move(owner));
+    root.add(std::move(sharer));
+
+    int calls = 0;
+    std::ostringstream output;
+    HashStreamWriter writer(std::make_unique<CountingCalculator>(calls), output);
+    root.accept(writer);
+
+    SECTION("Each shared file is hashed once") {
+        REQUIRE(calls == 2);
+    }
+
+    SECTION("Lines are written under each link") {
+        std::string expected =
+            "mock hash_of_x " + (dir / "l1" / "x.txt").string() + "\n" +
+            "mock hash_of_y " + (dir / "l1" / "y.txt").string() + "\n" +
+            "mock hash_of_x " + (dir / "l2" / "x.txt").string() + "\n" +
+            "mock hash_of_y " + (dir / "l2" / "y.txt").string() + "\n";
+        REQUIRE(output.str() == expected);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("HashStreamWriter - Sparse files", "[HashStreamWriter]") {
+    auto dir = test_mockup.base_path / "sparse";
+    std::filesystem::create_directories(dir);
+    const std::size_t hole = 4 * 1024 * 1024;
+    {
+        std::ofstream out(dir / "disk.img", std::ios::binary);
+        out << "head";
+        out.seekp(static_cast<std::streamoff>(hole));
+        out << "middle";
+    }
+    std::filesystem::resize_file(dir / "disk.img", 2 * hole);
+
+    Directory root(dir);
+    root.createFile("disk.img");
+    std::ostringstream output;
+    HashStreamWriter writer(std::make_unique<SHA256Calculator>(), output);
+    root.accept(writer);
+
+    // The digest of the streamed holes is that of the dense contents
+    std::string dense(2 * hole, '\0');
+    dense.replace(0, 4, "head");
+    dense.replace(hole, 6, "middle");
+    std::string expected = SHA256Calculator().calculate(dense);
+    REQUIRE(output.str() == "sha256 " + expected + " " + (dir / "disk.img").string() + "\n");
+
+    std::filesystem::remove_all(dir);
+}